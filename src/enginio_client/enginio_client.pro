@@ -12,18 +12,29 @@ OTHER_FILES += \
 include(../src.pri)
 
 SOURCES += \
+    enginioaggregatemodel.cpp \
     enginiobackendconnection.cpp \
     enginioclient.cpp \
     enginioreply.cpp \
     enginiomodel.cpp \
+    enginiomodeldiff.cpp \
+    enginionotification.cpp \
+    enginionotificationhub.cpp \
+    enginiopreparedquery.cpp \
+    enginiorequesttiming.cpp \
     enginioidentity.cpp \
     enginiofakereply.cpp \
     enginiodummyreply.cpp \
+    enginiosharedreply.cpp \
+    enginiopropertyindex.cpp \
+    enginioquerymatcher.cpp \
+    enginiosortorder.cpp \
     enginiostring.cpp
 
 HEADERS += \
     chunkdevice_p.h \
     enginio.h \
+    enginioaggregatemodel.h \
     enginiobackendconnection_p.h \
     enginiobasemodel.h \
     enginiobasemodel_p.h \
@@ -32,11 +43,23 @@ HEADERS += \
     enginioclient_p.h \
     enginioreply.h \
     enginiomodel.h \
+    enginiomodeldiff_p.h \
+    enginionotification_p.h \
+    enginionotificationhub_p.h \
+    enginiopreparedquery.h \
+    enginiopreparedquery_p.h \
     enginioidentity.h \
     enginioobjectadaptor_p.h \
+    enginioobjectproperties_p.h \
     enginioreply_p.h \
+    enginiorequestlog_p.h \
+    enginiorequesttiming_p.h \
     enginiofakereply_p.h \
     enginiodummyreply_p.h \
+    enginiosharedreply_p.h \
+    enginiopropertyindex_p.h \
+    enginioquerymatcher_p.h \
+    enginiosortorder_p.h \
     enginiostring_p.h \
     enginioclientconnection.h \
     enginiooauth2authentication.h \
@@ -44,4 +67,15 @@ HEADERS += \
 
 DEFINES +=  "ENGINIO_VERSION=\\\"$$MODULE_VERSION\\\""
 
+# Notification messages may be compressed with permessage-deflate.
+contains(QT_CONFIG, system-zlib) {
+    if(unix|mingw): LIBS_PRIVATE += -lz
+    else: LIBS += zdll.lib
+} else {
+    git_build: \
+        INCLUDEPATH += $$[QT_INSTALL_HEADERS/get]/QtZlib
+    else: \
+        INCLUDEPATH += $$[QT_INSTALL_HEADERS/src]/QtZlib
+}
+
 load(qt_module)
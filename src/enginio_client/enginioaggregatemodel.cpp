@@ -0,0 +1,544 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/enginioaggregatemodel.h>
+#include <Enginio/private/enginiopropertyindex_p.h>
+
+#include <QtCore/qjsonvalue.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qvector.h>
+#include <QtCore/private/qabstractitemmodel_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+  \class EnginioAggregateModel
+  \since 1.8
+  \inmodule enginio-qt
+  \ingroup enginio-client
+  \target EnginioAggregateModelCpp
+  \brief Groups the rows of a model and keeps the count, sum, minimum and maximum of each group.
+
+  EnginioAggregateModel has a row for each distinct value of the \l groupRole
+  property in the rows of its \l sourceModel, for example an EnginioModel.
+  The roles of the rows are:
+  \list
+    \li \c group the value of the \l groupRole property of the group
+    \li \c count the number of source rows in the group
+    \li \c sum the sum of the numeric \l valueRole properties in the group
+    \li \c minimum and \c maximum the smallest and largest of them
+  \endlist
+
+  The model does not go through all source rows when the source model
+  changes. Inserted, removed and changed rows only update the groups
+  they belong to, a change costs at most a logarithmic number of steps
+  in the size of its group. Only a reset of the source model recomputes
+  all groups.
+
+  Groups are added at the end, in the order their first row appears,
+  and removed as soon as they are empty.
+*/
+
+/*!
+  \enum EnginioAggregateModel::Role
+  \value GroupRole The value the rows of the group have in common
+  \value CountRole The number of rows in the group
+  \value SumRole The sum of the numeric values of the group
+  \value MinimumRole The smallest numeric value of the group
+  \value MaximumRole The largest numeric value of the group
+*/
+
+/*!
+  \fn EnginioAggregateModel::sourceModelChanged(QAbstractItemModel *model)
+  \brief The signal is emitted when the source model changed to \a model.
+*/
+
+/*!
+  \fn EnginioAggregateModel::groupRoleChanged(const QString &role)
+  \brief The signal is emitted when the group role changed to \a role.
+*/
+
+/*!
+  \fn EnginioAggregateModel::valueRoleChanged(const QString &role)
+  \brief The signal is emitted when the value role changed to \a role.
+*/
+
+namespace {
+
+QJsonValue jsonValue(const QVariant &value)
+{
+    if (value.userType() == QMetaType::QJsonValue)
+        return value.toJsonValue();
+    return QJsonValue::fromVariant(value);
+}
+
+} // namespace
+
+class EnginioAggregateModelPrivate : public QAbstractItemModelPrivate
+{
+    Q_DECLARE_PUBLIC(EnginioAggregateModel)
+
+public:
+    struct Group
+    {
+        QVariant value; // as the source model returns it
+        int count;
+        double sum;
+        // The numeric values in the group and how often they occur
+        QMap<double, int> values;
+    };
+
+    // What a source row added to its group, to take it back when the row
+    // changes or goes away.
+    struct Contribution
+    {
+        QString group;
+        double value;
+        bool hasValue;
+    };
+
+    const static int InvalidRole;
+
+    QPointer<QAbstractItemModel> _sourceModel;
+    QVector<QMetaObject::Connection> _sourceConnections;
+    QString _groupRoleName;
+    QString _valueRoleName;
+    int _groupRole;
+    int _valueRole;
+    // The contribution of each source row, by source row
+    QVector<Contribution> _rows;
+    QVector<Group> _groups;
+    QHash<QString, int> _groupRows;
+
+    EnginioAggregateModelPrivate()
+        : _groupRole(InvalidRole)
+        , _valueRole(InvalidRole)
+    {}
+
+    struct RowsInserted
+    {
+        EnginioAggregateModelPrivate *model;
+        void operator ()(const QModelIndex &parent, int first, int last)
+        {
+            model->sourceRowsInserted(parent, first, last);
+        }
+    };
+
+    struct RowsRemoved
+    {
+        EnginioAggregateModelPrivate *model;
+        void operator ()(const QModelIndex &parent, int first, int last)
+        {
+            model->sourceRowsRemoved(parent, first, last);
+        }
+    };
+
+    struct RowsMoved
+    {
+        EnginioAggregateModelPrivate *model;
+        void operator ()(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row)
+        {
+            model->sourceRowsMoved(parent, first, last, destination, row);
+        }
+    };
+
+    struct DataChanged
+    {
+        EnginioAggregateModelPrivate *model;
+        void operator ()(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+        {
+            model->sourceDataChanged(topLeft, bottomRight, roles);
+        }
+    };
+
+    struct Reset
+    {
+        EnginioAggregateModelPrivate *model;
+        void operator ()()
+        {
+            model->reset();
+        }
+    };
+
+    void setSourceModel(QAbstractItemModel *sourceModel)
+    {
+        Q_Q(EnginioAggregateModel);
+        foreach (const QMetaObject::Connection &connection, _sourceConnections)
+            QObject::disconnect(connection);
+        _sourceConnections.clear();
+
+        _sourceModel = sourceModel;
+        if (sourceModel) {
+            RowsInserted rowsInserted = { this };
+            RowsRemoved rowsRemoved = { this };
+            RowsMoved rowsMoved = { this };
+            DataChanged dataChanged = { this };
+            Reset reset = { this };
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::rowsInserted, q, rowsInserted));
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::rowsRemoved, q, rowsRemoved));
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::rowsMoved, q, rowsMoved));
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::dataChanged, q, dataChanged));
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::modelReset, q, reset));
+            _sourceConnections.append(QObject::connect(sourceModel, &QAbstractItemModel::layoutChanged, q, reset));
+            _sourceConnections.append(QObject::connect(sourceModel, &QObject::destroyed, q, reset));
+        }
+        reset();
+    }
+
+    // The roles of an EnginioModel are known only once it has data
+    bool resolveRoles()
+    {
+        _groupRole = InvalidRole;
+        _valueRole = InvalidRole;
+        if (!_sourceModel)
+            return false;
+        const QHash<int, QByteArray> roleNames = _sourceModel->roleNames();
+        _groupRole = roleNames.key(_groupRoleName.toUtf8(), InvalidRole);
+        _valueRole = roleNames.key(_valueRoleName.toUtf8(), InvalidRole);
+        return _groupRole != InvalidRole;
+    }
+
+    void reset()
+    {
+        Q_Q(EnginioAggregateModel);
+        q->beginResetModel();
+        _rows.clear();
+        _groups.clear();
+        _groupRows.clear();
+        if (resolveRoles()) {
+            const int count = _sourceModel->rowCount();
+            _rows.reserve(count);
+            for (int row = 0; row < count; ++row) {
+                QVariant groupValue;
+                _rows.append(contribution(row, &groupValue));
+                add(_rows.last(), groupValue, false);
+            }
+        }
+        q->endResetModel();
+    }
+
+    // Returns true if the source rows are not tracked, a reset takes care
+    // of them once the roles can be resolved.
+    bool isUntracked()
+    {
+        if (_groupRole != InvalidRole)
+            return false;
+        if (_sourceModel && _sourceModel->roleNames().values().contains(_groupRoleName.toUtf8()))
+            reset();
+        return true;
+    }
+
+    Contribution contribution(int row, QVariant *groupValue) const
+    {
+        const QModelIndex index = _sourceModel->index(row, 0);
+        *groupValue = _sourceModel->data(index, _groupRole);
+        Contribution result;
+        result.group = EnginioPropertyIndex::key(jsonValue(*groupValue));
+        result.value = 0;
+        result.hasValue = false;
+        if (_valueRole != InvalidRole) {
+            const QJsonValue value = jsonValue(_sourceModel->data(index, _valueRole));
+            result.hasValue = value.isDouble();
+            result.value = value.toDouble();
+        }
+        return result;
+    }
+
+    void add(const Contribution &row, const QVariant &groupValue, bool notify)
+    {
+        Q_Q(EnginioAggregateModel);
+        QHash<QString, int>::const_iterator it = _groupRows.constFind(row.group);
+        int groupRow;
+        if (it == _groupRows.constEnd()) {
+            groupRow = _groups.count();
+            if (notify)
+                q->beginInsertRows(QModelIndex(), groupRow, groupRow);
+            Group group;
+            group.value = groupValue;
+            group.count = 1;
+            group.sum = row.hasValue ? row.value : 0;
+            if (row.hasValue)
+                group.values.insert(row.value, 1);
+            _groups.append(group);
+            _groupRows.insert(row.group, groupRow);
+            if (notify)
+                q->endInsertRows();
+            return;
+        }
+
+        groupRow = it.value();
+        Group &group = _groups[groupRow];
+        ++group.count;
+        if (row.hasValue) {
+            group.sum += row.value;
+            ++group.values[row.value];
+        }
+        if (notify)
+            emit q->dataChanged(q->index(groupRow), q->index(groupRow));
+    }
+
+    void subtract(const Contribution &row, bool notify)
+    {
+        Q_Q(EnginioAggregateModel);
+        const int groupRow = _groupRows.value(row.group, -1);
+        Q_ASSERT(groupRow >= 0);
+        Group &group = _groups[groupRow];
+        if (--group.count == 0) {
+            if (notify)
+                q->beginRemoveRows(QModelIndex(), groupRow, groupRow);
+            _groups.remove(groupRow);
+            _groupRows.remove(row.group);
+            for (QHash<QString, int>::iterator i = _groupRows.begin(); i != _groupRows.end(); ++i) {
+                if (i.value() > groupRow)
+                    --i.value();
+            }
+            if (notify)
+                q->endRemoveRows();
+            return;
+        }
+
+        if (row.hasValue) {
+            group.sum -= row.value;
+            QMap<double, int>::iterator value = group.values.find(row.value);
+            Q_ASSERT(value != group.values.end());
+            if (--value.value() == 0)
+                group.values.erase(value);
+        }
+        if (notify)
+            emit q->dataChanged(q->index(groupRow), q->index(groupRow));
+    }
+
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last)
+    {
+        if (parent.isValid() || isUntracked())
+            return;
+        QVector<QVariant> groupValues(last - first + 1);
+        QVector<Contribution> inserted;
+        inserted.reserve(last - first + 1);
+        for (int row = first; row <= last; ++row)
+            inserted.append(contribution(row, &groupValues[row - first]));
+        _rows.insert(first, inserted.count(), Contribution());
+        for (int i = 0; i < inserted.count(); ++i) {
+            _rows[first + i] = inserted.at(i);
+            add(inserted.at(i), groupValues.at(i), true);
+        }
+    }
+
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+    {
+        if (parent.isValid() || isUntracked())
+            return;
+        for (int row = first; row <= last; ++row)
+            subtract(_rows.at(row), true);
+        _rows.remove(first, last - first + 1);
+    }
+
+    void sourceRowsMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row)
+    {
+        // The groups do not change, only the source rows of the contributions
+        if (parent.isValid() || destination.isValid() || isUntracked())
+            return;
+        const int count = last - first + 1;
+        const QVector<Contribution> moved = _rows.mid(first, count);
+        _rows.remove(first, count);
+        const int target = row > first ? row - count : row;
+        _rows.insert(target, count, Contribution());
+        for (int i = 0; i < count; ++i)
+            _rows[target + i] = moved.at(i);
+    }
+
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+    {
+        if (topLeft.parent().isValid() || isUntracked())
+            return;
+        if (!roles.isEmpty() && !roles.contains(_groupRole) && !roles.contains(_valueRole))
+            return;
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            QVariant groupValue;
+            const Contribution changed = contribution(row, &groupValue);
+            Contribution &current = _rows[row];
+            if (changed.group == current.group && changed.hasValue == current.hasValue && changed.value == current.value)
+                continue;
+            subtract(current, true);
+            current = changed;
+            add(changed, groupValue, true);
+        }
+    }
+
+    QVariant data(int row, int role) const
+    {
+        const Group &group = _groups.at(row);
+        switch (role) {
+        case Qt::DisplayRole:
+        case EnginioAggregateModel::GroupRole:
+            return group.value;
+        case EnginioAggregateModel::CountRole:
+            return group.count;
+        case EnginioAggregateModel::SumRole:
+            return group.sum;
+        case EnginioAggregateModel::MinimumRole:
+            return group.values.isEmpty() ? QVariant() : QVariant(group.values.firstKey());
+        case EnginioAggregateModel::MaximumRole:
+            return group.values.isEmpty() ? QVariant() : QVariant(group.values.lastKey());
+        default:
+            break;
+        }
+        return QVariant();
+    }
+};
+
+const int EnginioAggregateModelPrivate::InvalidRole = -1;
+
+/*!
+  Constructs a new aggregate model with \a parent as QObject parent.
+*/
+EnginioAggregateModel::EnginioAggregateModel(QObject *parent)
+    : QAbstractListModel(*new EnginioAggregateModelPrivate, parent)
+{}
+
+/*!
+  Destroys the model.
+*/
+EnginioAggregateModel::~EnginioAggregateModel()
+{}
+
+/*!
+  \property EnginioAggregateModel::sourceModel
+  \brief The model whose rows are grouped.
+*/
+QAbstractItemModel *EnginioAggregateModel::sourceModel() const
+{
+    Q_D(const EnginioAggregateModel);
+    return d->_sourceModel;
+}
+
+void EnginioAggregateModel::setSourceModel(QAbstractItemModel *model)
+{
+    Q_D(EnginioAggregateModel);
+    if (model == d->_sourceModel)
+        return;
+    d->setSourceModel(model);
+    emit sourceModelChanged(model);
+}
+
+/*!
+  \property EnginioAggregateModel::groupRole
+  \brief The name of the source model role the rows are grouped by.
+
+  Rows with the same value of the role are in the same group. As long as
+  the source model has no role of this name the aggregate model is empty.
+
+  \sa QAbstractItemModel::roleNames()
+*/
+QString EnginioAggregateModel::groupRole() const
+{
+    Q_D(const EnginioAggregateModel);
+    return d->_groupRoleName;
+}
+
+void EnginioAggregateModel::setGroupRole(const QString &role)
+{
+    Q_D(EnginioAggregateModel);
+    if (role == d->_groupRoleName)
+        return;
+    d->_groupRoleName = role;
+    d->reset();
+    emit groupRoleChanged(role);
+}
+
+/*!
+  \property EnginioAggregateModel::valueRole
+  \brief The name of the source model role with the values to sum up.
+
+  Rows without a numeric value for the role are counted, but do not
+  contribute to the sum, minimum and maximum of their group.
+*/
+QString EnginioAggregateModel::valueRole() const
+{
+    Q_D(const EnginioAggregateModel);
+    return d->_valueRoleName;
+}
+
+void EnginioAggregateModel::setValueRole(const QString &role)
+{
+    Q_D(EnginioAggregateModel);
+    if (role == d->_valueRoleName)
+        return;
+    d->_valueRoleName = role;
+    d->reset();
+    emit valueRoleChanged(role);
+}
+
+/*!
+  \overload
+  Returns the aggregate \a role of the group at \a index.
+*/
+QVariant EnginioAggregateModel::data(const QModelIndex &index, int role) const
+{
+    Q_D(const EnginioAggregateModel);
+    if (!index.isValid() || index.row() < 0 || index.row() >= d->_groups.count())
+        return QVariant();
+    return d->data(index.row(), role);
+}
+
+/*!
+  \overload
+  \internal
+*/
+int EnginioAggregateModel::rowCount(const QModelIndex &parent) const
+{
+    Q_D(const EnginioAggregateModel);
+    if (parent.isValid())
+        return 0;
+    return d->_groups.count();
+}
+
+/*!
+  \overload
+  Returns the names of the roles, "group", "count", "sum", "minimum"
+  and "maximum".
+*/
+QHash<int, QByteArray> EnginioAggregateModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(GroupRole, QByteArrayLiteral("group"));
+    roles.insert(CountRole, QByteArrayLiteral("count"));
+    roles.insert(SumRole, QByteArrayLiteral("sum"));
+    roles.insert(MinimumRole, QByteArrayLiteral("minimum"));
+    roles.insert(MaximumRole, QByteArrayLiteral("maximum"));
+    return roles;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOAGGREGATEMODEL_H
+#define ENGINIOAGGREGATEMODEL_H
+
+#include <QtCore/qabstractitemmodel.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+class EnginioAggregateModelPrivate;
+class ENGINIOCLIENT_EXPORT EnginioAggregateModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QAbstractItemModel *sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+    Q_PROPERTY(QString groupRole READ groupRole WRITE setGroupRole NOTIFY groupRoleChanged)
+    Q_PROPERTY(QString valueRole READ valueRole WRITE setValueRole NOTIFY valueRoleChanged)
+
+public:
+    enum Role {
+        GroupRole = Qt::UserRole + 1,
+        CountRole,
+        SumRole,
+        MinimumRole,
+        MaximumRole
+    };
+    Q_ENUMS(Role)
+
+    explicit EnginioAggregateModel(QObject *parent = Q_NULLPTR);
+    ~EnginioAggregateModel();
+
+    QAbstractItemModel *sourceModel() const Q_REQUIRED_RESULT;
+    void setSourceModel(QAbstractItemModel *model);
+
+    QString groupRole() const Q_REQUIRED_RESULT;
+    void setGroupRole(const QString &role);
+
+    QString valueRole() const Q_REQUIRED_RESULT;
+    void setValueRole(const QString &role);
+
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void sourceModelChanged(QAbstractItemModel *model);
+    void groupRoleChanged(const QString &role);
+    void valueRoleChanged(const QString &role);
+
+private:
+    Q_DISABLE_COPY(EnginioAggregateModel)
+    Q_DECLARE_PRIVATE(EnginioAggregateModel)
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOAGGREGATEMODEL_H
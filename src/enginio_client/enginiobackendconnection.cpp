@@ -42,18 +42,21 @@
 #include <QtCore/QtEndian>
 #include <QtCore/qjsonarray.h>
 #include <QtCore/qjsonvalue.h>
-#include <QtCore/qregularexpression.h>
+#include <QtCore/qmetaobject.h>
 #include <QtCore/qstring.h>
 #include <QtCore/quuid.h>
 #include <QtNetwork/qtcpsocket.h>
 #include <QtCore/qdebug.h>
 
+#include <zlib.h>
+
 #define CRLF QLatin1String("\r\n")
 
 QT_BEGIN_NAMESPACE
 
 const static int NIL = 0x00;
 const static int FIN = 0x80;
+const static int RSV1 = 0x40;
 const static int MSB = 0x80;
 const static int MSK = 0x80;
 const static int OPC = 0x0F;
@@ -67,22 +70,19 @@ const static quint64 MaskingKeyLength = 4;
 const static quint64 NormalPayloadMarker = 126;
 const static quint64 LargePayloadMarker = 127;
 const static quint64 NormalPayloadLengthLimit = 0xFFFF;
+const static int InflateChunkSize = 4096;
 
-namespace {
-
-const QString HttpResponseStatus(QStringLiteral("HTTP/1\\.1\\s([0-9]{3})\\s"));
-const QString SecWebSocketAcceptHeader(QStringLiteral("Sec-WebSocket-Accept:\\s(.{28})\r\n"));
-const QString UpgradeHeader(QStringLiteral("Upgrade:\\s(.+)\r\n"));
-const QString ConnectionHeader(QStringLiteral("Connection:\\s(.+)\r\n"));
+// Compression stays opt-in until the servers are known to handle the extension offer.
+static bool gEnableEnginioNotificationCompression = qEnvironmentVariableIsSet("ENGINIO_NOTIFICATION_COMPRESSION");
 
-QString gBase64EncodedSha1VerificationKey;
+namespace {
 
-void computeBase64EncodedSha1VerificationKey(const QByteArray &base64Key)
+QByteArray computeBase64EncodedSha1VerificationKey(const QByteArray &base64Key)
 {
     // http://tools.ietf.org/html/rfc6455#section-4.2.2 §5./ 4.
     QByteArray webSocketMagicString(QByteArrayLiteral("258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
     webSocketMagicString.prepend(base64Key);
-    gBase64EncodedSha1VerificationKey = QString::fromUtf8(QCryptographicHash::hash(webSocketMagicString, QCryptographicHash::Sha1).toBase64());
+    return QCryptographicHash::hash(webSocketMagicString, QCryptographicHash::Sha1).toBase64();
 }
 
 const QByteArray generateBase64EncodedUniqueKey()
@@ -111,25 +111,41 @@ void maskData(QByteArray &data, const QByteArray &maskingKey )
         data[octet] = data[octet] ^ maskingKey[octet % maskingKey.size()];
 }
 
-int extractResponseStatus(QString responseString)
+inline bool isWhitespace(char c)
 {
-    const QRegularExpression re(HttpResponseStatus);
-    QRegularExpressionMatch match = re.match(responseString);
-    return match.captured(1).toInt();
+    return c == ' ' || c == '\t';
 }
 
-const QString extractResponseHeader(QString pattern, QString responseString, bool ignoreCase = true)
+template<int N>
+inline bool equalsIgnoreCase(const char *data, int length, const char (&literal)[N])
 {
-    const QRegularExpression re(pattern);
-    QRegularExpressionMatch match = re.match(responseString);
+    return length == N - 1 && !qstrnicmp(data, literal, N - 1);
+}
 
-    if (ignoreCase)
-        return match.captured(1).toLower();
+template<int N>
+inline bool equalsIgnoreCase(const QByteArray &value, const char (&literal)[N])
+{
+    return equalsIgnoreCase(value.constData(), value.size(), literal);
+}
 
-    return match.captured(1);
+QByteArray nextListElement(const char *&it, const char *end, char separator)
+{
+    // Returns the element in front of the next separator without the optional whitespace
+    // around it and moves past the separator. The result refers to the scanned buffer.
+    const char *elementEnd = static_cast<const char *>(memchr(it, separator, end - it));
+    if (!elementEnd)
+        elementEnd = end;
+    const char *element = it;
+    const char *elementStop = elementEnd;
+    while (element != elementStop && isWhitespace(*element))
+        ++element;
+    while (elementStop != element && isWhitespace(elementStop[-1]))
+        --elementStop;
+    it = elementEnd == end ? end : elementEnd + 1;
+    return QByteArray::fromRawData(element, elementStop - element);
 }
 
-const QByteArray constructOpeningHandshake(const QUrl& url)
+const QByteArray constructOpeningHandshake(const QUrl& url, QByteArray *secWebSocketAccept, bool offerCompression)
 {
     // http://tools.ietf.org/html/rfc6455#section-4.1 §2./ 7.
     // The request must include a header field with the name
@@ -139,7 +155,7 @@ const QByteArray constructOpeningHandshake(const QUrl& url)
     // The nonce must be selected randomly for each connection.
 
     const QByteArray secWebSocketKeyBase64 = generateBase64EncodedUniqueKey();
-    computeBase64EncodedSha1VerificationKey(secWebSocketKeyBase64);
+    *secWebSocketAccept = computeBase64EncodedSha1VerificationKey(secWebSocketKeyBase64);
 
     const QString request =  QLatin1String("GET ") % url.path(QUrl::FullyEncoded) % QChar::fromLatin1('?')
                                 % url.query(QUrl::FullyEncoded) % QLatin1String(" HTTP/1.1") % CRLF %
@@ -150,9 +166,16 @@ const QByteArray constructOpeningHandshake(const QUrl& url)
                              QLatin1String("Upgrade: websocket") % CRLF %
                              QLatin1String("Connection: upgrade") % CRLF %
                              QLatin1String("Sec-WebSocket-Key: ") % QString::fromUtf8(secWebSocketKeyBase64) % CRLF %
-                             QLatin1String("Sec-WebSocket-Version: 13") % CRLF % CRLF;
-
-    return request.toUtf8();
+                             QLatin1String("Sec-WebSocket-Version: 13") % CRLF;
+
+    QByteArray handshake = request.toUtf8();
+    // http://tools.ietf.org/html/rfc7692#section-5
+    // The server may attach any parameter it likes to its answer, the inflater
+    // handles every window size, so no client parameter is needed in the offer.
+    if (offerCompression)
+        handshake.append("Sec-WebSocket-Extensions: permessage-deflate\r\n");
+    handshake.append("\r\n");
+    return handshake;
 }
 
 const QByteArray constructFrameHeader(bool isFinalFragment
@@ -199,6 +222,159 @@ const QByteArray constructFrameHeader(bool isFinalFragment
 
 } // namespace
 
+bool EnginioHandshakeResponse::parse(const QByteArray &response)
+{
+    // http://tools.ietf.org/html/rfc7230#section-3
+    // The response is scanned once, header values are not copied.
+    statusCode = 0;
+    upgrade = connection = secWebSocketAccept = QByteArray();
+
+    static const char HttpVersionPrefix[] = "HTTP/1.";
+    const int HttpVersionPrefixLength = sizeof(HttpVersionPrefix) - 1;
+    const char *it = response.constData();
+    const char *end = it + response.size();
+
+    // status-line = HTTP-version SP status-code SP reason-phrase CRLF
+    // The prefix is followed by the minor version digit, a space and three digits.
+    if (end - it < HttpVersionPrefixLength + 5 || qstrncmp(it, HttpVersionPrefix, HttpVersionPrefixLength))
+        return false;
+    it += HttpVersionPrefixLength;
+    if (*it < '0' || *it > '9' || *++it != ' ')
+        return false;
+    ++it;
+
+    int code = 0;
+    for (const char *codeEnd = it + 3; it != codeEnd; ++it) {
+        if (*it < '0' || *it > '9')
+            return false;
+        code = code * 10 + (*it - '0');
+    }
+    if (it == end || (*it != ' ' && *it != '\r' && *it != '\n'))
+        return false;
+
+    const char *lineEnd = static_cast<const char *>(memchr(it, '\n', end - it));
+    if (!lineEnd)
+        return false;
+    it = lineEnd + 1;
+
+    // header-field = field-name ":" OWS field-value OWS
+    forever {
+        lineEnd = static_cast<const char *>(memchr(it, '\n', end - it));
+        if (!lineEnd)
+            return false; // The header section has to be closed by an empty line.
+
+        const char *fieldEnd = lineEnd;
+        if (fieldEnd != it && fieldEnd[-1] == '\r')
+            --fieldEnd;
+
+        if (fieldEnd == it) {
+            statusCode = code;
+            return true;
+        }
+
+        // Obsolete line folding and whitespace before the colon are rejected (RFC 7230 §3.2.4).
+        if (isWhitespace(*it))
+            return false;
+        const char *colon = static_cast<const char *>(memchr(it, ':', fieldEnd - it));
+        if (!colon || colon == it || isWhitespace(colon[-1]))
+            return false;
+
+        const char *value = colon + 1;
+        const char *valueEnd = fieldEnd;
+        while (value != valueEnd && isWhitespace(*value))
+            ++value;
+        while (valueEnd != value && isWhitespace(valueEnd[-1]))
+            --valueEnd;
+
+        const int nameLength = colon - it;
+        QByteArray *field = 0;
+        if (equalsIgnoreCase(it, nameLength, "Upgrade"))
+            field = &upgrade;
+        else if (equalsIgnoreCase(it, nameLength, "Connection"))
+            field = &connection;
+        else if (equalsIgnoreCase(it, nameLength, "Sec-WebSocket-Accept"))
+            field = &secWebSocketAccept;
+        else if (equalsIgnoreCase(it, nameLength, "Sec-WebSocket-Extensions"))
+            field = &secWebSocketExtensions;
+
+        if (field)
+            *field = QByteArray::fromRawData(value, valueEnd - value);
+
+        it = lineEnd + 1;
+    }
+}
+
+bool EnginioHandshakeResponse::isUpgradeToWebSocket() const
+{
+    return equalsIgnoreCase(upgrade, "websocket");
+}
+
+bool EnginioHandshakeResponse::hasConnectionUpgradeToken() const
+{
+    // Connection = 1#connection-option, the list may contain other options too.
+    const char *it = connection.constData();
+    const char *end = it + connection.size();
+    while (it != end) {
+        if (equalsIgnoreCase(nextListElement(it, end, ','), "Upgrade"))
+            return true;
+    }
+    return false;
+}
+
+EnginioHandshakeResponse::ExtensionNegotiation EnginioHandshakeResponse::perMessageDeflate(bool *serverNoContextTakeover) const
+{
+    // http://tools.ietf.org/html/rfc7692#section-7
+    // Only permessage-deflate without parameters is offered, so the connection has to
+    // fail on any other extension, on unknown or repeated parameters and on
+    // client_max_window_bits which is only allowed if the client asked for it.
+    *serverNoContextTakeover = false;
+    bool negotiated = false;
+    const char *it = secWebSocketExtensions.constData();
+    const char *end = it + secWebSocketExtensions.size();
+    while (it != end) {
+        const QByteArray extension = nextListElement(it, end, ',');
+        if (extension.isEmpty())
+            continue;
+
+        const char *param = extension.constData();
+        const char *paramsEnd = param + extension.size();
+        if (negotiated || !equalsIgnoreCase(nextListElement(param, paramsEnd, ';'), "permessage-deflate"))
+            return InvalidExtensionNegotiated;
+        negotiated = true;
+
+        bool hasServerMaxWindowBits = false;
+        bool hasClientNoContextTakeover = false;
+        while (param != paramsEnd) {
+            const QByteArray parameter = nextListElement(param, paramsEnd, ';');
+            const int equalSign = parameter.indexOf('=');
+            const QByteArray name = parameter.left(equalSign).trimmed();
+            if (equalsIgnoreCase(name, "server_no_context_takeover") && equalSign == -1 && !*serverNoContextTakeover) {
+                *serverNoContextTakeover = true;
+            } else if (equalsIgnoreCase(name, "client_no_context_takeover") && equalSign == -1 && !hasClientNoContextTakeover) {
+                // Only outgoing messages would be affected and they are never compressed.
+                hasClientNoContextTakeover = true;
+            } else if (equalsIgnoreCase(name, "server_max_window_bits") && equalSign != -1 && !hasServerMaxWindowBits) {
+                QByteArray value = parameter.mid(equalSign + 1).trimmed();
+                if (value.size() > 1 && value.startsWith('"') && value.endsWith('"'))
+                    value = value.mid(1, value.size() - 2);
+                bool ok;
+                const int windowBits = value.toInt(&ok);
+                if (!ok || windowBits < 8 || windowBits > 15)
+                    return InvalidExtensionNegotiated;
+                // The inflater always uses the largest window, which can decode every smaller one.
+                hasServerMaxWindowBits = true;
+            } else {
+                return InvalidExtensionNegotiated;
+            }
+        }
+    }
+    return negotiated ? PerMessageDeflateNegotiated : NoExtensionNegotiated;
+}
+
+struct EnginioBackendConnection::InflateStream : public z_stream
+{
+};
+
 /*!
     \brief Class to establish a stateful connection to a backend.
     The communication is based on the WebSocket protocol.
@@ -214,8 +390,13 @@ EnginioBackendConnection::EnginioBackendConnection(QObject *parent)
     , _sentCloseFrame(false)
     , _isFinalFragment(false)
     , _isPayloadMasked(false)
+    , _isCompressedMessage(false)
+    , _compressionEnabled(gEnableEnginioNotificationCompression)
+    , _compressionNegotiated(false)
+    , _serverNoContextTakeover(false)
     , _payloadLength(0)
     , _tcpSocket(new QTcpSocket(this))
+    , _inflateStream(0)
 {
     _tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     _tcpSocket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
@@ -225,6 +406,29 @@ EnginioBackendConnection::EnginioBackendConnection(QObject *parent)
     QObject::connect(_tcpSocket, SIGNAL(readyRead()), this, SLOT(onSocketReadyRead()));
 }
 
+EnginioBackendConnection::~EnginioBackendConnection()
+{
+    if (_inflateStream) {
+        inflateEnd(_inflateStream);
+        delete _inflateStream;
+    }
+}
+
+/*!
+    \property EnginioBackendConnection::compressionEnabled
+    \brief whether the permessage-deflate extension (RFC 7692) is offered to the server.
+
+    Compressed messages are inflated transparently. The property is taken into
+    account on the next connection attempt, it is false by default unless the
+    ENGINIO_NOTIFICATION_COMPRESSION environment variable is set.
+
+    \internal
+*/
+void EnginioBackendConnection::setCompressionEnabled(bool enabled)
+{
+    _compressionEnabled = enabled;
+}
+
 void EnginioBackendConnection::onEnginioFinished(EnginioReply *reply)
 {
     struct ReplyScope {
@@ -238,6 +442,7 @@ void EnginioBackendConnection::onEnginioFinished(EnginioReply *reply)
         qDebug() << reply->errorString();
         reply->dumpDebugInfo();
         qDebug() << "\n###\n";
+        emit stateChanged(DisconnectedState);
         return;
     }
 
@@ -245,15 +450,70 @@ void EnginioBackendConnection::onEnginioFinished(EnginioReply *reply)
 
     if (!urlValue.isString()) {
         qDebug() << "## Retrieving connection url failed.";
+        emit stateChanged(DisconnectedState);
         return;
     }
 
     qDebug() << "## Initiating WebSocket connection.";
 
-    _socketUrl = QUrl(urlValue.toString());
+    connectToSocketUrl(QUrl(urlValue.toString()));
+}
+
+/*!
+    \brief Open the WebSocket connection to \a url directly, without asking
+    the backend for a stream url first.
+
+    \internal
+*/
+void EnginioBackendConnection::connectToSocketUrl(const QUrl &url)
+{
+    _socketUrl = url;
     _tcpSocket->connectToHost(_socketUrl.host(), _socketUrl.port(8080));
 }
 
+bool EnginioBackendConnection::inflateMessage(QByteArray &message)
+{
+    // http://tools.ietf.org/html/rfc7692#section-7.2.2
+    // The sender strips the empty stored block which terminates each message
+    // flushed with Z_SYNC_FLUSH, it has to be appended before inflating.
+    Q_ASSERT(_inflateStream);
+    message.append("\x00\x00\xff\xff", 4);
+
+    QByteArray inflated;
+    _inflateStream->next_in = reinterpret_cast<Bytef *>(message.data());
+    _inflateStream->avail_in = message.size();
+
+    int status;
+    forever {
+        const int offset = inflated.size();
+        inflated.resize(offset + qMax(InflateChunkSize, 2 * message.size()));
+        _inflateStream->next_out = reinterpret_cast<Bytef *>(inflated.data() + offset);
+        _inflateStream->avail_out = inflated.size() - offset;
+
+        status = inflate(_inflateStream, Z_SYNC_FLUSH);
+        inflated.resize(inflated.size() - _inflateStream->avail_out);
+
+        // A full output buffer may hide pending output, otherwise all input was consumed.
+        if (status == Z_BUF_ERROR && !_inflateStream->avail_in)
+            status = Z_OK;
+        if (status != Z_OK || _inflateStream->avail_out)
+            break;
+    }
+
+    // A final deflate block ends the stream, the next message starts a new one.
+    if (status == Z_STREAM_END) {
+        status = Z_OK;
+        inflateReset(_inflateStream);
+    } else if (_serverNoContextTakeover) {
+        inflateReset(_inflateStream);
+    }
+
+    if (status != Z_OK)
+        return false;
+    message = inflated;
+    return true;
+}
+
 void EnginioBackendConnection::protocolError(const char* message, WebSocketCloseStatus status)
 {
     qWarning() << QLatin1Literal(message) << QStringLiteral("Closing socket.");
@@ -295,11 +555,12 @@ void EnginioBackendConnection::onSocketStateChanged(QAbstractSocket::SocketState
         _sentCloseFrame = false;
         // The protocol handshake will appear to the HTTP server
         // to be a regular GET request with an Upgrade offer.
-        _tcpSocket->write(constructOpeningHandshake(_socketUrl));
+        _tcpSocket->write(constructOpeningHandshake(_socketUrl, &_secWebSocketAccept, _compressionEnabled));
         break;
     case QAbstractSocket::ClosingState:
         _protocolDecodeState = HandshakePending;
         _applicationData.clear();
+        _isCompressedMessage = false;
         _payloadLength = 0;
         break;
     case QAbstractSocket::UnconnectedState:
@@ -339,10 +600,10 @@ void EnginioBackendConnection::onSocketReadyRead()
         case HandshakePending: {
             // The response is closed by a CRLF line on its own (e.g. ends with two newlines).
             while (_handshakeReply.isEmpty()
-                   || (!_handshakeReply.endsWith(QString(CRLF % CRLF).toUtf8())
+                   || (!_handshakeReply.endsWith("\r\n\r\n")
                    // According to documentation QIODevice::readLine replaces newline characters on
                    // Windows with '\n', so just to be on the safe side:
-                   && !_handshakeReply.endsWith(QByteArrayLiteral("\n\n")))) {
+                   && !_handshakeReply.endsWith("\n\n"))) {
 
                 if (!_tcpSocket->bytesAvailable())
                     return;
@@ -350,19 +611,40 @@ void EnginioBackendConnection::onSocketReadyRead()
                 _handshakeReply.append(_tcpSocket->readLine());
             }
 
-            QString response = QString::fromUtf8(_handshakeReply);
+            // The parsed values refer to _handshakeReply, so it is cleared only after validation.
+            EnginioHandshakeResponse response;
+            const bool isValidHandshake = response.parse(_handshakeReply)
+                    && response.statusCode == 101
+                    && response.secWebSocketAccept == _secWebSocketAccept
+                    && response.isUpgradeToWebSocket()
+                    && response.hasConnectionUpgradeToken();
+            const EnginioHandshakeResponse::ExtensionNegotiation extension = isValidHandshake
+                    ? response.perMessageDeflate(&_serverNoContextTakeover)
+                    : EnginioHandshakeResponse::NoExtensionNegotiated;
             _handshakeReply.clear();
 
-            int statusCode = extractResponseStatus(response);
-            QString secWebSocketAccept = extractResponseHeader(SecWebSocketAcceptHeader, response, /* ignoreCase */ false);
-            bool hasValidKey = secWebSocketAccept == gBase64EncodedSha1VerificationKey;
-
-            if (statusCode != 101 || !hasValidKey
-                    || extractResponseHeader(UpgradeHeader, response) != QStringLiteral("websocket")
-                    || extractResponseHeader(ConnectionHeader, response) != QStringLiteral("upgrade")
-                    )
+            if (!isValidHandshake)
                 return protocolError("Handshake failed!");
 
+            if (extension == EnginioHandshakeResponse::InvalidExtensionNegotiated
+                    || (extension == EnginioHandshakeResponse::PerMessageDeflateNegotiated && !_compressionEnabled))
+                return protocolError("Handshake failed! The server accepted an extension which was not offered.");
+
+            _compressionNegotiated = extension == EnginioHandshakeResponse::PerMessageDeflateNegotiated;
+            if (_compressionNegotiated) {
+                // Each connection starts with an empty sliding window.
+                if (!_inflateStream) {
+                    _inflateStream = new InflateStream();
+                    if (inflateInit2(_inflateStream, -MAX_WBITS) != Z_OK) {
+                        delete _inflateStream;
+                        _inflateStream = 0;
+                        return protocolError("Initializing the inflater failed!", MissingExtensionClientCloseStatus);
+                    }
+                } else {
+                    inflateReset(_inflateStream);
+                }
+            }
+
             _keepAliveTimer.start(TwoMinutes, this);
             _protocolDecodeState = FrameHeaderPending;
             emit stateChanged(ConnectedState);
@@ -405,6 +687,14 @@ void EnginioBackendConnection::onSocketReadyRead()
                 if (_isPayloadMasked)
                     return protocolError("Invalid masked frame received from server.");
 
+                // http://tools.ietf.org/html/rfc7692#section-6
+                // The "Per-Message Compressed" bit is only valid on the first frame of a data message.
+                if (data[0] & RSV1) {
+                    if (!_compressionNegotiated || (_protocolOpcode != TextFrameOp && _protocolOpcode != BinaryFrameOp))
+                        return protocolError("Invalid RSV1 bit received from server.");
+                    _isCompressedMessage = true;
+                }
+
                 // For data length 0-125 LEN is the payload length.
                 if (_payloadLength < NormalPayloadMarker)
                     _protocolDecodeState = PayloadDataPending;
@@ -465,9 +755,16 @@ void EnginioBackendConnection::onSocketReadyRead()
 
             switch (_protocolOpcode) {
             case TextFrameOp: {
-                QJsonObject data = QJsonDocument::fromJson(_applicationData).object();
-                data[EnginioString::messageType] = QStringLiteral("data");
-                emit dataReceived(data);
+                if (_isCompressedMessage && !inflateMessage(_applicationData))
+                    return protocolError("Inflating compressed message failed!", InconsistentDataTypeCloseStatus);
+                const EnginioNotification notification = EnginioNotification::fromJson(_applicationData);
+                emit notificationReceived(notification);
+                // The notification is parsed lazily, a full object is built only if someone wants it.
+                if (isSignalConnected(QMetaMethod::fromSignal(&EnginioBackendConnection::dataReceived))) {
+                    QJsonObject data = notification.toJsonObject();
+                    data[EnginioString::messageType] = QStringLiteral("data");
+                    emit dataReceived(data);
+                }
                 break;
             }
             case PingOp:{
@@ -491,6 +788,7 @@ void EnginioBackendConnection::onSocketReadyRead()
             }
 
             _applicationData.clear();
+            _isCompressedMessage = false;
 
             break;
         }
@@ -41,6 +41,7 @@
 #include <QtNetwork/qabstractsocket.h>
 
 #include <Enginio/enginioclient_global.h>
+#include <Enginio/private/enginionotification_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -49,9 +50,43 @@ class EnginioClientConnectionPrivate;
 class EnginioReply;
 class QTcpSocket;
 
+/*!
+    \brief Single pass parser of the HTTP response closing the WebSocket opening handshake.
+
+    Header names are matched case-insensitively as required by RFC 7230. Parsed values
+    are views into the buffer given to parse(), so that buffer has to outlive the parser.
+
+    \internal
+*/
+struct ENGINIOCLIENT_EXPORT EnginioHandshakeResponse
+{
+    int statusCode;
+    QByteArray upgrade;
+    QByteArray connection;
+    QByteArray secWebSocketAccept;
+    QByteArray secWebSocketExtensions;
+
+    enum ExtensionNegotiation {
+        NoExtensionNegotiated,
+        PerMessageDeflateNegotiated,
+        InvalidExtensionNegotiated
+    };
+
+    EnginioHandshakeResponse()
+        : statusCode()
+    {}
+
+    bool parse(const QByteArray &response);
+
+    bool isUpgradeToWebSocket() const Q_REQUIRED_RESULT;
+    bool hasConnectionUpgradeToken() const Q_REQUIRED_RESULT;
+    ExtensionNegotiation perMessageDeflate(bool *serverNoContextTakeover) const Q_REQUIRED_RESULT;
+};
+
 class ENGINIOCLIENT_EXPORT EnginioBackendConnection : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool compressionEnabled READ compressionEnabled WRITE setCompressionEnabled)
 
     enum WebSocketOpcode
     {
@@ -75,12 +110,19 @@ class ENGINIOCLIENT_EXPORT EnginioBackendConnection : public QObject
     bool _sentCloseFrame;
     bool _isFinalFragment;
     bool _isPayloadMasked;
+    bool _isCompressedMessage;
+    bool _compressionEnabled;
+    bool _compressionNegotiated;
+    bool _serverNoContextTakeover;
     quint64 _payloadLength;
     QByteArray _applicationData;
 
     QUrl _socketUrl;
     QByteArray _handshakeReply;
+    QByteArray _secWebSocketAccept;
     QTcpSocket *_tcpSocket;
+    struct InflateStream;
+    InflateStream *_inflateStream;
     QBasicTimer _keepAliveTimer;
     QBasicTimer _pingTimeoutTimer;
 
@@ -110,8 +152,13 @@ public:
     };
 
     explicit EnginioBackendConnection(QObject *parent = 0);
+    ~EnginioBackendConnection();
 
     bool isConnected() { return _protocolDecodeState > HandshakePending; }
+    bool compressionEnabled() const { return _compressionEnabled; }
+    void setCompressionEnabled(bool enabled);
+
+    void connectToSocketUrl(const QUrl &url);
     void connectToBackend(EnginioClientConnectionPrivate *client, const QJsonObject& messageFilter = QJsonObject());
     void connectToBackend(EnginioClient *client, const QJsonObject& messageFilter = QJsonObject());
 
@@ -121,6 +168,7 @@ public:
 signals:
     void stateChanged(ConnectionState state);
     void dataReceived(QJsonObject data);
+    void notificationReceived(const EnginioNotification &notification);
     void timeOut();
     void pong();
 
@@ -133,6 +181,7 @@ private slots:
 private:
     void timerEvent(QTimerEvent *event);
     void protocolError(const char* message, WebSocketCloseStatus status = ProtocolErrorCloseStatus);
+    bool inflateMessage(QByteArray &message);
 };
 
 QT_END_NAMESPACE
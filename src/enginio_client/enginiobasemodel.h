@@ -45,6 +45,7 @@ class EnginioBaseModelPrivate;
 class ENGINIOCLIENT_EXPORT EnginioBaseModel : public QAbstractListModel
 {
     Q_OBJECT
+    Q_PROPERTY(int queryDebounceInterval READ queryDebounceInterval WRITE setQueryDebounceInterval NOTIFY queryDebounceIntervalChanged)
 
 protected:
     explicit EnginioBaseModel(EnginioBaseModelPrivate &dd, QObject *parent);
@@ -61,8 +62,18 @@ public:
 
     virtual QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
 
+    int queryDebounceInterval() const Q_REQUIRED_RESULT;
+    void setQueryDebounceInterval(int msecs);
+
+    void createRoleIndex(int role);
+    int indexOf(int role, const QVariant &value) const Q_REQUIRED_RESULT;
+    QList<int> rowsMatching(int role, const QVariant &value) const Q_REQUIRED_RESULT;
+
     void disableNotifications();
 
+Q_SIGNALS:
+    void queryDebounceIntervalChanged(int msecs);
+
 private:
     Q_DISABLE_COPY(EnginioBaseModel)
     Q_DECLARE_PRIVATE(EnginioBaseModel)
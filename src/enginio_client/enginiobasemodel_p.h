@@ -42,14 +42,24 @@
 #include <Enginio/private/enginiodummyreply_p.h>
 #include <Enginio/enginioreplystate.h>
 #include <Enginio/private/enginiobackendconnection_p.h>
+#include <Enginio/private/enginionotificationhub_p.h>
+#include <Enginio/private/enginioobjectproperties_p.h>
 #include <Enginio/enginiobasemodel.h>
 #include <Enginio/private/enginiobasemodel_p.h>
+#include <Enginio/private/enginiomodeldiff_p.h>
+#include <Enginio/private/enginiopropertyindex_p.h>
+#include <Enginio/private/enginioquerymatcher_p.h>
+#include <Enginio/private/enginiosortorder_p.h>
 
+#include <QtCore/qcache.h>
 #include <QtCore/qdatetime.h>
 #include <QtCore/qdebug.h>
+#include <QtCore/qfuturewatcher.h>
 #include <QtCore/qhash.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonarray.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
 #include <QtCore/qstring.h>
 #include <QtCore/quuid.h>
 #include <QtCore/qvector.h>
@@ -120,6 +130,13 @@ public:
         return _objectIdIndex.contains(id);
     }
 
+    // Objects removed from the model stay known at DeletedRow
+    bool hasRow(const ObjectId &id) const
+    {
+        StorageIndex idx = _objectIdIndex.value(id, InvalidStorageIndex);
+        return idx != InvalidStorageIndex && _storage[idx].row != DeletedRow;
+    }
+
     Row rowFromObjectId(const ObjectId &id) const
     {
         Q_ASSERT(contains(id));
@@ -127,6 +144,18 @@ public:
         return idx == InvalidStorageIndex ? InvalidRow : _storage[idx].row;
     }
 
+    ObjectId objectIdFromRow(Row row) const
+    {
+        StorageIndex idx = _rowIndex.value(row, InvalidStorageIndex);
+        return idx == InvalidStorageIndex ? ObjectId() : _storage[idx].id;
+    }
+
+    AttachedData dataFromRow(Row row) const
+    {
+        StorageIndex idx = _rowIndex.value(row, InvalidStorageIndex);
+        return idx == InvalidStorageIndex ? AttachedData() : _storage[idx];
+    }
+
     Row rowFromRequestId(const RequestId &id) const
     {
         StorageIndex idx = _requestIdIndex.value(id, qMakePair(0, static_cast<int>(InvalidStorageIndex))).second;
@@ -138,19 +167,48 @@ public:
         return _storage[_rowIndex.value(row)].ref == 0;
     }
 
-    void updateAllDataAfterRowRemoval(const int row) {
+    void updateAllDataAfterRowRemoval(const int row, const int count = 1) {
         _rowIndex.clear();
         _rowIndex.reserve(_storage.count());
         for (StorageIndex i = 0; i < _storage.count() ; ++i) {
             AttachedData &data = _storage[i];
-            if (data.row > row)
-                --data.row;
-            else if (data.row == row)
+            if (data.row >= row + count)
+                data.row -= count;
+            else if (data.row >= row)
                 data.row = DeletedRow;
             _rowIndex.insert(data.row, i);
         }
     }
 
+    void updateAllDataAfterRowInsertion(const int row, const int count = 1) {
+        _rowIndex.clear();
+        _rowIndex.reserve(_storage.count());
+        for (StorageIndex i = 0; i < _storage.count() ; ++i) {
+            AttachedData &data = _storage[i];
+            if (data.row >= row)
+                data.row += count;
+            _rowIndex.insert(data.row, i);
+        }
+    }
+
+    // The rows from..from + count - 1 are at to..to + count - 1 afterwards
+    void updateAllDataAfterRowMove(const int from, const int to, const int count = 1) {
+        _rowIndex.clear();
+        _rowIndex.reserve(_storage.count());
+        for (StorageIndex i = 0; i < _storage.count() ; ++i) {
+            AttachedData &data = _storage[i];
+            if (data.row >= from && data.row < from + count) {
+                data.row += to - from;
+            } else {
+                if (data.row >= from + count)
+                    data.row -= count;
+                if (data.row >= to)
+                    data.row += count;
+            }
+            _rowIndex.insert(data.row, i);
+        }
+    }
+
     AttachedData &ref(const ObjectId &id, Row row)
     {
         StorageIndex idx = _objectIdIndex.value(id, InvalidStorageIndex);
@@ -187,8 +245,16 @@ public:
 
     void insert(const AttachedData &data)
     {
+        // An object which comes back, e.g. because it matches the query
+        // again, keeps the references of its pending requests.
+        StorageIndex idx = _objectIdIndex.value(data.id, InvalidStorageIndex);
+        if (idx != InvalidStorageIndex && _storage[idx].row == DeletedRow) {
+            _storage[idx].row = data.row;
+            _rowIndex.insert(data.row, idx);
+            return;
+        }
         _storage.append(data);
-        StorageIndex idx = _storage.count() - 1;
+        idx = _storage.count() - 1;
         _rowIndex.insert(data.row, idx);
         _objectIdIndex.insert(data.id, idx);
     }
@@ -230,7 +296,7 @@ public:
         _objectIdIndex.reserve(count);
 
         for (int row = 0; row < count; ++row) {
-            QString id = array[row].toObject()[EnginioString::id].toString();
+            const QString id = EnginioObjectProperties::objectId(array.at(row).toObject());
             Q_ASSERT(!id.isEmpty());
             AttachedData data(row, id);
             _storage.append(data);
@@ -240,16 +306,40 @@ public:
     }
 };
 
+class EnginioBaseModelPrivate;
+
+/*!
+  \internal
+  The rows of the models of a client which have the same query. The owner
+  holds the rows, is subscribed to notifications and sends the requests,
+  the followers forward to it and repeat its signals to their views.
+  The store is deleted when the last model detaches from it.
+*/
+struct EnginioModelStore
+{
+    QByteArray key;
+    EnginioClientConnectionPrivate *client;
+    EnginioBaseModelPrivate *owner;
+    QVector<EnginioBaseModelPrivate*> followers;
+};
 
 class ENGINIOCLIENT_EXPORT EnginioBaseModelPrivate : public QAbstractItemModelPrivate {
 protected:
     EnginioClientConnectionPrivate *_enginio;
     Enginio::Operation _operation;
+    EnginioPreparedQuery _preparedQuery;
+    EnginioSortOrder _sortOrder; // of the prepared query
+    EnginioQueryMatcher _queryMatcher; // of the prepared query
     EnginioBaseModel *q;
     QVector<QMetaObject::Connection> _clientConnections;
     QObject *_replyConnectionConntext;
+    // Queries sent by the model itself, aborted when they are superseded
+    QVector<QPointer<EnginioReplyState> > _queryReplies;
+    QTimer _queryDebounceTimer;
 
     const static int IncrementalModelUpdate;
+    const static int OffThreadDiffRows;
+    const static int CachedRows;
     typedef EnginioModelPrivateAttachedData AttachedData;
     AttachedDataContainer _attachedData;
     int _latestRequestedOffset;
@@ -259,64 +349,82 @@ protected:
     QHash<int, QString> _roles;
 
     QJsonArray _data;
+    // Values returned by data() for the rows read last, by row and role
+    mutable QCache<int, QHash<int, QVariant> > _cellCache;
+    // Indexes created with EnginioBaseModel::createRoleIndex(), by role
+    QHash<int, EnginioPropertyIndex> _propertyIndexes;
+    // Pending diff of a large reloaded result, computed in the thread pool
+    QFutureWatcher<EnginioModelDiff> *_diffWatcher;
+    // The latest "updatedAt" seen, the backend always uses the same ISO 8601
+    // format, so the strings can be compared instead of parsed dates.
+    QString _updatedAtHighWaterMark;
+    // The rows shared with models with the same query, see attachToStore()
+    EnginioModelStore *_store;
+    // Connections repeating the signals of the owner of the store
+    QVector<QMetaObject::Connection> _storeConnections;
+
+    class NotificationObject : public EnginioNotificationSubscriber {
+        // The hub of the client the model is subscribed to, it is null
+        // if notifications are not set up or were disabled with
+        // EnginioModel::disableNotifications(). The hub is owned by the client.
+        QPointer<EnginioNotificationHub> _hub;
+        EnginioBaseModelPrivate *_model;
+        bool _disabled;
 
-    class NotificationObject {
-        // connection object it can be:
-        // - null if not yet created
-        // - -1 if notifications where disabled with EnginioModel::disableNotifications()
-        // - valid pointer to connection object
-        EnginioBackendConnection *_connection;
-
-        struct NotificationReceived
-        {
-            EnginioBaseModelPrivate *model;
-
-            void operator ()(QJsonObject data)
-            {
-                model->receivedNotification(data);
-            }
-        };
-        void removeConnection()
+        void removeSubscription()
         {
-            if (*this) {
-                _connection->close();
-                delete _connection;
-            }
+            if (_hub)
+                _hub->unsubscribe(this);
+            _hub = 0;
         }
 
     public:
         NotificationObject()
-            : _connection()
+            : _model()
+            , _disabled(false)
         {}
 
         ~NotificationObject()
         {
-            removeConnection();
+            removeSubscription();
+        }
+
+        void receivedNotification(const EnginioNotification &notification) Q_DECL_OVERRIDE
+        {
+            _model->receivedNotification(notification);
         }
 
-        operator EnginioBackendConnection*()
+        void reconnected() Q_DECL_OVERRIDE
         {
-            return qintptr(_connection) != -1 ? _connection : 0;
+            _model->recoverNotificationGap();
         }
 
         void disable()
         {
-            removeConnection();
-            _connection = (EnginioBackendConnection*)-1;
+            removeSubscription();
+            _disabled = true;
+        }
+
+        void disconnectFromBackend()
+        {
+            removeSubscription();
         }
 
         void connectToBackend(EnginioBaseModelPrivate *model, EnginioClientConnectionPrivate *enginio, const QJsonObject &filter)
         {
-            if (qintptr(_connection) == -1)
+            if (_disabled)
                 return;
             Q_ASSERT(model && enginio);
-            if (enginio->_serviceUrl != EnginioString::stagingEnginIo)
+            if (enginio->_serviceUrl != EnginioString::stagingEnginIo) {
+                removeSubscription();
                 return;  // TODO it allows to use notification only on staging
-            removeConnection(); // TODO reuse the connecton object
-            _connection = new EnginioBackendConnection;
-            NotificationReceived receiver = { model };
-            QObject::connect(_connection, &EnginioBackendConnection::dataReceived, receiver);
-            _connection->connectToBackend(enginio, filter);
+            }
+            EnginioNotificationHub *hub = enginio->notificationHub();
+            if (_hub != hub)
+                removeSubscription(); // the model was moved to another client
+            _model = model;
+            _hub = hub;
+            _hub->subscribe(this, filter);
         }
     } _notifications;
 
@@ -364,6 +472,16 @@ protected:
         }
     };
 
+    struct FinishedGapRecoveryRequest
+    {
+        EnginioBaseModelPrivate *model;
+        EnginioReplyState *reply;
+        void operator ()()
+        {
+            model->finishedGapRecoveryRequest(reply);
+        }
+    };
+
     struct FinishedIncrementalUpdateRequest
     {
         EnginioBaseModelPrivate *model;
@@ -375,19 +493,71 @@ protected:
         }
     };
 
+    struct FinishedDiff
+    {
+        EnginioBaseModelPrivate *model;
+        QFutureWatcher<EnginioModelDiff> *watcher;
+        const QJsonArray from;
+        const QJsonArray to;
+        void operator ()()
+        {
+            model->finishedDiff(watcher, from, to);
+        }
+    };
+
     class QueryChanged
     {
         EnginioBaseModelPrivate *model;
+        bool debounce;
     public:
-        QueryChanged(EnginioBaseModelPrivate *m)
+        QueryChanged(EnginioBaseModelPrivate *m, bool debounceQuery = false)
             : model(m)
+            , debounce(debounceQuery)
         {
             Q_ASSERT(m);
         }
 
         void operator ()()
         {
-            model->execute();
+            if (debounce && model->_queryDebounceTimer.interval() > 0)
+                model->_queryDebounceTimer.start();
+            else
+                model->execute();
+        }
+    };
+
+    class InvalidateCachedCells
+    {
+        EnginioBaseModelPrivate *model;
+    public:
+        InvalidateCachedCells(EnginioBaseModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const QModelIndex &topLeft, const QModelIndex &bottomRight) const
+        {
+            for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+                model->_cellCache.remove(row);
+        }
+    };
+
+    class ClearCachedCells
+    {
+        EnginioBaseModelPrivate *model;
+    public:
+        ClearCachedCells(EnginioBaseModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()() const
+        {
+            // Rows were inserted, removed or moved, the cached ones may have
+            // a different row now.
+            model->_cellCache.clear();
         }
     };
 
@@ -411,6 +581,80 @@ protected:
         }
     };
 
+    // The followers of a store repeat the signals of its owner, the rows
+    // are the same so only the model differs.
+    struct RelayRowsAboutToChange
+    {
+        EnginioBaseModelPrivate *model;
+        bool insert;
+        void operator ()(const QModelIndex &, int first, int last) const
+        {
+            if (insert)
+                model->q->beginInsertRows(QModelIndex(), first, last);
+            else
+                model->q->beginRemoveRows(QModelIndex(), first, last);
+        }
+    };
+
+    struct RelayRowsAboutToBeMoved
+    {
+        EnginioBaseModelPrivate *model;
+        void operator ()(const QModelIndex &, int first, int last, const QModelIndex &, int destination) const
+        {
+            model->q->beginMoveRows(QModelIndex(), first, last, QModelIndex(), destination);
+        }
+    };
+
+    struct RelayModelAboutToBeReset
+    {
+        EnginioBaseModelPrivate *model;
+        void operator ()() const
+        {
+            model->q->beginResetModel();
+        }
+    };
+
+    struct RelayChangeFinished
+    {
+        enum Change { InsertRows, RemoveRows, MoveRows, ResetModel };
+        EnginioBaseModelPrivate *model;
+        Change change;
+        void operator ()() const
+        {
+            switch (change) {
+            case InsertRows: model->q->endInsertRows(); break;
+            case RemoveRows: model->q->endRemoveRows(); break;
+            case MoveRows: model->q->endMoveRows(); break;
+            case ResetModel: model->q->endResetModel(); break;
+            }
+        }
+    };
+
+    struct RelayDataChanged
+    {
+        EnginioBaseModelPrivate *model;
+        void operator ()(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles) const
+        {
+            emit model->q->dataChanged(model->q->index(topLeft.row()), model->q->index(bottomRight.row()), roles);
+        }
+    };
+
+    class ResumeAsStoreOwner
+    {
+        EnginioBaseModelPrivate *model;
+    public:
+        ResumeAsStoreOwner(EnginioBaseModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()() const
+        {
+            model->resumeAsStoreOwner();
+        }
+    };
+
 public:
     EnginioBaseModelPrivate(EnginioBaseModel *q_ptr)
         : _enginio(0)
@@ -420,7 +664,13 @@ public:
         , _latestRequestedOffset(0)
         , _canFetchMore(false)
         , _rolesCounter(Enginio::SyncedRole)
+        , _diffWatcher(0)
+        , _store(0)
     {
+        _cellCache.setMaxCost(CachedRows);
+        _queryDebounceTimer.setSingleShot(true);
+        _queryDebounceTimer.setInterval(0);
+        QObject::connect(&_queryDebounceTimer, &QTimer::timeout, QueryChanged(this));
     }
 
     virtual ~EnginioBaseModelPrivate();
@@ -430,13 +680,113 @@ public:
         _notifications.disable();
     }
 
-    void receivedNotification(const QJsonObject &data);
+    int queryDebounceInterval() const Q_REQUIRED_RESULT
+    {
+        return _queryDebounceTimer.interval();
+    }
+
+    void setQueryDebounceInterval(int msecs)
+    {
+        _queryDebounceTimer.setInterval(msecs);
+    }
+
+    void receivedNotification(const EnginioNotification &notification);
     void receivedRemoveNotification(const QJsonObject &object, int rowHint = NoHintRow);
     void receivedUpdateNotification(const QJsonObject &object, const QString &idHint = QString(), int row = NoHintRow);
     void receivedCreateNotification(const QJsonObject &object);
+    void moveToSortedRow(int row);
+    void recoverNotificationGap();
+    void finishedGapRecoveryRequest(const EnginioReplyState *reply);
+
+    void updateHighWaterMark(const QJsonObject &object)
+    {
+        const QString updatedAt = EnginioObjectProperties::updatedAt(object);
+        if (updatedAt > _updatedAtHighWaterMark)
+            _updatedAtHighWaterMark = updatedAt;
+    }
+
+    bool isStoreFollower() const Q_REQUIRED_RESULT
+    {
+        return _store && _store->owner != this;
+    }
+
+    QByteArray storeKey() const Q_REQUIRED_RESULT;
+    bool attachToStore();
+    void detachFromStore();
+    void leaveStore();
+    void dropPendingChanges();
+    void adoptPendingCreates();
+    void followStoreOwner();
+    void unfollowStoreOwner();
+    void resumeAsStoreOwner();
+
+    void createRoleIndex(int role)
+    {
+        if (isStoreFollower())
+            return _store->owner->createRoleIndex(role);
+        if (_propertyIndexes.contains(role))
+            return;
+        rebuildPropertyIndex(&_propertyIndexes[role], _roles.value(role));
+    }
+
+    // Appended rows are indexed by their temporary id until the backend created them
+    QString indexedObjectId(int row) const Q_REQUIRED_RESULT
+    {
+        const QString id = EnginioObjectProperties::objectId(_data.at(row).toObject());
+        return id.isEmpty() ? _attachedData.objectIdFromRow(row) : id;
+    }
+
+    void rebuildPropertyIndex(EnginioPropertyIndex *index, const QString &property)
+    {
+        index->rebuild(property, _data);
+        for (int row = 0; row < _data.count(); ++row) {
+            const QJsonObject object = _data.at(row).toObject();
+            if (EnginioObjectProperties::objectId(object).isEmpty())
+                index->insert(object, _attachedData.objectIdFromRow(row));
+        }
+    }
+
+    // The role names are known only once the first object arrived
+    void rebuildPropertyIndexes()
+    {
+        for (QHash<int, EnginioPropertyIndex>::iterator it = _propertyIndexes.begin(); it != _propertyIndexes.end(); ++it)
+            rebuildPropertyIndex(&it.value(), _roles.value(it.key()));
+    }
+
+    void insertIntoPropertyIndexes(const QJsonObject &object, const QString &id)
+    {
+        for (QHash<int, EnginioPropertyIndex>::iterator it = _propertyIndexes.begin(); it != _propertyIndexes.end(); ++it)
+            it.value().insert(object, id);
+    }
+
+    void insertIntoPropertyIndexes(const QJsonObject &object)
+    {
+        insertIntoPropertyIndexes(object, EnginioObjectProperties::objectId(object));
+    }
+
+    void removeFromPropertyIndexes(const QJsonObject &object, const QString &id)
+    {
+        for (QHash<int, EnginioPropertyIndex>::iterator it = _propertyIndexes.begin(); it != _propertyIndexes.end(); ++it)
+            it.value().remove(object, id);
+    }
+
+    void removeFromPropertyIndexes(const QJsonObject &object)
+    {
+        removeFromPropertyIndexes(object, EnginioObjectProperties::objectId(object));
+    }
+
+    void replaceInPropertyIndexes(const QJsonObject &oldObject, const QJsonObject &newObject)
+    {
+        removeFromPropertyIndexes(oldObject);
+        insertIntoPropertyIndexes(newObject);
+    }
+
+    QList<int> rowsMatching(int role, const QVariant &value, bool firstOnly) const Q_REQUIRED_RESULT;
 
     EnginioReplyState *append(const QJsonObject &value)
     {
+        if (isStoreFollower())
+            return _store->owner->append(value);
         QJsonObject object(value);
         QString temporaryId = QString::fromLatin1("tmp") + QUuid::createUuid().toString();
         object[EnginioString::objectType] = queryData(EnginioString::objectType); // TODO think about it, it means that not all queries are valid
@@ -460,6 +810,7 @@ public:
             q->beginInsertRows(QModelIndex(), _data.count(), _data.count());
             _attachedData.insert(data);
             _data.append(value);
+            insertIntoPropertyIndexes(value, temporaryId);
             q->endInsertRows();
         }
         _attachedData.insertRequestId(ereply->requestId(), row);
@@ -482,7 +833,7 @@ public:
 
         QPair<QString, int> getAndSetCurrentIdRow(EnginioReplyState *finishedCreateReply)
         {
-            QString id = _model->replyData(finishedCreateReply)[EnginioString::id].toString();
+            QString id = EnginioObjectProperties::objectId(_model->replyData(finishedCreateReply));
             Q_ASSERT(!id.isEmpty());
             _object[EnginioString::id] = id;
             int row = InvalidRow;
@@ -533,8 +884,10 @@ public:
 
     EnginioReplyState *remove(int row)
     {
+        if (isStoreFollower())
+            return _store->owner->remove(row);
         QJsonObject oldObject = _data.at(row).toObject();
-        QString id = oldObject[EnginioString::id].toString();
+        QString id = EnginioObjectProperties::objectId(oldObject);
         if (id.isEmpty())
             return removeDelayed(row, oldObject);
         return removeNow(row, oldObject, id);
@@ -571,6 +924,8 @@ public:
 
     EnginioReplyState *setValue(int row, const QString &role, const QVariant &value)
     {
+        if (isStoreFollower())
+            return _store->owner->setValue(row, role, value);
         int key = _roles.key(role, Enginio::InvalidRole);
         return setData(row, value, key);
     }
@@ -584,36 +939,85 @@ public:
     {
         Q_ASSERT_X(operation >= Enginio::ObjectOperation, "setOperation", "Invalid operation specified.");
         _operation = static_cast<Enginio::Operation>(operation);
+        _preparedQuery = EnginioPreparedQuery();
+    }
+
+    const EnginioPreparedQuery &preparedQuery()
+    {
+        if (_preparedQuery.isNull()) {
+            const QJsonObject query = queryAsJson();
+            ObjectAdaptor<QJsonObject> aQuery(query);
+            _preparedQuery = EnginioClientConnectionPrivate::prepareQuery(aQuery, _operation);
+            _sortOrder = EnginioSortOrder::fromJson(query.value(EnginioString::sort));
+            _queryMatcher = EnginioQueryMatcher::compile(query.value(EnginioString::query).toObject());
+        }
+        return _preparedQuery;
+    }
+
+    /*!
+      \internal
+      Destroys the queries the model sent which did not finish yet, a
+      destroyed reply aborts its network request.
+    */
+    void abortQueryReplies()
+    {
+        QVector<QPointer<EnginioReplyState> > replies;
+        replies.swap(_queryReplies);
+        foreach (const QPointer<EnginioReplyState> &reply, replies) {
+            if (reply && !reply->isFinished())
+                delete reply.data();
+        }
+    }
+
+    void trackQueryReply(EnginioReplyState *ereply)
+    {
+        _queryReplies.removeAll(QPointer<EnginioReplyState>());
+        _queryReplies.append(ereply);
     }
 
     void execute()
     {
-        if (!_enginio || _enginio->_backendId.isEmpty())
+        _queryDebounceTimer.stop();
+        // The results of the previous query are of no use anymore.
+        abortQueryReplies();
+        if (!_enginio || _enginio->_backendId.isEmpty()) {
+            detachFromStore();
             return;
+        }
         if (!queryIsEmpty()) {
-            // setup notifications
-            QJsonObject filter;
-            QJsonObject objectType;
-            objectType.insert(EnginioString::objectType, queryData(EnginioString::objectType));
-            filter.insert(EnginioString::data, objectType);
-            _notifications.connectToBackend(this, _enginio, filter);
-
-            EnginioReplyState *ereply = reload();
-            QObject::connect(ereply, &EnginioReplyState::dataChanged, ereply, &EnginioReplyState::deleteLater);
+            if (attachToStore())
+                return; // the owner of the store queries for all of its models
+            subscribeAndLoad();
         } else {
+            detachFromStore();
             fullQueryReset(QJsonArray());
         }
     }
 
+    void subscribeAndLoad()
+    {
+        // setup notifications
+        QJsonObject filter;
+        QJsonObject objectType;
+        objectType.insert(EnginioString::objectType, queryData(EnginioString::objectType));
+        filter.insert(EnginioString::data, objectType);
+        _notifications.connectToBackend(this, _enginio, filter);
+
+        EnginioReplyState *ereply = reload();
+        QObject::connect(ereply, &EnginioReplyState::dataChanged, ereply, &EnginioReplyState::deleteLater);
+        trackQueryReply(ereply);
+    }
+
     EnginioReplyState *reload()
     {
+        if (isStoreFollower())
+            return _store->owner->reload();
         // send full query
-        QJsonObject query = queryAsJson();
-        ObjectAdaptor<QJsonObject> aQuery(query);
-        QNetworkReply *nreply = _enginio->query(aQuery, static_cast<Enginio::Operation>(_operation));
+        const EnginioPreparedQuery &query = preparedQuery();
+        QNetworkReply *nreply = _enginio->query(query, query.offset(), query.limit());
         EnginioReplyState *ereply = _enginio->createReply(nreply);
         if (_canFetchMore)
-            _latestRequestedOffset = query[EnginioString::limit].toDouble();
+            _latestRequestedOffset = query.limit();
         FinishedFullQueryRequest finshedRequest = { this, ereply };
         QObject::connect(ereply, &EnginioReplyState::dataChanged, _replyConnectionConntext, finshedRequest);
         return ereply;
@@ -631,7 +1035,11 @@ public:
 
         q->beginInsertRows(QModelIndex(), startingOffset, startingOffset + dataCount -1);
         for (int i = 0; i < dataCount; ++i) {
-            _data.append(data[i]);
+            const QJsonObject object = data[i].toObject();
+            _attachedData.insert(AttachedData(_data.count(), EnginioObjectProperties::objectId(object)));
+            _data.append(object);
+            updateHighWaterMark(object);
+            insertIntoPropertyIndexes(object);
         }
 
         _canFetchMore = limit <= dataCount;
@@ -642,10 +1050,18 @@ public:
     {
         delete _replyConnectionConntext;
         _replyConnectionConntext = new QObject();
-        fullQueryReset(replyData(reply)[EnginioString::results].toArray());
+        // Pages fetched for the previous result would be ignored.
+        abortQueryReplies();
+        updateFromQueryResult(replyData(reply)[EnginioString::results].toArray());
     }
 
     void fullQueryReset(const QJsonArray &data);
+    void updateFromQueryResult(const QJsonArray &data);
+    void finishedDiff(QFutureWatcher<EnginioModelDiff> *watcher, const QJsonArray &from, const QJsonArray &to);
+    void applyDiff(const EnginioModelDiff &diff, const QJsonArray &data);
+    void cancelDiff();
+    bool isDiffPending() const Q_REQUIRED_RESULT { return _diffWatcher; }
+    bool hasRolesFor(const QJsonArray &data) const Q_REQUIRED_RESULT;
 
     void finishedCreateRequest(const EnginioReplyState *reply, const QString &tmpId)
     {
@@ -660,7 +1076,7 @@ public:
         else {
             // the dummy object doesn't exist anymore, probably it was removed by a full reset
             // or by an initial query.
-            QString id = replyData(reply)[EnginioString::id].toString();
+            QString id = EnginioObjectProperties::objectId(replyData(reply));
             if (_attachedData.contains(id)) {
                 // The reset removed the dummy value but it contained the newly created (initial reset
                 // and append were reordered)
@@ -741,6 +1157,7 @@ public:
             } else {
                 // Try to rollback the change.
                 // TODO it is not perfect https://github.com/enginio/enginio-qt/issues/200
+                replaceInPropertyIndexes(_data.at(row).toObject(), oldValue);
                 _data.replace(row, oldValue);
                 emit q->dataChanged(q->index(row), q->index(row));
             }
@@ -781,9 +1198,11 @@ public:
 
     EnginioReplyState *setData(const int row, const QVariant &value, int role)
     {
+        if (isStoreFollower())
+            return _store->owner->setData(row, value, role);
         if (role != Enginio::InvalidRole) {
             QJsonObject oldObject = _data.at(row).toObject();
-            QString id = oldObject[EnginioString::id].toString();
+            QString id = EnginioObjectProperties::objectId(oldObject);
             if (id.isEmpty())
                 return setDataDelyed(row, value, role, oldObject);
             return setDataNow(row, value, role, oldObject, id);
@@ -845,6 +1264,7 @@ public:
         FinishedUpdateRequest finished = { this, id, oldObject, ereply };
         QObject::connect(ereply, &EnginioReplyState::dataChanged, _replyConnectionConntext, finished);
         _attachedData.ref(id, row);
+        replaceInPropertyIndexes(oldObject, newObject);
         _data.replace(row, newObject);
         _attachedData.insertRequestId(ereply->requestId(), row);
         emit q->dataChanged(q->index(row), q->index(row));
@@ -855,6 +1275,8 @@ public:
 
     QHash<int, QByteArray> roleNames() const Q_REQUIRED_RESULT
     {
+        if (isStoreFollower())
+            return _store->owner->roleNames();
         QHash<int, QByteArray> roles;
         roles.reserve(_roles.count());
         for (QHash<int, QString>::const_iterator i = _roles.constBegin();
@@ -867,15 +1289,38 @@ public:
 
     int rowCount() const Q_REQUIRED_RESULT
     {
+        if (isStoreFollower())
+            return _store->owner->rowCount();
         return _data.count();
     }
 
     QVariant data(unsigned row, int role) const Q_REQUIRED_RESULT
     {
+        if (isStoreFollower())
+            return _store->owner->data(row, role);
         if (role == Enginio::SyncedRole) {
             return _attachedData.isSynced(row);
         }
 
+        // Delegates read the same cells again and again during layout
+        QHash<int, QVariant> *cells = _cellCache.object(row);
+        if (cells) {
+            const QHash<int, QVariant>::const_iterator cell = cells->constFind(role);
+            if (cell != cells->constEnd())
+                return cell.value();
+        } else {
+            cells = new QHash<int, QVariant>();
+            _cellCache.insert(row, cells);
+        }
+        const QVariant value = cellData(row, role);
+        cells->insert(role, value);
+        return value;
+    }
+
+    QVariant cellData(unsigned row, int role) const Q_REQUIRED_RESULT
+    {
+        // The whole object is returned as the QJsonValue stored in the model,
+        // it shares the data instead of converting it.
         const QJsonObject object = _data.at(row).toObject();
         if (!object.isEmpty()) {
             if (role == Qt::DisplayRole || role == Enginio::JsonObjectRole)
@@ -890,11 +1335,15 @@ public:
 
     bool canFetchMore() const Q_REQUIRED_RESULT
     {
+        if (isStoreFollower())
+            return _store->owner->canFetchMore();
         return _canFetchMore;
     }
 
     void fetchMore(int row)
     {
+        if (isStoreFollower())
+            return _store->owner->fetchMore(row);
         int currentOffset = _data.count();
         if (!_canFetchMore || currentOffset < _latestRequestedOffset)
             return; // we do not want to spam the server, lets wait for the last fetch
@@ -909,12 +1358,12 @@ public:
 
         qDebug() << Q_FUNC_INFO << query;
         _latestRequestedOffset += limit;
-        ObjectAdaptor<QJsonObject> aQuery(query);
-        QNetworkReply *nreply = _enginio->query(aQuery, static_cast<Enginio::Operation>(_operation));
+        QNetworkReply *nreply = _enginio->query(preparedQuery(), currentOffset, limit);
         EnginioReplyState *ereply = _enginio->createReply(nreply);
         QObject::connect(ereply, &EnginioReplyState::dataChanged, ereply, &EnginioReplyState::deleteLater);
         FinishedIncrementalUpdateRequest finishedRequest = { this, query, ereply };
         QObject::connect(ereply, &EnginioReplyState::dataChanged, _replyConnectionConntext, finishedRequest);
+        trackQueryReply(ereply);
     }
 
     virtual QJsonObject replyData(const EnginioReplyState *reply) const = 0;
@@ -959,9 +1408,15 @@ struct EnginioModelPrivateT : public EnginioBaseModelPrivate
 
     void init()
     {
-        QObject::connect(q(), &Public::queryChanged, QueryChanged(this));
+        QObject::connect(q(), &Public::queryChanged, QueryChanged(this, true));
         QObject::connect(q(), &Public::clientChanged, QueryChanged(this));
         QObject::connect(q(), &Public::operationChanged, QueryChanged(this));
+        QObject::connect(q(), &QAbstractItemModel::dataChanged, InvalidateCachedCells(this));
+        QObject::connect(q(), &QAbstractItemModel::rowsInserted, ClearCachedCells(this));
+        QObject::connect(q(), &QAbstractItemModel::rowsRemoved, ClearCachedCells(this));
+        QObject::connect(q(), &QAbstractItemModel::rowsMoved, ClearCachedCells(this));
+        QObject::connect(q(), &QAbstractItemModel::modelReset, ClearCachedCells(this));
+        QObject::connect(q(), &QAbstractItemModel::layoutChanged, ClearCachedCells(this));
     }
 
     Client *enginio() const Q_REQUIRED_RESULT
@@ -996,6 +1451,7 @@ struct EnginioModelPrivateT : public EnginioBaseModelPrivate
     void setQuery(const Data &query)
     {
         _query = query;
+        _preparedQuery = EnginioPreparedQuery();
 
         // TODO Enable together with pageing support
 //        if (_query.contains(EnginioString::pageSize)) {
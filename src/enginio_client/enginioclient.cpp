@@ -42,10 +42,16 @@
 #include <QtCore/qthreadstorage.h>
 #include <QtNetwork/qnetworkaccessmanager.h>
 #include <QtNetwork/qnetworkreply.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qtimer.h>
+
+#if !defined(QT_NO_SSL)
+#include <QtNetwork/qsslconfiguration.h>
+#endif
 
 #if defined(ENGINIO_VALGRIND_DEBUG)
 #include <QtNetwork/qsslcipher.h>
-#include <QtNetwork/qsslconfiguration.h>
 #endif
 
 QT_BEGIN_NAMESPACE
@@ -235,26 +241,115 @@ QT_BEGIN_NAMESPACE
 
 ENGINIOCLIENT_EXPORT bool gEnableEnginioDebugInfo = !qEnvironmentVariableIsSet("ENGINIO_DEBUG_INFO");
 
-QNetworkRequest EnginioClientConnectionPrivate::prepareRequest(const QUrl &url)
+EnginioRequestIdGenerator::EnginioRequestIdGenerator()
 {
-    QByteArray requestId = QUuid::createUuid().toByteArray();
+    const QByteArray seed = QUuid::createUuid().toRfc4122();
+    Q_ASSERT(seed.size() == sizeof(_state));
+    memcpy(_state, seed.constData(), sizeof(_state));
+    if (!_state[0] && !_state[1])
+        _state[0] = Q_UINT64_C(0x9e3779b97f4a7c15); // the state must not be all zero
+}
 
-    // Remove unneeded pretty-formatting.
-    // before: "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}"
-    // after:  "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-    requestId.chop(1);      // }
-    requestId.remove(0, 1); // {
-    requestId.remove(23, 1);
-    requestId.remove(18, 1);
-    requestId.remove(13, 1);
-    requestId.remove(8, 1);
+QByteArray EnginioRequestIdGenerator::next()
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    QByteArray result(32, Qt::Uninitialized);
+    char *out = result.data();
+    for (int word = 0; word < 2; ++word) {
+        // xorshift128+
+        quint64 x = _state[0];
+        const quint64 y = _state[1];
+        _state[0] = y;
+        x ^= x << 23;
+        _state[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+        const quint64 value = _state[1] + y;
+
+        for (int shift = 60; shift >= 0; shift -= 4)
+            *out++ = hexDigits[(value >> shift) & 0xf];
+    }
+    return result;
+}
 
+QNetworkRequest EnginioClientConnectionPrivate::prepareRequest(const QUrl &url, int operation)
+{
     QNetworkRequest req(_request);
     req.setUrl(url);
-    req.setRawHeader(EnginioString::X_Request_Id, requestId);
+    req.setRawHeader(EnginioString::X_Request_Id, _requestIds.next());
+    if (Q_UNLIKELY(_requestTiming)) {
+        req.setAttribute(EnginioRequestTiming::CreatedAttribute, _timingClock.nsecsElapsed());
+        req.setAttribute(EnginioRequestTiming::OperationAttribute, operation);
+    }
     return req;
 }
 
+/*!
+  \internal
+  Sends the GET \a request of a query, unless an identical query is in flight
+  already. Models and views created together often ask for the same data,
+  the later requests then share the reply of the first one and cost neither
+  a round-trip nor another parse of the result. Queries are identical if the
+  url, the backend and the user they are sent for are.
+*/
+QNetworkReply *EnginioClientConnectionPrivate::sharedGet(const QNetworkRequest &request)
+{
+    const QByteArray backendId = request.rawHeader("Enginio-Backend-Id");
+    const QByteArray authorization = request.rawHeader(EnginioString::Authorization);
+    const QByteArray url = request.url().toEncoded();
+    QByteArray key;
+    key.reserve(url.size() + backendId.size() + authorization.size() + 2);
+    key.append(url).append('\n').append(backendId).append('\n').append(authorization);
+
+    QNetworkReply *shared = _sharedQueryKeys.value(key);
+    if (shared && !shared->isFinished()) {
+        EnginioSharedReply *follower = new EnginioSharedReply(this, request);
+        _sharedQueries[shared].followers.append(follower);
+        return follower;
+    }
+
+    QNetworkReply *nreply = networkManager()->get(request);
+    _sharedQueries[nreply].key = key;
+    _sharedQueryKeys.insert(key, nreply);
+    return nreply;
+}
+
+/*!
+  \internal
+  Hands the result of the finished query \a nreply to the queries sharing it.
+  \a ereply is null if the reply of the first query was deleted meanwhile.
+*/
+void EnginioClientConnectionPrivate::finishSharedQuery(QNetworkReply *nreply, EnginioReplyState *ereply)
+{
+    QHash<QNetworkReply*, SharedQuery>::iterator it = _sharedQueries.find(nreply);
+    if (it == _sharedQueries.end())
+        return;
+    const SharedQuery query = it.value();
+    _sharedQueries.erase(it);
+    if (_sharedQueryKeys.value(query.key) == nreply)
+        _sharedQueryKeys.remove(query.key);
+
+    bool parsed = false;
+    QByteArray data;
+    QJsonObject json;
+    foreach (const QPointer<EnginioSharedReply> &follower, query.followers) {
+        if (!follower)
+            continue;
+        if (!parsed) {
+            if (ereply) {
+                EnginioReplyStatePrivate *d = EnginioReplyStatePrivate::get(ereply);
+                data = d->pData();
+                json = d->data();
+            } else {
+                data = nreply->readAll();
+                json = QJsonDocument::fromJson(data).object();
+            }
+            parsed = true;
+        }
+        follower->finishFrom(nreply, data);
+        if (EnginioReplyState *shared = _replyReplyMap.value(follower))
+            EnginioReplyStatePrivate::get(shared)->setParsedData(data, json);
+    }
+}
+
 bool EnginioClientConnectionPrivate::appendIdToPathIfPossible(QString *path, const QString &id, QByteArray *errorMsg, EnginioClientConnectionPrivate::PathOptions flags, QByteArray errorMessageHint)
 {
     Q_ASSERT(path && errorMsg);
@@ -270,14 +365,27 @@ bool EnginioClientConnectionPrivate::appendIdToPathIfPossible(QString *path, con
     return true;
 }
 
+static int prewarmedConnectionCount()
+{
+    bool ok;
+    const int count = qgetenv("ENGINIO_PREWARM_CONNECTIONS").toInt(&ok);
+    if (ok && count >= 0)
+        return count;
+    return EnginioClientConnectionPrivate::DefaultPrewarmedConnectionCount;
+}
+
 EnginioClientConnectionPrivate::EnginioClientConnectionPrivate() :
     _identity(),
     _serviceUrl(EnginioString::apiEnginIo),
     _networkManager(),
     _uploadChunkSize(512 * 1024),
-    _authenticationState(Enginio::NotAuthenticated)
+    _authenticationState(Enginio::NotAuthenticated),
+    _prewarmedConnectionCount(prewarmedConnectionCount()),
+    _prewarmScheduled(false),
+    _requestTiming(false)
 {
     assignNetworkManager();
+    _timingClock.start();
 
 #if defined(ENGINIO_VALGRIND_DEBUG)
     QSslConfiguration conf = QSslConfiguration::defaultConfiguration();
@@ -302,9 +410,17 @@ void EnginioClientConnectionPrivate::replyFinished(QNetworkReply *nreply)
 {
     EnginioReplyState *ereply = _replyReplyMap.take(nreply);
 
+    if (!_sharedQueries.isEmpty())
+        finishSharedQuery(nreply, ereply);
+
     if (!ereply)
         return;
 
+    EnginioReplyStatePrivate::get(ereply)->stampFinished();
+
+    if (Q_UNLIKELY(!_tlsSessionFile.isEmpty()) && nreply->error() == QNetworkReply::NoError)
+        saveTlsSession(nreply);
+
     if (nreply->error() != QNetworkReply::NoError) {
         QPair<QIODevice *, qint64> deviceState = _chunkedUploads.take(nreply);
         delete deviceState.first;
@@ -332,11 +448,7 @@ void EnginioClientConnectionPrivate::replyFinished(QNetworkReply *nreply)
         // delay emittion of finished signal for autotests
         _delayedReplies.insert(ereply);
     } else {
-        ereply->dataChanged();
-        EnginioReplyStatePrivate::get(ereply)->emitFinished();
-        emitFinished(ereply);
-        if (gEnableEnginioDebugInfo)
-            _requestData.remove(nreply);
+        deliverFinished(ereply);
     }
 
     if (Q_UNLIKELY(_delayedReplies.count())) {
@@ -352,11 +464,7 @@ bool EnginioClientConnectionPrivate::finishDelayedReplies()
         needToReevaluate = false;
         foreach (EnginioReplyState *reply, _delayedReplies) {
             if (!reply->delayFinishedSignal()) {
-                reply->dataChanged();
-                EnginioReplyStatePrivate::get(reply)->emitFinished();
-                emitFinished(reply);
-                if (gEnableEnginioDebugInfo)
-                    _requestData.remove(reply->d_func()->_nreply); // FIXME it is ugly, and breaks encapsulation
+                deliverFinished(reply);
                 _delayedReplies.remove(reply);
                 needToReevaluate = true;
             }
@@ -365,6 +473,19 @@ bool EnginioClientConnectionPrivate::finishDelayedReplies()
     return !_delayedReplies.isEmpty();
 }
 
+void EnginioClientConnectionPrivate::deliverFinished(EnginioReplyState *ereply)
+{
+    EnginioReplyStatePrivate *d = EnginioReplyStatePrivate::get(ereply);
+    ereply->dataChanged();
+    d->emitFinished();
+    emitFinished(ereply);
+
+    if (Q_UNLIKELY(d->_timing.isValid())) {
+        d->_timing.stamp(EnginioRequestTiming::Delivered, _timingClock.nsecsElapsed());
+        _timingStatistics.add(d->_timing);
+    }
+}
+
 EnginioClientConnectionPrivate::~EnginioClientConnectionPrivate()
 {
     foreach (const QMetaObject::Connection &identityConnection, _identityConnections)
@@ -420,6 +541,7 @@ void EnginioClientConnection::setBackendId(const QByteArray &backendId)
     if (d->_backendId != backendId) {
         d->_backendId = backendId;
         d->_request.setRawHeader("Enginio-Backend-Id", d->_backendId);
+        d->schedulePrewarmConnections();
         emit backendIdChanged(backendId);
     }
 }
@@ -434,6 +556,10 @@ void EnginioClientConnection::setBackendId(const QByteArray &backendId)
   to be changed it should be done as a first operaion on this
   EnginioClientConnection, otherwise some request may be sent accidentally
   to the default url.
+
+  As soon as both the backend id and the service url are set, connections
+  to the service are opened in the background, so that the first request
+  does not have to wait for the handshakes.
 */
 QUrl EnginioClientConnection::serviceUrl() const
 {
@@ -446,6 +572,7 @@ void EnginioClientConnection::setServiceUrl(const QUrl &serviceUrl)
     Q_D(EnginioClientConnection);
     if (d->_serviceUrl != serviceUrl) {
         d->_serviceUrl = serviceUrl;
+        d->schedulePrewarmConnections();
         emit serviceUrlChanged(serviceUrl);
     }
 }
@@ -462,6 +589,76 @@ QNetworkAccessManager *EnginioClientConnection::networkManager() const
     return d->networkManager();
 }
 
+/*!
+  \since 1.8
+  Returns true if the requests of this client record their timing.
+
+  \sa setRequestTimingEnabled()
+*/
+bool EnginioClientConnection::isRequestTimingEnabled() const
+{
+    Q_D(const EnginioClientConnection);
+    return d->_requestTiming;
+}
+
+/*!
+  \since 1.8
+  Enables or disables the timing of requests, it is disabled by default.
+
+  Requests sent while timing is enabled stamp each stage of their life, see
+  EnginioReply::timing(). When their finished signals were delivered, the
+  durations are added to the histograms of requestTimingStatistics().
+*/
+void EnginioClientConnection::setRequestTimingEnabled(bool enable)
+{
+    Q_D(EnginioClientConnection);
+    d->_requestTiming = enable;
+}
+
+/*!
+  \since 1.8
+  Returns a snapshot of the timing histograms of finished requests, per
+  Enginio::Operation. Requests sent with customRequest() are listed as
+  \c CustomRequest.
+
+  \code
+  {
+      "bounds": [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000],
+      "operations": {
+          "ObjectOperation": {
+              "total": { "count": 12, "min": 8.1, "max": 73.4, "mean": 19.5, "buckets": [0, 0, 0, 3, 6, 2, 1, 0, 0, 0, 0, 0, 0] },
+              "waiting": { ... },
+              ...
+          }
+      }
+  }
+  \endcode
+
+  The durations are in milliseconds. Each histogram has one bucket per
+  upper bound and a last bucket for everything slower. The phases are
+  \c queued (created to sent), \c waiting (sent to first byte),
+  \c receiving (first byte to finished), \c delivering (finished to
+  delivered), \c parsing, \c server (the Server-Timing durations, if sent)
+  and \c total. Phases without samples are left out.
+
+  \sa setRequestTimingEnabled(), resetRequestTimingStatistics()
+*/
+QJsonObject EnginioClientConnection::requestTimingStatistics() const
+{
+    Q_D(const EnginioClientConnection);
+    return d->_timingStatistics.toJson();
+}
+
+/*!
+  \since 1.8
+  Clears the histograms returned by requestTimingStatistics().
+*/
+void EnginioClientConnection::resetRequestTimingStatistics()
+{
+    Q_D(EnginioClientConnection);
+    d->_timingStatistics.clear();
+}
+
 /*!
   \brief Create custom request to the enginio REST API
 
@@ -524,6 +721,57 @@ EnginioReply* EnginioClient::query(const QJsonObject &query, const Enginio::Oper
     return ereply;
 }
 
+/*!
+  \brief Prepares \a query for the given \a operation to be sent repeatedly.
+
+  The request path and the encoded URL parameters of the query are computed
+  once. Sending the prepared query with query() only appends \c limit and
+  \c offset, which makes it cheap to fetch many pages of the same query.
+
+  The prepared query does not depend on the backend or the service URL,
+  it can be used with any client.
+
+  \since 1.8
+  \sa EnginioPreparedQuery
+*/
+EnginioPreparedQuery EnginioClient::prepareQuery(const QJsonObject &query, const Enginio::Operation operation) const
+{
+    return EnginioClientConnectionPrivate::prepareQuery<QJsonObject>(query, operation);
+}
+
+/*!
+  \overload
+  Sends the prepared \a query with the limit and offset it was prepared with.
+
+  \since 1.8
+  \sa prepareQuery()
+*/
+EnginioReply *EnginioClient::query(const EnginioPreparedQuery &query)
+{
+    return this->query(query, query.offset(), query.limit());
+}
+
+/*!
+  \overload
+  Sends the prepared \a query, requesting \a limit objects starting at \a offset.
+  A \a limit or \a offset of 0 is not sent to the backend.
+
+  \since 1.8
+  \sa prepareQuery()
+*/
+EnginioReply *EnginioClient::query(const EnginioPreparedQuery &query, int offset, int limit)
+{
+    Q_D(EnginioClient);
+
+    if (Q_UNLIKELY(query.isNull())) {
+        qWarning() << "EnginioClient::query(): the prepared query is null";
+        return 0;
+    }
+    QNetworkReply *nreply = d->query(query, offset, limit);
+    EnginioReply *ereply = new EnginioReply(d, nreply);
+    return ereply;
+}
+
 /*!
   \include client-create.qdocinc
 
@@ -686,14 +934,127 @@ QSharedPointer<QNetworkAccessManager> EnginioClientConnectionPrivate::prepareNet
     qnam = NetworkManager->localData().toStrongRef();
     if (!qnam) {
         qnam = QSharedPointer<QNetworkAccessManager>(new QNetworkAccessManager());
-#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0) && !defined(QT_NO_SSL) && !defined(ENGINIO_VALGRIND_DEBUG)
-        qnam->connectToHostEncrypted(EnginioString::apiEnginIo);
-#endif
         NetworkManager->setLocalData(qnam);
     }
     return qnam;
 }
 
+/*!
+  \internal
+  Warms up the connections from the event loop, so that setting the backend id
+  and the service url one after the other, in any order, warms up only the
+  final origin.
+*/
+void EnginioClientConnectionPrivate::schedulePrewarmConnections()
+{
+    if (_prewarmScheduled)
+        return;
+    _prewarmScheduled = true;
+    QTimer::singleShot(0, q_ptr, PrewarmConnectionsFunctor(this));
+}
+
+/*!
+  \internal
+  Opens connections to the configured service as soon as both the backend id
+  and the service url are known, so that the DNS lookup and the TCP and TLS
+  handshakes are done by the time the first request is sent. Each origin is
+  warmed up only once, the connections are kept by the shared QNetworkAccessManager.
+
+  Two connections are opened by default. The ENGINIO_PREWARM_CONNECTIONS
+  environment variable sets another count, 0 turns warming up off.
+*/
+void EnginioClientConnectionPrivate::prewarmConnections()
+{
+    _prewarmScheduled = false;
+    if (_backendId.isEmpty() || _serviceUrl.host().isEmpty())
+        return;
+
+    const bool encrypted = _serviceUrl.scheme() == EnginioString::https;
+    const quint16 port = _serviceUrl.port(encrypted ? 443 : 80);
+    const QString origin = _serviceUrl.scheme() + QStringLiteral("://") + _serviceUrl.host() + QLatin1Char(':') + QString::number(port);
+    if (origin == _prewarmedOrigin)
+        return;
+    _prewarmedOrigin = origin;
+
+    if (encrypted)
+        restoreTlsSession(port);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0) && !defined(ENGINIO_VALGRIND_DEBUG)
+    // QNetworkAccessManager uses up to six parallel connections per host,
+    // warming up more of them than that would only waste sockets.
+    const int count = qBound(0, _prewarmedConnectionCount, 6);
+    for (int i = 0; i < count; ++i) {
+#if !defined(QT_NO_SSL)
+        if (encrypted) {
+            _networkManager->connectToHostEncrypted(_serviceUrl.host(), port, _request.sslConfiguration());
+            continue;
+        }
+#endif
+        _networkManager->connectToHost(_serviceUrl.host(), port);
+    }
+#endif
+}
+
+/*!
+  \internal
+  Loads the TLS session ticket stored for the service by a previous run of the
+  application, letting the first handshake resume the session instead of doing
+  a full one. Persisting the tickets is opt-in: ENGINIO_TLS_SESSION_CACHE has
+  to name a directory writable only by the user.
+*/
+void EnginioClientConnectionPrivate::restoreTlsSession(quint16 port)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0) && !defined(QT_NO_SSL)
+    _tlsSessionFile.clear();
+    const QString directory = QString::fromLocal8Bit(qgetenv("ENGINIO_TLS_SESSION_CACHE"));
+    if (directory.isEmpty())
+        return;
+
+    _tlsSessionFile = QDir(directory).filePath(QStringLiteral("%1_%2.tlssession").arg(_serviceUrl.host()).arg(port));
+
+    QSslConfiguration conf = _request.sslConfiguration();
+    conf.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    QFile file(_tlsSessionFile);
+    if (file.open(QIODevice::ReadOnly))
+        conf.setSessionTicket(file.readAll());
+    _request.setSslConfiguration(conf);
+#else
+    Q_UNUSED(port);
+#endif
+}
+
+/*!
+  \internal
+  Stores the session ticket of a finished request if the server issued a new one.
+*/
+void EnginioClientConnectionPrivate::saveTlsSession(QNetworkReply *nreply)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0) && !defined(QT_NO_SSL)
+    if (nreply->url().host() != _serviceUrl.host())
+        return;
+
+    const QByteArray ticket = nreply->sslConfiguration().sessionTicket();
+    QSslConfiguration conf = _request.sslConfiguration();
+    if (ticket.isEmpty() || ticket == conf.sessionTicket())
+        return;
+
+    conf.setSessionTicket(ticket);
+    _request.setSslConfiguration(conf);
+
+    QSaveFile file(_tlsSessionFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Enginio: can not store the TLS session in" << _tlsSessionFile << file.errorString();
+        return;
+    }
+    // The ticket lets anybody resume the session, keep it private to the user.
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    file.write(ticket);
+    file.commit();
+#else
+    Q_UNUSED(nreply);
+#endif
+}
+
 Enginio::AuthenticationState EnginioClientConnection::authenticationState() const
 {
     Q_D(const EnginioClientConnection);
@@ -776,7 +1137,7 @@ void EnginioClientConnectionPrivate::uploadChunk(EnginioReplyState *ereply, QIOD
         serviceUrl.setPath(path);
     }
 
-    QNetworkRequest req = prepareRequest(serviceUrl);
+    QNetworkRequest req = prepareRequest(serviceUrl, Enginio::FileChunkUploadOperation);
     req.setHeader(QNetworkRequest::ContentTypeHeader, EnginioString::Application_octet_stream);
 
     // Content-Range: bytes {chunkStart}-{chunkEnd}/{totalFileSize}
@@ -36,6 +36,7 @@
 
 #include <Enginio/enginioclient_global.h>
 #include <Enginio/enginioclientconnection.h>
+#include <Enginio/enginiopreparedquery.h>
 #include <QtCore/qjsonobject.h>
 
 QT_BEGIN_NAMESPACE
@@ -59,6 +60,9 @@ public:
     Q_INVOKABLE EnginioReply *customRequest(const QUrl &url, const QByteArray &httpOperation, const QJsonObject &data = QJsonObject());
     Q_INVOKABLE EnginioReply *fullTextSearch(const QJsonObject &query);
     Q_INVOKABLE EnginioReply *query(const QJsonObject &query, const Enginio::Operation operation = Enginio::ObjectOperation);
+    EnginioPreparedQuery prepareQuery(const QJsonObject &query, const Enginio::Operation operation = Enginio::ObjectOperation) const Q_REQUIRED_RESULT;
+    EnginioReply *query(const EnginioPreparedQuery &query);
+    EnginioReply *query(const EnginioPreparedQuery &query, int offset, int limit);
     Q_INVOKABLE EnginioReply *create(const QJsonObject &object, const Enginio::Operation operation = Enginio::ObjectOperation);
     Q_INVOKABLE EnginioReply *update(const QJsonObject &object, const Enginio::Operation operation = Enginio::ObjectOperation);
     Q_INVOKABLE EnginioReply *remove(const QJsonObject &object, const Enginio::Operation operation = Enginio::ObjectOperation);
@@ -37,9 +37,15 @@
 #include <Enginio/enginioclient.h>
 #include <Enginio/enginioreply.h>
 #include <Enginio/private/enginiofakereply_p.h>
+#include <Enginio/private/enginiosharedreply_p.h>
 #include <Enginio/enginioidentity.h>
+#include <Enginio/enginiopreparedquery.h>
+#include <Enginio/private/enginiopreparedquery_p.h>
 #include <Enginio/private/enginioobjectadaptor_p.h>
 #include <Enginio/private/enginiostring_p.h>
+#include <Enginio/private/enginionotificationhub_p.h>
+#include <Enginio/private/enginiorequestlog_p.h>
+#include <Enginio/private/enginiorequesttiming_p.h>
 
 #include <QtNetwork/qnetworkaccessmanager.h>
 #include <QtCore/qpointer.h>
@@ -58,11 +64,14 @@
 #include <QtCore/qset.h>
 #include <QtCore/qlogging.h>
 #include <QtCore/qdebug.h>
+#include <QtCore/qelapsedtimer.h>
 
 #include <QtCore/private/qobject_p.h>
 
 QT_BEGIN_NAMESPACE
 
+struct EnginioModelStore;
+
 #define CHECK_AND_SET_URL_PATH_IMPL(Url, Object, Operation, Flags) \
     QString dataPropertyName; \
     {\
@@ -81,6 +90,23 @@ QT_BEGIN_NAMESPACE
 #define CHECK_AND_SET_PATH_WITH_ID(Url, Object, Operation) \
     CHECK_AND_SET_URL_PATH_IMPL(Url, Object, Operation, EnginioClientConnectionPrivate::RequireIdInPath)
 
+/*!
+  \internal
+  Generates the X-Request-Id of requests. Ids only have to be unique, not
+  unpredictable, so a xorshift128+ generator seeded once per client from
+  QUuid is enough.
+*/
+class ENGINIOCLIENT_EXPORT EnginioRequestIdGenerator
+{
+    quint64 _state[2];
+
+public:
+    EnginioRequestIdGenerator();
+
+    // 32 lower case hex characters, the format of a UUID without braces and dashes
+    QByteArray next() Q_REQUIRED_RESULT;
+};
+
 class ENGINIOCLIENT_EXPORT EnginioClientConnectionPrivate : public QObjectPrivate
 {
     enum PathOptions { Default, RequireIdInPath = 1};
@@ -296,8 +322,18 @@ public:
     QSharedPointer<QNetworkAccessManager> _networkManager;
     QMetaObject::Connection _networkManagerConnection;
     QNetworkRequest _request;
+    EnginioRequestIdGenerator _requestIds;
     QMap<QNetworkReply*, EnginioReplyState*> _replyReplyMap;
-    QMap<QNetworkReply*, QByteArray> _requestData;
+
+    // Queries in flight, identical ones sent meanwhile share their result
+    struct SharedQuery
+    {
+        QByteArray key;
+        QVector<QPointer<EnginioSharedReply> > followers;
+    };
+    QHash<QNetworkReply*, SharedQuery> _sharedQueries;
+    QHash<QByteArray, QNetworkReply*> _sharedQueryKeys;
+    EnginioRequestLog _requestLog;
 
     // device and last position
     QMap<QNetworkReply*, QPair<QIODevice*, qint64> > _chunkedUploads;
@@ -305,12 +341,36 @@ public:
     QJsonObject _identityToken;
     Enginio::AuthenticationState _authenticationState;
 
+    // Connections opened ahead of the first request, see prewarmConnections()
+    const static int DefaultPrewarmedConnectionCount = 2;
+    int _prewarmedConnectionCount;
+    bool _prewarmScheduled;
+    QString _prewarmedOrigin;
+    QString _tlsSessionFile;
+
     QSet<EnginioReplyState*> _delayedReplies; // Used only for testing
+    QPointer<EnginioNotificationHub> _notificationHub;
+    // Rows shared by the models with equal queries, by EnginioBaseModelPrivate::storeKey()
+    QHash<QByteArray, EnginioModelStore*> _modelStores;
+
+    // Opt-in timing of requests, the stamps are nanoseconds of _timingClock
+    bool _requestTiming;
+    QElapsedTimer _timingClock;
+    EnginioRequestTimingStatistics _timingStatistics;
 
     virtual void init();
 
+    EnginioNotificationHub *notificationHub()
+    {
+        // All models of the client share one notification connection.
+        if (!_notificationHub)
+            _notificationHub = new EnginioNotificationHub(this, q_ptr);
+        return _notificationHub;
+    }
+
     void replyFinished(QNetworkReply *nreply);
     bool finishDelayedReplies();
+    void deliverFinished(EnginioReplyState *ereply);
 
     void setAuthenticationState(const Enginio::AuthenticationState state)
     {
@@ -331,7 +391,7 @@ public:
         return _identityToken;
     }
 
-    QNetworkRequest prepareRequest(const QUrl &url);
+    QNetworkRequest prepareRequest(const QUrl &url, int operation = EnginioRequestTiming::CustomRequest);
 
     void registerReply(QNetworkReply *nreply, EnginioReplyState *ereply)
     {
@@ -405,8 +465,8 @@ public:
 
         QNetworkReply *reply = networkManager()->sendCustomRequest(req, httpOperation, buffer);
 
-        if (gEnableEnginioDebugInfo && !payload.isEmpty())
-            _requestData.insert(reply, payload);
+        if (_requestLog.sample())
+            _requestLog.record(reply, payload);
 
         if (buffer)
             buffer->setParent(reply);
@@ -420,14 +480,14 @@ public:
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH_WITH_ID(url, object, operation);
 
-        QNetworkRequest req = prepareRequest(url);
+        QNetworkRequest req = prepareRequest(url, operation);
 
         QByteArray data = dataPropertyName.isEmpty() ? object.toJson() : object[dataPropertyName].toJson();
 
         QNetworkReply *reply = networkManager()->put(req, data);
 
-        if (gEnableEnginioDebugInfo)
-            _requestData.insert(reply, data);
+        if (_requestLog.sample())
+            _requestLog.record(reply, data);
 
         return reply;
     }
@@ -438,7 +498,7 @@ public:
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH_WITH_ID(url, object, operation);
 
-        QNetworkRequest req = prepareRequest(url);
+        QNetworkRequest req = prepareRequest(url, operation);
 
         QNetworkReply *reply = 0;
         QByteArray data;
@@ -461,8 +521,8 @@ public:
 
         Q_ASSERT(reply);
 
-        if (gEnableEnginioDebugInfo && !data.isEmpty())
-            _requestData.insert(reply, data);
+        if (_requestLog.sample())
+            _requestLog.record(reply, data);
 
         return reply;
     }
@@ -474,32 +534,34 @@ public:
 
         CHECK_AND_SET_PATH(url, object, operation);
 
-        QNetworkRequest req = prepareRequest(url);
+        QNetworkRequest req = prepareRequest(url, operation);
 
         QByteArray data = dataPropertyName.isEmpty() ? object.toJson() : object[dataPropertyName].toJson();
 
         QNetworkReply *reply = networkManager()->post(req, data);
 
-        if (gEnableEnginioDebugInfo)
-            _requestData.insert(reply, data);
+        if (_requestLog.sample())
+            _requestLog.record(reply, data);
 
         return reply;
     }
 
     template<class T>
-    QNetworkReply *query(const ObjectAdaptor<T> &object, const Enginio::Operation operation)
+    static EnginioPreparedQuery prepareQuery(const ObjectAdaptor<T> &object, const Enginio::Operation operation)
     {
-        QUrl url(_serviceUrl);
-        CHECK_AND_SET_PATH(url, object, operation);
+        EnginioPreparedQueryPrivate *prepared = new EnginioPreparedQueryPrivate;
+        EnginioPreparedQuery result = EnginioPreparedQueryPrivate::create(prepared);
+        prepared->_operation = operation;
+
+        GetPathReturnValue ret = getPath(object, operation, &prepared->_path, &prepared->_errorMessage);
+        if (!ret.successful())
+            return result;
+
+        prepared->_limit = object[EnginioString::limit].toInt();
+        prepared->_offset = object[EnginioString::offset].toInt();
 
         // TODO add all params here
         QUrlQuery urlQuery;
-        if (int limit = object[EnginioString::limit].toInt()) {
-            urlQuery.addQueryItem(EnginioString::limit, QString::number(limit));
-        }
-        if (int offset = object[EnginioString::offset].toInt()) {
-            urlQuery.addQueryItem(EnginioString::offset, QString::number(offset));
-        }
         if (object.contains(EnginioString::count)) { // TODO docs are saying about integer but it is not interpreted.
             urlQuery.addQueryItem(EnginioString::count, QString(0, Qt::Uninitialized));
         }
@@ -516,8 +578,10 @@ public:
         if (operation == Enginio::SearchOperation) {
             ValueAdaptor<T> search = object[EnginioString::search];
             ArrayAdaptor<T> objectTypes = object[EnginioString::objectTypes].toArray();
-            if (Q_UNLIKELY(objectTypes.isEmpty()))
-                return new EnginioFakeReply(this, constructErrorMessage(EnginioString::Fulltext_Search_objectTypes_parameter_is_missing_or_it_is_not_an_array));
+            if (Q_UNLIKELY(objectTypes.isEmpty())) {
+                prepared->_errorMessage = constructErrorMessage(EnginioString::Fulltext_Search_objectTypes_parameter_is_missing_or_it_is_not_an_array);
+                return result;
+            }
             if (search.isComposedType()) {
                 for (typename ArrayAdaptor<T>::const_iterator i = objectTypes.constBegin(); i != objectTypes.constEnd(); ++i) {
                     urlQuery.addQueryItem(QStringLiteral("objectTypes[]"), (*i).toString());
@@ -525,17 +589,68 @@ public:
                 urlQuery.addQueryItem(EnginioString::search,
                     QString::fromUtf8(search.toJson()));
             } else {
-                return new EnginioFakeReply(this, constructErrorMessage(EnginioString::Fulltext_Search_search_parameter_missing));
+                prepared->_errorMessage = constructErrorMessage(EnginioString::Fulltext_Search_search_parameter_missing);
+                return result;
             }
         } else
         if (object[EnginioString::query].isComposedType()) { // TODO docs are inconsistent on that
             urlQuery.addQueryItem(QStringLiteral("q"),
                 QString::fromUtf8(object[EnginioString::query].toJson()));
         }
-        url.setQuery(urlQuery);
+        prepared->_encodedQueryItems = urlQuery.query(QUrl::FullyEncoded);
+        return result;
+    }
 
-        QNetworkRequest req = prepareRequest(url);
-        return networkManager()->get(req);
+    QNetworkReply *query(const EnginioPreparedQuery &preparedQuery, int offset, int limit)
+    {
+        const EnginioPreparedQueryPrivate *prepared = EnginioPreparedQueryPrivate::get(preparedQuery);
+        Q_ASSERT(prepared);
+        if (!prepared->_errorMessage.isEmpty())
+            return new EnginioFakeReply(this, prepared->_errorMessage);
+
+        QUrl url(_serviceUrl);
+        url.setPath(prepared->_path);
+
+        // Only limit and offset change between pages, the rest is already encoded
+        QString query;
+        query.reserve(prepared->_encodedQueryItems.size() + 32);
+        if (limit) {
+            query.append(EnginioString::limit);
+            query.append(QLatin1Char('='));
+            query.append(QString::number(limit));
+        }
+        if (offset) {
+            if (!query.isEmpty())
+                query.append(QLatin1Char('&'));
+            query.append(EnginioString::offset);
+            query.append(QLatin1Char('='));
+            query.append(QString::number(offset));
+        }
+        if (!prepared->_encodedQueryItems.isEmpty()) {
+            if (!query.isEmpty())
+                query.append(QLatin1Char('&'));
+            query.append(prepared->_encodedQueryItems);
+        }
+        if (!query.isEmpty())
+            url.setQuery(query);
+
+        QNetworkRequest req = prepareRequest(url, prepared->_operation);
+        return sharedGet(req);
+    }
+
+    QNetworkReply *sharedGet(const QNetworkRequest &request);
+    void finishSharedQuery(QNetworkReply *nreply, EnginioReplyState *ereply);
+
+    bool hasSharedQueryFollowers(QNetworkReply *nreply) const Q_REQUIRED_RESULT
+    {
+        return !_sharedQueries.value(nreply).followers.isEmpty();
+    }
+
+    template<class T>
+    QNetworkReply *query(const ObjectAdaptor<T> &object, const Enginio::Operation operation)
+    {
+        EnginioPreparedQuery prepared = prepareQuery(object, operation);
+        return query(prepared, prepared.offset(), prepared.limit());
     }
 
     template<class T>
@@ -550,7 +665,7 @@ public:
             url.setQuery(query);
         }
 
-        QNetworkRequest req = prepareRequest(url);
+        QNetworkRequest req = prepareRequest(url, Enginio::FileGetDownloadUrlOperation);
 
         QNetworkReply *reply = networkManager()->get(req);
         return reply;
@@ -591,10 +706,8 @@ public:
         else
             reply = uploadChunked(object, device);
 
-        if (gEnableEnginioDebugInfo) {
-            QByteArray data = object.toJson();
-            _requestData.insert(reply, data);
-        }
+        if (_requestLog.sample())
+            _requestLog.record(reply, object.toJson());
 
         return reply;
     }
@@ -605,8 +718,29 @@ public:
     }
 
     void assignNetworkManager();
+    void schedulePrewarmConnections();
+    void prewarmConnections();
+    void restoreTlsSession(quint16 port);
+    void saveTlsSession(QNetworkReply *nreply);
     static QSharedPointer<QNetworkAccessManager> prepareNetworkManagerInThread() Q_REQUIRED_RESULT;
 
+    class PrewarmConnectionsFunctor
+    {
+    public:
+        PrewarmConnectionsFunctor(EnginioClientConnectionPrivate *client)
+            : _client(client)
+        {
+            Q_ASSERT(_client);
+        }
+
+        void operator ()()
+        {
+            _client->prewarmConnections();
+        }
+    private:
+        EnginioClientConnectionPrivate *_client;
+    };
+
     class UploadProgressFunctor
     {
     public:
@@ -651,7 +785,7 @@ private:
         QUrl serviceUrl = _serviceUrl;
         CHECK_AND_SET_PATH(serviceUrl, QJsonObject(), Enginio::FileOperation);
 
-        QNetworkRequest req = prepareRequest(serviceUrl);
+        QNetworkRequest req = prepareRequest(serviceUrl, Enginio::FileOperation);
         req.setHeader(QNetworkRequest::ContentTypeHeader, QByteArray());
 
         QHttpMultiPart *multiPart = createHttpMultiPart(object, device, mimeType);
@@ -697,7 +831,7 @@ private:
         QUrl serviceUrl = _serviceUrl;
         CHECK_AND_SET_PATH(serviceUrl, QJsonObject(), Enginio::FileOperation);
 
-        QNetworkRequest req = prepareRequest(serviceUrl);
+        QNetworkRequest req = prepareRequest(serviceUrl, Enginio::FileOperation);
 
         QNetworkReply *reply = networkManager()->post(req, object.toJson());
         _chunkedUploads.insert(reply, qMakePair(device, static_cast<qint64>(0)));
@@ -41,6 +41,7 @@
 #include <QtCore/qtypeinfo.h>
 #include <QtCore/qmetatype.h>
 #include <QtCore/qurl.h>
+#include <QtCore/qjsonobject.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -74,6 +75,11 @@ public:
     void setServiceUrl(const QUrl &serviceUrl);
     QNetworkAccessManager *networkManager() const Q_REQUIRED_RESULT;
 
+    bool isRequestTimingEnabled() const Q_REQUIRED_RESULT;
+    void setRequestTimingEnabled(bool enable);
+    QJsonObject requestTimingStatistics() const Q_REQUIRED_RESULT;
+    void resetRequestTimingStatistics();
+
     bool finishDelayedReplies();
 
 Q_SIGNALS:
@@ -184,7 +184,7 @@ public:
         QUrl url(enginio->_serviceUrl);
         url.setPath(EnginioString::v1_auth_oauth2_token);
 
-        QNetworkRequest request(enginio->prepareRequest(url));
+        QNetworkRequest request(enginio->prepareRequest(url, Enginio::SessionOperation));
         request.setHeader(QNetworkRequest::ContentTypeHeader, EnginioString::Application_x_www_form_urlencoded);
         request.setRawHeader(EnginioString::Accept, EnginioString::Application_json);
 
@@ -44,10 +44,18 @@
 #include <QtCore/qvector.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
 const int EnginioBaseModelPrivate::IncrementalModelUpdate = -2;
+// Matching fewer rows takes less than a millisecond, it is not worth a thread.
+const int EnginioBaseModelPrivate::OffThreadDiffRows = 10000;
+// A few screens of delegates, views read the same rows again on every layout.
+const int EnginioBaseModelPrivate::CachedRows = 256;
+const static int GapRecoveryLimit = 100;
 
 /*!
   \class EnginioModel
@@ -99,6 +107,13 @@ const int EnginioBaseModelPrivate::IncrementalModelUpdate = -2;
 
   \note EnginioClient emits the finished and error signals for the model, not the model itself.
 
+  Models of the same client with equal queries share their rows. Only one
+  of them queries the backend and follows its notifications, the others
+  show the same rows and forward their changes to it. When that model is
+  deleted or its query changes, another one of them takes over the rows,
+  including the appended rows the backend did not create yet, and reloads
+  them.
+
   The \l{EnginioModel::query}{query} can contain one or more options:
   The "sort" option, to get presorted data:
   \code
@@ -150,26 +165,115 @@ EnginioBaseModelPrivate::~EnginioBaseModelPrivate()
     foreach (const QMetaObject::Connection &connection, _clientConnections)
         QObject::disconnect(connection);
 
+    // The public object is gone already, its views are not notified
+    leaveStore();
+
+    abortQueryReplies();
     delete _replyConnectionConntext;
 }
 
-void EnginioBaseModelPrivate::receivedNotification(const QJsonObject &data)
+void EnginioBaseModelPrivate::receivedNotification(const EnginioNotification &notification)
 {
-    const QJsonObject origin = data[EnginioString::origin].toObject();
-    const QString requestId = origin[EnginioString::apiRequestId].toString();
+    // The object itself is only needed if the model changes, this way
+    // echoes of our own requests and deletes are handled without parsing it.
+    const QString requestId = notification.requestId();
     if (_attachedData.markRequestIdAsHandled(requestId))
         return; // request was handled
 
-    QJsonObject object = data[EnginioString::data].toObject();
-    QString event = data[EnginioString::event].toString();
-    if (event == EnginioString::update) {
-        receivedUpdateNotification(object);
-    } else if (event == EnginioString::_delete) {
-        receivedRemoveNotification(object);
-    } else  if (event == EnginioString::create) {
+    switch (notification.event()) {
+    case EnginioNotification::UpdateEvent: {
+        const QString id = notification.objectId();
+        if (_attachedData.hasRow(id))
+            receivedUpdateNotification(notification.data(), id);
+        else if (_queryMatcher.matches(notification.data()))
+            receivedCreateNotification(notification.data()); // the object matches the query now
+        break;
+    }
+    case EnginioNotification::DeleteEvent: {
+        const QString id = notification.objectId();
+        if (!_attachedData.contains(id))
+            return; // removing not existing object
+        receivedRemoveNotification(QJsonObject(), _attachedData.rowFromObjectId(id));
+        break;
+    }
+    case EnginioNotification::CreateEvent: {
         const int rowHint = _attachedData.rowFromRequestId(requestId);
         if (rowHint != NoHintRow)
-            receivedUpdateNotification(object, QString(), rowHint);
+            receivedUpdateNotification(notification.data(), QString(), rowHint);
+        else if (_attachedData.hasRow(notification.objectId()))
+            receivedUpdateNotification(notification.data()); // already fetched after a reconnect
+        else if (_queryMatcher.matches(notification.data()))
+            receivedCreateNotification(notification.data());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/*!
+  \internal
+  Fetches the objects changed while the notification connection was down,
+  instead of resetting the whole model. Only objects with a newer "updatedAt"
+  than the latest one known are requested. Objects removed in the meantime
+  can not be found this way, they stay in the model until the next reload.
+*/
+void EnginioBaseModelPrivate::recoverNotificationGap()
+{
+    if (!_enginio || _enginio->_backendId.isEmpty() || queryIsEmpty())
+        return;
+
+    QJsonObject query = queryAsJson();
+    if (!_updatedAtHighWaterMark.isEmpty()) {
+        QJsonObject time;
+        time[EnginioString::_type] = EnginioString::time;
+        time[EnginioString::_value] = _updatedAtHighWaterMark;
+        QJsonObject greaterThan;
+        greaterThan[EnginioString::_gt] = time;
+        QJsonObject changedLater;
+        changedLater[EnginioString::updatedAt] = greaterThan;
+
+        const QJsonObject filter = query[EnginioString::query].toObject();
+        if (filter.isEmpty()) {
+            query[EnginioString::query] = changedLater;
+        } else {
+            QJsonArray conditions;
+            conditions.append(filter);
+            conditions.append(changedLater);
+            QJsonObject both;
+            both[EnginioString::_and] = conditions;
+            query[EnginioString::query] = both;
+        }
+    }
+    query.remove(EnginioString::offset);
+    query[EnginioString::limit] = GapRecoveryLimit;
+
+    ObjectAdaptor<QJsonObject> aQuery(query);
+    QNetworkReply *nreply = _enginio->query(aQuery, static_cast<Enginio::Operation>(_operation));
+    EnginioReplyState *ereply = _enginio->createReply(nreply);
+    QObject::connect(ereply, &EnginioReplyState::dataChanged, ereply, &EnginioReplyState::deleteLater);
+    FinishedGapRecoveryRequest finishedRequest = { this, ereply };
+    QObject::connect(ereply, &EnginioReplyState::dataChanged, _replyConnectionConntext, finishedRequest);
+}
+
+void EnginioBaseModelPrivate::finishedGapRecoveryRequest(const EnginioReplyState *reply)
+{
+    if (reply->isError())
+        return;
+
+    const QJsonArray results = replyData(reply)[EnginioString::results].toArray();
+    if (results.count() >= GapRecoveryLimit) {
+        // Too much has changed, there may be more objects than we asked for.
+        EnginioReplyState *ereply = reload();
+        QObject::connect(ereply, &EnginioReplyState::dataChanged, ereply, &EnginioReplyState::deleteLater);
+        return;
+    }
+
+    // The results match the query, objects it filtered out before come back
+    foreach (const QJsonValue &value, results) {
+        const QJsonObject object = value.toObject();
+        if (_attachedData.hasRow(EnginioObjectProperties::objectId(object)))
+            receivedUpdateNotification(object);
         else
             receivedCreateNotification(object);
     }
@@ -179,7 +283,7 @@ void EnginioBaseModelPrivate::receivedRemoveNotification(const QJsonObject &obje
 {
     int row = rowHint;
     if (rowHint == NoHintRow) {
-        QString id = object[EnginioString::id].toString();
+        const QString id = EnginioObjectProperties::objectId(object);
         if (Q_UNLIKELY(!_attachedData.contains(id))) {
             // removing not existing object
             return;
@@ -190,6 +294,7 @@ void EnginioBaseModelPrivate::receivedRemoveNotification(const QJsonObject &obje
         return;
 
     q->beginRemoveRows(QModelIndex(), row, row);
+    removeFromPropertyIndexes(_data.at(row).toObject(), indexedObjectId(row));
     _data.removeAt(row);
     // we need to updates rows in _attachedData
     _attachedData.updateAllDataAfterRowRemoval(row);
@@ -200,7 +305,7 @@ void EnginioBaseModelPrivate::receivedUpdateNotification(const QJsonObject &obje
 {
     // update an existing object
     if (row == NoHintRow) {
-        QString id = idHint.isEmpty() ? object[EnginioString::id].toString() : idHint;
+        const QString id = idHint.isEmpty() ? EnginioObjectProperties::objectId(object) : idHint;
         Q_ASSERT(_attachedData.contains(id));
         row = _attachedData.rowFromObjectId(id);
     }
@@ -212,18 +317,24 @@ void EnginioBaseModelPrivate::receivedUpdateNotification(const QJsonObject &obje
     if (Q_UNLIKELY(row < 0))
         return;
 
-    QJsonObject current = _data[row].toObject();
-    QDateTime currentUpdateAt = QDateTime::fromString(current[EnginioString::updatedAt].toString(), Qt::ISODate);
-    QDateTime newUpdateAt = QDateTime::fromString(object[EnginioString::updatedAt].toString(), Qt::ISODate);
+    const QJsonObject current = _data.at(row).toObject();
+    const QString currentId = indexedObjectId(row);
+    QDateTime currentUpdateAt = QDateTime::fromString(EnginioObjectProperties::updatedAt(current), Qt::ISODate);
+    QDateTime newUpdateAt = QDateTime::fromString(EnginioObjectProperties::updatedAt(object), Qt::ISODate);
     if (newUpdateAt < currentUpdateAt) {
         // we already have a newer version
         return;
     }
-    if (_data[row].toObject()[EnginioString::id].toString().isEmpty()) {
+    if (!_queryMatcher.matches(object) && !EnginioObjectProperties::objectId(current).isEmpty()) {
+        // the object does not match the query anymore
+        receivedRemoveNotification(object, row);
+        return;
+    }
+    if (EnginioObjectProperties::objectId(current).isEmpty()) {
         // Create and update may go through the same code path because
         // the model already have a dummy item. No id means that it
         // is a dummy item.
-        const QString newId = object[EnginioString::id].toString();
+        const QString newId = EnginioObjectProperties::objectId(object);
         AttachedData newData(row, newId);
         _attachedData.insert(newData);
     }
@@ -233,39 +344,210 @@ void EnginioBaseModelPrivate::receivedUpdateNotification(const QJsonObject &obje
         syncRoles();
         q->endResetModel();
     } else {
+        removeFromPropertyIndexes(current, currentId);
+        insertIntoPropertyIndexes(object);
         _data.replace(row, object);
         emit q->dataChanged(q->index(row), q->index(row));
+        moveToSortedRow(row);
     }
+    updateHighWaterMark(object);
 }
 
 void EnginioBaseModelPrivate::fullQueryReset(const QJsonArray &data)
 {
     delete _replyConnectionConntext;
     _replyConnectionConntext = new QObject();
+    cancelDiff();
     q->beginResetModel();
     _data = data;
     _attachedData.initFromArray(_data);
+    _updatedAtHighWaterMark.clear();
+    for (QJsonArray::const_iterator it = _data.constBegin(); it != _data.constEnd(); ++it)
+        updateHighWaterMark((*it).toObject());
     syncRoles();
     _canFetchMore = _canFetchMore && _data.count() && (queryData(EnginioString::limit).toDouble() <= _data.count());
     q->endResetModel();
 }
 
+/*!
+  \internal
+  Replaces the rows by the result of a reloaded query. Logins, logouts and
+  re-executed queries mostly return the rows the model has already, so only
+  the rows which differ are removed, moved, inserted or changed. Views keep
+  their scroll position and the delegates of the other rows.
+*/
+void EnginioBaseModelPrivate::updateFromQueryResult(const QJsonArray &data)
+{
+    cancelDiff();
+    if (!hasRolesFor(data)) {
+        fullQueryReset(data);
+        return;
+    }
+
+    if (_data.count() + data.count() < OffThreadDiffRows) {
+        applyDiff(EnginioModelDiff::compute(_data, data), data);
+        return;
+    }
+
+    _diffWatcher = new QFutureWatcher<EnginioModelDiff>(q);
+    FinishedDiff finished = { this, _diffWatcher, _data, data };
+    QObject::connect(_diffWatcher, &QFutureWatcherBase::finished, finished);
+    _diffWatcher->setFuture(EnginioModelDiff::computeInThreadPool(_data, data));
+}
+
+void EnginioBaseModelPrivate::finishedDiff(QFutureWatcher<EnginioModelDiff> *watcher, const QJsonArray &from, const QJsonArray &to)
+{
+    if (watcher != _diffWatcher)
+        return;
+    _diffWatcher = 0;
+    watcher->deleteLater();
+
+    // Notifications or local changes may have changed the rows in the meantime,
+    // the arrays share their data as long as they did not.
+    if (_data == from)
+        applyDiff(watcher->result(), to);
+    else
+        applyDiff(EnginioModelDiff::compute(_data, to), to);
+}
+
+void EnginioBaseModelPrivate::cancelDiff()
+{
+    if (!_diffWatcher)
+        return;
+    _diffWatcher->cancel();
+    delete _diffWatcher;
+    _diffWatcher = 0;
+}
+
+void EnginioBaseModelPrivate::applyDiff(const EnginioModelDiff &diff, const QJsonArray &data)
+{
+    if (diff.isReset()) {
+        fullQueryReset(data);
+        return;
+    }
+
+    // The attached data follows every step, views may ask for the synced
+    // role of any row when a step ends. Rows with pending requests keep
+    // their state, appended rows without an id yet are removed as any
+    // other row the result does not contain.
+    foreach (const EnginioModelDiff::Step &step, diff.steps()) {
+        switch (step.type) {
+        case EnginioModelDiff::RemoveRows:
+            q->beginRemoveRows(QModelIndex(), step.first, step.last);
+            for (int row = step.last; row >= step.first; --row)
+                _data.removeAt(row);
+            _attachedData.updateAllDataAfterRowRemoval(step.first, step.last - step.first + 1);
+            q->endRemoveRows();
+            break;
+        case EnginioModelDiff::MoveRows: {
+            q->beginMoveRows(QModelIndex(), step.first, step.last, QModelIndex(), step.destination);
+            const int count = step.last - step.first + 1;
+            const int target = step.destination > step.first ? step.destination - count : step.destination;
+            QJsonArray rows;
+            for (int row = step.first; row <= step.last; ++row)
+                rows.append(_data.at(row));
+            for (int row = step.last; row >= step.first; --row)
+                _data.removeAt(row);
+            for (int i = 0; i < count; ++i)
+                _data.insert(target + i, rows.at(i));
+            _attachedData.updateAllDataAfterRowMove(step.first, target, count);
+            q->endMoveRows();
+            break;
+        }
+        case EnginioModelDiff::InsertRows:
+            q->beginInsertRows(QModelIndex(), step.first, step.last);
+            for (int row = step.first; row <= step.last; ++row)
+                _data.insert(row, data.at(row));
+            _attachedData.updateAllDataAfterRowInsertion(step.first, step.last - step.first + 1);
+            for (int row = step.first; row <= step.last; ++row)
+                _attachedData.insert(AttachedData(row, EnginioObjectProperties::objectId(data.at(row).toObject())));
+            q->endInsertRows();
+            break;
+        case EnginioModelDiff::ChangeRows:
+            break;
+        }
+    }
+
+    // The rows are in the final order now, take over the changed content.
+    Q_ASSERT(_data.count() == data.count());
+    _data = data;
+    _updatedAtHighWaterMark.clear();
+    for (QJsonArray::const_iterator it = _data.constBegin(); it != _data.constEnd(); ++it)
+        updateHighWaterMark((*it).toObject());
+    rebuildPropertyIndexes();
+    _canFetchMore = _canFetchMore && _data.count() && (queryData(EnginioString::limit).toDouble() <= _data.count());
+
+    foreach (const EnginioModelDiff::Step &step, diff.steps()) {
+        if (step.type == EnginioModelDiff::ChangeRows)
+            emit q->dataChanged(q->index(step.first), q->index(step.last));
+    }
+}
+
+/*!
+  \internal
+  Returns true if the roles of the model cover the properties of \a data,
+  otherwise the model has to be reset for the views to pick up new roles.
+*/
+bool EnginioBaseModelPrivate::hasRolesFor(const QJsonArray &data) const
+{
+    if (_roles.isEmpty() || data.isEmpty())
+        return false;
+    // The roles are estimated from the first object, see syncRoles().
+    const QJsonObject firstObject = data.first().toObject();
+    const QSet<QString> definedRoles = _roles.values().toSet();
+    for (QJsonObject::const_iterator i = firstObject.constBegin(); i != firstObject.constEnd(); ++i) {
+        if (!definedRoles.contains(i.key()))
+            return false;
+    }
+    return true;
+}
+
 void EnginioBaseModelPrivate::receivedCreateNotification(const QJsonObject &object)
 {
     // create a new object
-    QString id = object[EnginioString::id].toString();
-    Q_ASSERT(!_attachedData.contains(id));
+    const QString id = EnginioObjectProperties::objectId(object);
+    Q_ASSERT(!_attachedData.hasRow(id));
     AttachedData data;
-    data.row = _data.count();
+    data.row = _sortOrder.isEmpty() ? _data.count() : _sortOrder.insertionRow(_data, object);
     data.id = id;
-    q->beginInsertRows(QModelIndex(), _data.count(), _data.count());
+    q->beginInsertRows(QModelIndex(), data.row, data.row);
+    if (data.row == _data.count()) {
+        _data.append(object);
+    } else {
+        _data.insert(data.row, object);
+        _attachedData.updateAllDataAfterRowInsertion(data.row);
+    }
     _attachedData.insert(data);
-    _data.append(object);
+    updateHighWaterMark(object);
+    insertIntoPropertyIndexes(object);
     q->endInsertRows();
 }
 
+/*!
+  \internal
+  Moves the object at \a row to the row the sort order of the query puts
+  it at, if a change of its properties took it out of order.
+*/
+void EnginioBaseModelPrivate::moveToSortedRow(int row)
+{
+    if (_sortOrder.isEmpty() || _sortOrder.isInOrder(_data, row))
+        return;
+
+    const QJsonValue object = _data.at(row);
+    const int sortedRow = _sortOrder.insertionRow(_data, object.toObject(), row);
+    if (sortedRow == row)
+        return;
+
+    q->beginMoveRows(QModelIndex(), row, row, QModelIndex(), sortedRow > row ? sortedRow + 1 : sortedRow);
+    _data.removeAt(row);
+    _data.insert(sortedRow, object);
+    _attachedData.updateAllDataAfterRowMove(row, sortedRow);
+    q->endMoveRows();
+}
+
 void EnginioBaseModelPrivate::syncRoles()
 {
+    _cellCache.clear();
     QJsonObject firstObject(_data.first().toObject());
 
     if (!_roles.count()) {
@@ -303,6 +585,269 @@ void EnginioBaseModelPrivate::syncRoles()
             _roles[_rolesCounter++] = i.key();
         }
     }
+    rebuildPropertyIndexes();
+}
+
+/*!
+  \internal
+  Returns the rows in which the property of \a role equals \a value, in
+  ascending order. With an index for the role the rows are found by the
+  ids of the objects, or the temporary ids of appended rows, otherwise all
+  rows are compared.
+*/
+QList<int> EnginioBaseModelPrivate::rowsMatching(int role, const QVariant &value, bool firstOnly) const
+{
+    if (isStoreFollower())
+        return _store->owner->rowsMatching(role, value, firstOnly);
+    QList<int> rows;
+    const QJsonValue jsonValue = QJsonValue::fromVariant(value);
+    const QHash<int, EnginioPropertyIndex>::const_iterator index = _propertyIndexes.constFind(role);
+    if (index != _propertyIndexes.constEnd() && !index.value().property().isEmpty()) {
+        foreach (const QString &id, index.value().objectIds(jsonValue)) {
+            if (!_attachedData.contains(id))
+                continue;
+            const int row = _attachedData.rowFromObjectId(id);
+            if (row >= 0)
+                rows.append(row);
+        }
+        std::sort(rows.begin(), rows.end());
+        if (firstOnly && rows.count() > 1)
+            rows.erase(rows.begin() + 1, rows.end());
+        return rows;
+    }
+
+    const QString property = _roles.value(role);
+    if (property.isEmpty())
+        return rows;
+    for (int row = 0; row < _data.count(); ++row) {
+        if (_data.at(row).toObject().value(property) == jsonValue) {
+            rows.append(row);
+            if (firstOnly)
+                break;
+        }
+    }
+    return rows;
+}
+
+/*!
+  \internal
+  The key of the store of the current query. QJsonDocument writes the keys
+  of objects sorted, so equal queries give equal keys. The class name
+  keeps the C++ and the QML model apart, their replies and values differ.
+*/
+QByteArray EnginioBaseModelPrivate::storeKey() const
+{
+    QByteArray key(q->metaObject()->className());
+    key += '/';
+    key += QByteArray::number(_operation);
+    key += '/';
+    key += QJsonDocument(queryAsJson()).toJson(QJsonDocument::Compact);
+    return key;
+}
+
+/*!
+  \internal
+  Attaches the model to the store of its query. The first model of a query
+  becomes the owner of the store and returns false, it has to query the
+  backend itself. Later ones follow the owner and return true, they send
+  no query and do not subscribe to notifications.
+*/
+bool EnginioBaseModelPrivate::attachToStore()
+{
+    const QByteArray key = storeKey();
+    if (_store && _store->client == _enginio && _store->key == key)
+        return isStoreFollower(); // executed again, e.g. after a login
+
+    detachFromStore();
+    EnginioModelStore *store = _enginio->_modelStores.value(key);
+    if (!store) {
+        store = new EnginioModelStore;
+        store->key = key;
+        store->client = _enginio;
+        store->owner = this;
+        _enginio->_modelStores.insert(key, store);
+        _store = store;
+        return false;
+    }
+
+    q->beginResetModel();
+    delete _replyConnectionConntext;
+    _replyConnectionConntext = new QObject();
+    cancelDiff();
+    _notifications.disconnectFromBackend();
+    // Indexes the model asked for are kept by the owner from now on
+    foreach (int role, _propertyIndexes.keys())
+        store->owner->createRoleIndex(role);
+    _propertyIndexes.clear();
+    _data = QJsonArray();
+    _attachedData.initFromArray(_data);
+    _store = store;
+    store->followers.append(this);
+    followStoreOwner();
+    q->endResetModel();
+    return true;
+}
+
+void EnginioBaseModelPrivate::detachFromStore()
+{
+    if (!isStoreFollower()) {
+        const bool shared = _store && !_store->followers.isEmpty();
+        leaveStore();
+        // The follower taking over the rows reloads them, the replies
+        // must not change the rows of this model once its query changed.
+        if (shared)
+            dropPendingChanges();
+        return;
+    }
+
+    // The views of a follower showed the rows of the owner
+    q->beginResetModel();
+    leaveStore();
+    q->endResetModel();
+}
+
+/*!
+  \internal
+  Removes the model from its store. If the owner leaves, the follower which
+  attached first takes over its rows and resumes the notifications and
+  queries. The new owner handles the replies to the appended rows which
+  were not created yet, the replies to other changes sent by the old owner
+  are handled by the old owner, so the new owner reloads the rows to catch
+  up with them.
+*/
+void EnginioBaseModelPrivate::leaveStore()
+{
+    EnginioModelStore *store = _store;
+    if (!store)
+        return;
+    _store = 0;
+
+    if (store->owner != this) {
+        unfollowStoreOwner();
+        store->followers.removeOne(this);
+        return;
+    }
+
+    if (store->followers.isEmpty()) {
+        store->client->_modelStores.remove(store->key);
+        delete store;
+        return;
+    }
+
+    EnginioBaseModelPrivate *owner = store->followers.takeFirst();
+    owner->unfollowStoreOwner();
+    owner->_data = _data;
+    owner->_attachedData = _attachedData;
+    owner->_roles = _roles;
+    owner->_rolesCounter = _rolesCounter;
+    owner->_propertyIndexes = _propertyIndexes;
+    owner->_canFetchMore = _canFetchMore;
+    owner->_latestRequestedOffset = _latestRequestedOffset;
+    owner->_updatedAtHighWaterMark = _updatedAtHighWaterMark;
+    store->owner = owner;
+    foreach (EnginioBaseModelPrivate *follower, store->followers) {
+        follower->unfollowStoreOwner();
+        follower->followStoreOwner();
+    }
+    owner->adoptPendingCreates();
+    // The model may be left because the client is destroyed, the new
+    // owner is detached then too before the event loop runs again.
+    QTimer::singleShot(0, owner->q, ResumeAsStoreOwner(owner));
+}
+
+/*!
+  \internal
+  Forgets the changes which did not finish yet, their replies are not
+  handled anymore. Appended rows without an id are removed, their objects
+  come back with the notifications or the next reload.
+*/
+void EnginioBaseModelPrivate::dropPendingChanges()
+{
+    delete _replyConnectionConntext;
+    _replyConnectionConntext = new QObject();
+    for (int row = _data.count() - 1; row >= 0; --row) {
+        if (!EnginioObjectProperties::objectId(_data.at(row).toObject()).isEmpty())
+            continue;
+        q->beginRemoveRows(QModelIndex(), row, row);
+        removeFromPropertyIndexes(_data.at(row).toObject(), indexedObjectId(row));
+        _data.removeAt(row);
+        _attachedData.updateAllDataAfterRowRemoval(row);
+        q->endRemoveRows();
+    }
+
+    _attachedData = AttachedDataContainer();
+    _attachedData.initFromArray(_data);
+    if (!_data.isEmpty())
+        emit q->dataChanged(q->index(0), q->index(_data.count() - 1));
+}
+
+/*!
+  \internal
+  Takes over the appended rows of the previous owner which the backend did
+  not create yet, they keep their temporary id and get the id of the object
+  once the create finished. The state of the other pending changes is not
+  known to this model, the rows are marked as synced.
+*/
+void EnginioBaseModelPrivate::adoptPendingCreates()
+{
+    delete _replyConnectionConntext;
+    _replyConnectionConntext = new QObject();
+    AttachedDataContainer attachedData;
+    for (int row = 0; row < _data.count(); ++row) {
+        const QString id = EnginioObjectProperties::objectId(_data.at(row).toObject());
+        if (!id.isEmpty()) {
+            attachedData.insert(AttachedData(row, id));
+            continue;
+        }
+        AttachedData data = _attachedData.dataFromRow(row);
+        Q_ASSERT(data.createReply);
+        data.ref = 1;
+        attachedData.insert(data);
+        attachedData.insertRequestId(data.createReply->requestId(), row);
+        FinishedCreateRequest finishedRequest = { this, data.id, data.createReply };
+        QObject::connect(data.createReply, &EnginioReplyState::dataChanged, _replyConnectionConntext, finishedRequest);
+    }
+    _attachedData = attachedData;
+    if (!_data.isEmpty())
+        emit q->dataChanged(q->index(0), q->index(_data.count() - 1));
+}
+
+void EnginioBaseModelPrivate::followStoreOwner()
+{
+    Q_ASSERT(isStoreFollower());
+    EnginioBaseModel *owner = _store->owner->q;
+    RelayRowsAboutToChange insert = { this, true };
+    RelayRowsAboutToChange remove = { this, false };
+    RelayRowsAboutToBeMoved move = { this };
+    RelayModelAboutToBeReset reset = { this };
+    RelayChangeFinished inserted = { this, RelayChangeFinished::InsertRows };
+    RelayChangeFinished removed = { this, RelayChangeFinished::RemoveRows };
+    RelayChangeFinished moved = { this, RelayChangeFinished::MoveRows };
+    RelayChangeFinished wasReset = { this, RelayChangeFinished::ResetModel };
+    RelayDataChanged changed = { this };
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsAboutToBeInserted, insert));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsInserted, inserted));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsAboutToBeRemoved, remove));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsRemoved, removed));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsAboutToBeMoved, move));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::rowsMoved, moved));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::modelAboutToBeReset, reset));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::modelReset, wasReset));
+    _storeConnections.append(QObject::connect(owner, &QAbstractItemModel::dataChanged, changed));
+}
+
+void EnginioBaseModelPrivate::unfollowStoreOwner()
+{
+    foreach (const QMetaObject::Connection &connection, _storeConnections)
+        QObject::disconnect(connection);
+    _storeConnections.clear();
+}
+
+void EnginioBaseModelPrivate::resumeAsStoreOwner()
+{
+    if (!_enginio || !_store || _store->owner != this)
+        return;
+    subscribeAndLoad();
 }
 
 #ifndef QT_NO_DEBUG_STREAM
@@ -651,6 +1196,88 @@ QHash<int, QByteArray> EnginioBaseModel::roleNames() const
     return d->roleNames();
 }
 
+/*!
+    \property EnginioBaseModel::queryDebounceInterval
+    \brief The time in milliseconds to wait after a change of the query
+    before it is executed.
+    \since 1.8
+
+    When the query follows user input, like the text of a search field, every
+    change would send a new query. With a positive interval the query is sent
+    only once it did not change for that long. The default is 0, the query is
+    executed as soon as it changes.
+
+    Queries which are still running when the model sends a new one are
+    aborted in any case.
+*/
+int EnginioBaseModel::queryDebounceInterval() const
+{
+    Q_D(const EnginioBaseModel);
+    return d->queryDebounceInterval();
+}
+
+void EnginioBaseModel::setQueryDebounceInterval(int msecs)
+{
+    Q_D(EnginioBaseModel);
+    msecs = qMax(0, msecs);
+    if (msecs == d->queryDebounceInterval())
+        return;
+    d->setQueryDebounceInterval(msecs);
+    emit queryDebounceIntervalChanged(msecs);
+}
+
+/*!
+    \since 1.8
+    Creates an index of the values of the property mapped to \a role,
+    which makes indexOf() and rowsMatching() for the role independent of
+    the number of rows.
+
+    The index is kept up to date when objects are created, changed or
+    removed, at the cost of a hash lookup per index and change. Without
+    an index the functions compare the property of every row. The
+    function is not available in QML.
+
+    \sa roleNames()
+*/
+void EnginioBaseModel::createRoleIndex(int role)
+{
+    Q_D(EnginioBaseModel);
+    d->createRoleIndex(role);
+}
+
+/*!
+    \since 1.8
+    Returns the first row in which the property mapped to \a role equals
+    \a value, or -1 if there is none.
+
+    Rows added with append() are found before the backend created their
+    object. The function is not available in QML.
+
+    \sa createRoleIndex(), rowsMatching()
+*/
+int EnginioBaseModel::indexOf(int role, const QVariant &value) const
+{
+    Q_D(const EnginioBaseModel);
+    const QList<int> rows = d->rowsMatching(role, value, true);
+    return rows.isEmpty() ? -1 : rows.first();
+}
+
+/*!
+    \since 1.8
+    Returns the rows in which the property mapped to \a role equals
+    \a value, in ascending order.
+
+    Rows added with append() are found before the backend created their
+    object. The function is not available in QML.
+
+    \sa createRoleIndex(), indexOf()
+*/
+QList<int> EnginioBaseModel::rowsMatching(int role, const QVariant &value) const
+{
+    Q_D(const EnginioBaseModel);
+    return d->rowsMatching(role, value, false);
+}
+
 /*!
     \internal
     Allows to disable notifications for autotests.
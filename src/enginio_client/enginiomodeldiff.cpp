@@ -0,0 +1,263 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <Enginio/private/enginiomodeldiff_p.h>
+#include <Enginio/private/enginioobjectproperties_p.h>
+
+#include <QtCore/qfutureinterface.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qthreadpool.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+/*
+    Marks the elements of the longest strictly increasing subsequence of
+    \a values in \a inSequence, O(n log n).
+*/
+void longestIncreasingSubsequence(const QVector<int> &values, QVector<bool> *inSequence)
+{
+    const int count = values.count();
+    QVector<int> tails; // index of the smallest tail of every subsequence length
+    QVector<int> previous(count, -1);
+    tails.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        int low = 0;
+        int high = tails.count();
+        while (low < high) {
+            const int middle = (low + high) / 2;
+            if (values.at(tails.at(middle)) < values.at(i))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low)
+            previous[i] = tails.at(low - 1);
+        if (low == tails.count())
+            tails.append(i);
+        else
+            tails[low] = i;
+    }
+
+    inSequence->fill(false, count);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = previous.at(i))
+        (*inSequence)[i] = true;
+}
+
+class DiffTask : public QRunnable
+{
+    QFutureInterface<EnginioModelDiff> _future;
+    const QJsonArray _from;
+    const QJsonArray _to;
+    const int _maxSteps;
+
+public:
+    DiffTask(const QJsonArray &from, const QJsonArray &to, int maxSteps)
+        : _from(from)
+        , _to(to)
+        , _maxSteps(maxSteps)
+    {
+        _future.reportStarted();
+    }
+
+    QFuture<EnginioModelDiff> future()
+    {
+        return _future.future();
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        if (!_future.isCanceled()) {
+            const EnginioModelDiff diff = EnginioModelDiff::compute(_from, _to, _maxSteps);
+            _future.reportResult(diff);
+        }
+        _future.reportFinished();
+    }
+};
+
+} // namespace
+
+bool EnginioModelDiff::addStep(StepType type, int first, int last, int destination)
+{
+    if (type != ChangeRows && !_maxSteps--)
+        return false;
+    const Step step = { type, first, last, destination };
+    _steps.append(step);
+    return true;
+}
+
+/*!
+    \internal
+    Computes the steps turning the rows of \a from into the rows of \a to.
+    The result is a reset if it would take more than \a maxSteps removals,
+    moves and insertions, changed rows do not count.
+*/
+EnginioModelDiff EnginioModelDiff::compute(const QJsonArray &from, const QJsonArray &to, int maxSteps)
+{
+    EnginioModelDiff reset;
+    EnginioModelDiff diff;
+    diff._reset = false;
+    diff._maxSteps = maxSteps;
+
+    const int fromCount = from.count();
+    const int toCount = to.count();
+    if (!fromCount || !toCount)
+        return reset;
+
+    QHash<QString, int> toRows;
+    toRows.reserve(toCount);
+    for (int row = 0; row < toCount; ++row) {
+        const QString id = EnginioObjectProperties::objectId(to.at(row).toObject());
+        if (id.isEmpty() || toRows.contains(id))
+            return reset;
+        toRows.insert(id, row);
+    }
+
+    // The rows staying in the model, as their row in the new result,
+    // and for every new row the row it had before, or -1.
+    QVector<int> kept;
+    QVector<int> fromRows(toCount, -1);
+    QVector<bool> removed(fromCount, false);
+    kept.reserve(qMin(fromCount, toCount));
+    for (int row = 0; row < fromCount; ++row) {
+        const int toRow = toRows.value(EnginioObjectProperties::objectId(from.at(row).toObject()), -1);
+        if (toRow == -1 || fromRows.at(toRow) != -1) {
+            removed[row] = true;
+            continue;
+        }
+        fromRows[toRow] = row;
+        kept.append(toRow);
+    }
+    if (kept.isEmpty())
+        return reset; // nothing in common, a reset is cheaper
+
+    // Removals from the bottom up, the rows above keep their numbers.
+    for (int last = fromCount - 1; last >= 0; --last) {
+        if (!removed.at(last))
+            continue;
+        int first = last;
+        while (first > 0 && removed.at(first - 1))
+            --first;
+        if (!diff.addStep(RemoveRows, first, last))
+            return reset;
+        last = first;
+    }
+
+    // Moves, in the order of the new result every moved row is placed
+    // behind the row preceding it there.
+    QVector<bool> inSequence;
+    longestIncreasingSubsequence(kept, &inSequence);
+    QVector<bool> moved(toCount, false);
+    int movedCount = 0;
+    for (int i = 0; i < kept.count(); ++i) {
+        if (!inSequence.at(i)) {
+            moved[kept.at(i)] = true;
+            ++movedCount;
+        }
+    }
+    if (movedCount > maxSteps)
+        return reset;
+
+    int precedingRow = -1; // of the new result
+    for (int toRow = 0; toRow < toCount; ++toRow) {
+        if (fromRows.at(toRow) == -1)
+            continue;
+        if (!moved.at(toRow)) {
+            precedingRow = toRow;
+            continue;
+        }
+
+        const int first = kept.indexOf(toRow);
+        // Rows moving together are moved at once.
+        int count = 1;
+        while (first + count < kept.count() && kept.at(first + count) == toRow + count && moved.at(toRow + count))
+            ++count;
+        const int destination = precedingRow == -1 ? 0 : kept.indexOf(precedingRow) + 1;
+        if (destination != first) {
+            if (!diff.addStep(MoveRows, first, first + count - 1, destination))
+                return reset;
+            const QVector<int> rows = kept.mid(first, count);
+            kept.remove(first, count);
+            const int target = destination > first ? destination - count : destination;
+            for (int i = 0; i < count; ++i)
+                kept.insert(target + i, rows.at(i));
+        }
+        toRow += count - 1;
+        precedingRow = toRow;
+    }
+    Q_ASSERT(std::is_sorted(kept.constBegin(), kept.constEnd()));
+
+    // Insertions from the top down, the rows above are final already.
+    for (int first = 0; first < toCount; ++first) {
+        if (fromRows.at(first) != -1)
+            continue;
+        int last = first;
+        while (last + 1 < toCount && fromRows.at(last + 1) == -1)
+            ++last;
+        if (!diff.addStep(InsertRows, first, last))
+            return reset;
+        first = last;
+    }
+
+    for (int first = 0; first < toCount; ++first) {
+        const int fromRow = fromRows.at(first);
+        if (fromRow == -1 || from.at(fromRow) == to.at(first))
+            continue;
+        int last = first;
+        while (last + 1 < toCount && fromRows.at(last + 1) != -1 && from.at(fromRows.at(last + 1)) != to.at(last + 1))
+            ++last;
+        diff.addStep(ChangeRows, first, last);
+        first = last;
+    }
+
+    return diff;
+}
+
+/*!
+    \internal
+    Computes the diff in the global thread pool.
+*/
+QFuture<EnginioModelDiff> EnginioModelDiff::computeInThreadPool(const QJsonArray &from, const QJsonArray &to, int maxSteps)
+{
+    DiffTask *task = new DiffTask(from, to, maxSteps);
+    const QFuture<EnginioModelDiff> future = task->future();
+    QThreadPool::globalInstance()->start(task);
+    return future;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef ENGINIOMODELDIFF_P_H
+#define ENGINIOMODELDIFF_P_H
+
+#include <QtCore/qfuture.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qvector.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief The row operations turning one query result into another.
+
+    Objects are matched by their id. The rows which are no longer in the
+    result are removed first, then the rows which changed their position
+    are moved, the new rows are inserted and finally the rows whose content
+    differs are reported as changed. Only the rows outside of the longest
+    sequence already in the right order are moved.
+
+    Each step uses the row numbers the model has at the moment the step is
+    applied, so the steps can be replayed one after the other with the
+    begin and end functions of QAbstractItemModel.
+
+    If the results can not be matched, e.g. because of objects without an
+    id, or if the diff would take more steps than a reset costs, the
+    diff is a reset.
+
+    Matching large results takes a while, computeInThreadPool() does it
+    off the thread of the model. The arrays are implicitly shared copies,
+    so the model is free to change its own data in the meantime.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioModelDiff
+{
+public:
+    enum StepType {
+        RemoveRows,
+        MoveRows,
+        InsertRows,
+        ChangeRows
+    };
+
+    struct Step
+    {
+        StepType type;
+        int first;
+        int last;
+        int destination; // the row the moved rows are placed before
+    };
+
+    const static int DefaultMaxSteps = 64;
+
+    EnginioModelDiff()
+        : _maxSteps(0)
+        , _reset(true)
+    {}
+
+    static EnginioModelDiff compute(const QJsonArray &from, const QJsonArray &to, int maxSteps = DefaultMaxSteps) Q_REQUIRED_RESULT;
+    static QFuture<EnginioModelDiff> computeInThreadPool(const QJsonArray &from, const QJsonArray &to, int maxSteps = DefaultMaxSteps) Q_REQUIRED_RESULT;
+
+    bool isReset() const Q_REQUIRED_RESULT { return _reset; }
+    const QVector<Step> &steps() const Q_REQUIRED_RESULT { return _steps; }
+
+private:
+    bool addStep(StepType type, int first, int last, int destination = -1);
+
+    QVector<Step> _steps;
+    int _maxSteps;
+    bool _reset;
+};
+
+Q_DECLARE_TYPEINFO(EnginioModelDiff::Step, Q_PRIMITIVE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOMODELDIFF_P_H
@@ -0,0 +1,292 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/private/enginionotification_p.h>
+#include <Enginio/private/enginiostring_p.h>
+
+#include <QtCore/qjsondocument.h>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+struct Span
+{
+    const char *begin;
+    const char *end;
+};
+
+struct ScanField
+{
+    const char *name;
+    int nameLength;
+    Span *value; // the string value is extracted
+    const ScanField *fields; // or the fields of the object value are scanned
+    int fieldCount;
+};
+
+inline bool isJsonWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline const char *skipWhitespace(const char *it, const char *end)
+{
+    while (it != end && isJsonWhitespace(*it))
+        ++it;
+    return it;
+}
+
+const char *skipString(const char *it, const char *end, bool *hasEscapes)
+{
+    // The opening quote was already seen, returns the position behind the closing one.
+    Q_ASSERT(*it == '"');
+    for (++it; it != end; ++it) {
+        if (*it == '"')
+            return it + 1;
+        if (*it == '\\') {
+            *hasEscapes = true;
+            if (++it == end)
+                return 0;
+        }
+    }
+    return 0;
+}
+
+const char *skipValue(const char *it, const char *end)
+{
+    bool hasEscapes;
+    if (*it == '"')
+        return skipString(it, end, &hasEscapes);
+
+    if (*it == '{' || *it == '[') {
+        int depth = 0;
+        while (it != end) {
+            switch (*it) {
+            case '"':
+                it = skipString(it, end, &hasEscapes);
+                if (!it)
+                    return 0;
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (!--depth)
+                    return it + 1;
+                break;
+            }
+            ++it;
+        }
+        return 0;
+    }
+
+    // A number or one of true, false and null.
+    const char *literal = it;
+    while (it != end && *it != ',' && *it != '}' && *it != ']' && !isJsonWhitespace(*it))
+        ++it;
+    return it != literal ? it : 0;
+}
+
+const char *scanObject(const char *it, const char *end, const ScanField *fields, int fieldCount, bool *needsParser)
+{
+    // Only the requested fields are looked at, everything else is skipped
+    // without being validated. Escape sequences are not decoded, if they
+    // appear in a key or in a requested value the caller has to use the parser.
+    Q_ASSERT(*it == '{');
+    it = skipWhitespace(it + 1, end);
+    if (it != end && *it == '}')
+        return it + 1;
+
+    forever {
+        if (it == end || *it != '"')
+            return 0;
+        const char *key = it + 1;
+        it = skipString(it, end, needsParser);
+        if (!it)
+            return 0;
+        const int keyLength = it - 1 - key;
+
+        it = skipWhitespace(it, end);
+        if (it == end || *it != ':')
+            return 0;
+        it = skipWhitespace(it + 1, end);
+        if (it == end)
+            return 0;
+
+        const ScanField *field = 0;
+        for (int i = 0; i < fieldCount; ++i) {
+            if (fields[i].nameLength == keyLength && !memcmp(fields[i].name, key, keyLength)) {
+                field = fields + i;
+                break;
+            }
+        }
+
+        if (field && field->value && *it == '"') {
+            field->value->begin = it + 1;
+            it = skipString(it, end, needsParser);
+            if (it)
+                field->value->end = it - 1;
+        } else if (field && field->fields && *it == '{') {
+            it = scanObject(it, end, field->fields, field->fieldCount, needsParser);
+        } else {
+            it = skipValue(it, end);
+        }
+        if (!it)
+            return 0;
+
+        it = skipWhitespace(it, end);
+        if (it == end)
+            return 0;
+        if (*it == '}')
+            return it + 1;
+        if (*it != ',')
+            return 0;
+        it = skipWhitespace(it + 1, end);
+    }
+}
+
+inline QString toString(const Span &span)
+{
+    return span.begin ? QString::fromUtf8(span.begin, span.end - span.begin) : QString();
+}
+
+} // namespace
+
+/*!
+    \brief Creates a notification from the \a json text of a message.
+
+    \internal
+*/
+EnginioNotification EnginioNotification::fromJson(const QByteArray &json)
+{
+    EnginioNotification notification;
+    notification._json = json;
+    if (!notification.scan()) {
+        // Escaped or unexpected content, let the JSON parser do the work.
+        const QJsonObject &message = notification.parsed();
+        const QJsonObject data = message[EnginioString::data].toObject();
+        notification.setEventName(message[EnginioString::event].toString());
+        notification._objectId = data[EnginioString::id].toString();
+        notification._objectType = data[EnginioString::objectType].toString();
+        notification._requestId = message[EnginioString::origin].toObject()[EnginioString::apiRequestId].toString();
+    }
+    return notification;
+}
+
+/*!
+    \brief Returns the "data" object of the message, which is the object the
+    event is about. The message gets parsed on the first call.
+
+    \internal
+*/
+QJsonObject EnginioNotification::data() const
+{
+    return parsed()[EnginioString::data].toObject();
+}
+
+/*!
+    \brief Returns the whole message as a JSON object.
+
+    \internal
+*/
+QJsonObject EnginioNotification::toJsonObject() const
+{
+    return parsed();
+}
+
+void EnginioNotification::setEventName(const QString &eventName)
+{
+    _eventName = eventName;
+    if (eventName == EnginioString::update)
+        _event = UpdateEvent;
+    else if (eventName == EnginioString::create)
+        _event = CreateEvent;
+    else if (eventName == EnginioString::_delete)
+        _event = DeleteEvent;
+    else
+        _event = UnknownEvent;
+}
+
+bool EnginioNotification::scan()
+{
+    // {"event": ..., "data": {"id": ..., "objectType": ...}, "origin": {"apiRequestId": ...}}
+    Span event = { 0, 0 };
+    Span id = { 0, 0 };
+    Span objectType = { 0, 0 };
+    Span requestId = { 0, 0 };
+    const ScanField dataFields[] = {
+        { "id", 2, &id, 0, 0 },
+        { "objectType", 10, &objectType, 0, 0 }
+    };
+    const ScanField originFields[] = {
+        { "apiRequestId", 12, &requestId, 0, 0 }
+    };
+    const ScanField messageFields[] = {
+        { "event", 5, &event, 0, 0 },
+        { "data", 4, 0, dataFields, 2 },
+        { "origin", 6, 0, originFields, 1 }
+    };
+
+    const char *end = _json.constData() + _json.size();
+    const char *it = skipWhitespace(_json.constData(), end);
+    if (it == end || *it != '{')
+        return false;
+
+    bool needsParser = false;
+    it = scanObject(it, end, messageFields, 3, &needsParser);
+    if (!it || needsParser || skipWhitespace(it, end) != end)
+        return false;
+
+    setEventName(toString(event));
+    _objectId = toString(id);
+    _objectType = toString(objectType);
+    _requestId = toString(requestId);
+    return true;
+}
+
+const QJsonObject &EnginioNotification::parsed() const
+{
+    if (!_isParsed) {
+        _parsed = QJsonDocument::fromJson(_json).object();
+        _isParsed = true;
+    }
+    return _parsed;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIONOTIFICATION_P_H
+#define ENGINIONOTIFICATION_P_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qstring.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief A notification message received from the backend.
+
+    The routing properties (event, object id, objectType and the id of the
+    request which caused the change) are extracted from the message text with
+    a single scan. The message is parsed into JSON only if its payload is
+    accessed, the parsed object is then cached.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioNotification
+{
+public:
+    enum Event {
+        UnknownEvent,
+        CreateEvent,
+        UpdateEvent,
+        DeleteEvent
+    };
+
+    EnginioNotification()
+        : _event(UnknownEvent)
+        , _isParsed(false)
+    {}
+
+    static EnginioNotification fromJson(const QByteArray &json);
+
+    bool isValid() const Q_REQUIRED_RESULT { return !_json.isEmpty(); }
+    Event event() const Q_REQUIRED_RESULT { return _event; }
+    QString eventName() const Q_REQUIRED_RESULT { return _eventName; }
+    QString objectId() const Q_REQUIRED_RESULT { return _objectId; }
+    QString objectType() const Q_REQUIRED_RESULT { return _objectType; }
+    QString requestId() const Q_REQUIRED_RESULT { return _requestId; }
+
+    QJsonObject data() const Q_REQUIRED_RESULT;
+    QJsonObject toJsonObject() const Q_REQUIRED_RESULT;
+
+private:
+    void setEventName(const QString &eventName);
+    bool scan();
+    const QJsonObject &parsed() const;
+
+    QByteArray _json;
+    Event _event;
+    QString _eventName;
+    QString _objectId;
+    QString _objectType;
+    QString _requestId;
+
+    mutable bool _isParsed;
+    mutable QJsonObject _parsed;
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(EnginioNotification)
+
+#endif // ENGINIONOTIFICATION_P_H
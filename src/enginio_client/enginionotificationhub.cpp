@@ -0,0 +1,333 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/private/enginionotificationhub_p.h>
+#include <Enginio/private/enginioclient_p.h>
+#include <Enginio/private/enginiostring_p.h>
+#include <Enginio/enginioclientconnection.h>
+
+#include <QtCore/qcoreevent.h>
+#include <QtCore/qjsonvalue.h>
+#include <QtCore/quuid.h>
+
+QT_BEGIN_NAMESPACE
+
+const static int MinimumReconnectDelay = 1000;
+const static int MaximumReconnectDelay = 60000;
+const static int MaximumReconnectDoublings = 6;
+
+namespace {
+
+int reconnectDelay(int attempt)
+{
+    // Exponential backoff with "equal jitter", so that clients which lost
+    // their connection at the same time do not come back at the same time.
+    // qrand() is not used as every thread starts with the same seed.
+    const int delay = qMin(MaximumReconnectDelay, MinimumReconnectDelay << qMin(attempt, MaximumReconnectDoublings));
+    const uint random = QUuid::createUuid().data1;
+    return delay / 2 + int(random % uint(delay / 2 + 1));
+}
+
+} // namespace
+
+/*!
+    \brief Shares one EnginioBackendConnection between all models of a client.
+
+    Every subscriber registers the message filter it is interested in. The
+    connection is opened with the part of the filters all subscribers agree
+    on, incoming messages are then dispatched by objectType and event to the
+    matching subscribers. Subscription changes are applied together once the
+    control returns to the event loop, so a view creating many models
+    connects only once.
+
+    A connection lost without a request of the hub is opened again after a
+    randomized, exponentially growing delay. Subscribers which were served by
+    the lost connection are told about it afterwards, so that they can fetch
+    the changes they have missed.
+
+    \internal
+*/
+
+EnginioNotificationHub::EnginioNotificationHub(EnginioClientConnectionPrivate *client, QObject *parent)
+    : QObject(parent)
+    , _client(client)
+    , _connection()
+    , _connectionState(EnginioBackendConnection::DisconnectedState)
+    , _reconnectRequired(false)
+    , _reconnectAttempts(0)
+{
+    Q_ASSERT(client && client->q_ptr);
+    // The stream url is bound to the backend and to the session.
+    EnginioClientConnection *q = static_cast<EnginioClientConnection*>(client->q_ptr);
+    QObject::connect(q, &EnginioClientConnection::backendIdChanged, this, &EnginioNotificationHub::reconnect);
+    QObject::connect(q, &EnginioClientConnection::serviceUrlChanged, this, &EnginioNotificationHub::reconnect);
+    QObject::connect(q, &EnginioClientConnection::authenticationStateChanged, this, &EnginioNotificationHub::reconnect);
+}
+
+EnginioNotificationHub::~EnginioNotificationHub()
+{
+    removeConnection();
+}
+
+/*!
+    \brief Registers \a subscriber for the messages matching \a messageFilter,
+    replacing its previous filter. Only the "event" and "data.objectType"
+    properties of the filter are used for dispatching.
+
+    \internal
+*/
+void EnginioNotificationHub::subscribe(EnginioNotificationSubscriber *subscriber, const QJsonObject &messageFilter)
+{
+    Q_ASSERT(subscriber);
+    QHash<EnginioNotificationSubscriber*, Subscription>::iterator it = _subscriptions.find(subscriber);
+    if (it != _subscriptions.end()) {
+        if (it->filter == messageFilter) {
+            // Nothing changed, but a lost connection should be established again.
+            scheduleUpdate();
+            return;
+        }
+        removeFromIndex(subscriber, *it);
+    } else {
+        it = _subscriptions.insert(subscriber, Subscription());
+    }
+
+    it->filter = messageFilter;
+    it->wasConnected = _connectionState == EnginioBackendConnection::ConnectedState;
+    it->objectType = messageFilter[EnginioString::data].toObject()[EnginioString::objectType].toString();
+    it->event = messageFilter[EnginioString::event].toString();
+    _index[it->objectType][it->event].append(subscriber);
+    scheduleUpdate();
+}
+
+void EnginioNotificationHub::unsubscribe(EnginioNotificationSubscriber *subscriber)
+{
+    QHash<EnginioNotificationSubscriber*, Subscription>::iterator it = _subscriptions.find(subscriber);
+    if (it == _subscriptions.end())
+        return;
+    removeFromIndex(subscriber, *it);
+    _subscriptions.erase(it);
+    scheduleUpdate();
+}
+
+/*!
+    \brief Forces a new connection, for example after the session has changed.
+
+    \internal
+*/
+void EnginioNotificationHub::reconnect()
+{
+    _reconnectRequired = true;
+    scheduleUpdate();
+}
+
+/*!
+    \brief Returns the least restrictive filter which still matches all messages matched
+    by \a a or \a b. Properties are kept only if both filters have the same value.
+
+    \internal
+*/
+QJsonObject EnginioNotificationHub::mergeFilters(const QJsonObject &a, const QJsonObject &b)
+{
+    QJsonObject result;
+    for (QJsonObject::const_iterator it = a.constBegin(); it != a.constEnd(); ++it) {
+        const QJsonValue value = it.value();
+        const QJsonValue other = b.value(it.key());
+        if (value.isObject() && other.isObject()) {
+            const QJsonObject merged = mergeFilters(value.toObject(), other.toObject());
+            if (!merged.isEmpty())
+                result.insert(it.key(), merged);
+        } else if (value == other) {
+            result.insert(it.key(), value);
+        }
+    }
+    return result;
+}
+
+void EnginioNotificationHub::onNotificationReceived(const EnginioNotification &notification)
+{
+    // All subscribers share the notification, so it is parsed at most once.
+    const SubscriberList subscribers = matchingSubscribers(notification.objectType(), notification.eventName());
+    foreach (EnginioNotificationSubscriber *subscriber, subscribers) {
+        // Handling a message may unsubscribe others, e.g. if a model gets deleted.
+        if (_subscriptions.contains(subscriber))
+            subscriber->receivedNotification(notification);
+    }
+}
+
+void EnginioNotificationHub::onStateChanged(EnginioBackendConnection::ConnectionState state)
+{
+    _connectionState = state;
+
+    switch (state) {
+    case EnginioBackendConnection::ConnectedState: {
+        _reconnectAttempts = 0;
+        QList<EnginioNotificationSubscriber*> missedMessages;
+        for (QHash<EnginioNotificationSubscriber*, Subscription>::iterator it = _subscriptions.begin(); it != _subscriptions.end(); ++it) {
+            if (it->wasConnected)
+                missedMessages.append(it.key());
+            it->wasConnected = true;
+        }
+        foreach (EnginioNotificationSubscriber *subscriber, missedMessages) {
+            if (_subscriptions.contains(subscriber))
+                subscriber->reconnected();
+        }
+        break;
+    }
+    case EnginioBackendConnection::DisconnectedState:
+        // The hub disconnects from the signals before closing a connection
+        // on its own, so the connection was lost.
+        scheduleReconnect();
+        break;
+    default:
+        break;
+    }
+}
+
+void EnginioNotificationHub::onTimeOut()
+{
+    // The server did not answer the ping, the socket may be dead without being closed.
+    removeConnection();
+    scheduleReconnect();
+}
+
+void EnginioNotificationHub::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == _updateTimer.timerId()) {
+        _updateTimer.stop();
+        updateConnection();
+        return;
+    }
+
+    if (event->timerId() == _backoffTimer.timerId()) {
+        _backoffTimer.stop();
+        _reconnectRequired = true;
+        updateConnection();
+        return;
+    }
+
+    QObject::timerEvent(event);
+}
+
+void EnginioNotificationHub::scheduleUpdate()
+{
+    if (!_updateTimer.isActive())
+        _updateTimer.start(0, this);
+}
+
+void EnginioNotificationHub::scheduleReconnect()
+{
+    if (_subscriptions.isEmpty() || _backoffTimer.isActive())
+        return;
+    _backoffTimer.start(reconnectDelay(_reconnectAttempts++), this);
+}
+
+void EnginioNotificationHub::updateConnection()
+{
+    if (_subscriptions.isEmpty() || _client->_backendId.isEmpty()) {
+        removeConnection();
+        _backoffTimer.stop();
+        _reconnectAttempts = 0;
+        return;
+    }
+
+    QHash<EnginioNotificationSubscriber*, Subscription>::const_iterator it = _subscriptions.constBegin();
+    QJsonObject filter = it->filter;
+    for (++it; it != _subscriptions.constEnd(); ++it)
+        filter = mergeFilters(filter, it->filter);
+
+    const bool isAlive = _connection && _connectionState != EnginioBackendConnection::DisconnectedState;
+    if (isAlive && !_reconnectRequired && filter == _connectionFilter)
+        return;
+    if (!isAlive && !_reconnectRequired && _backoffTimer.isActive())
+        return; // The next attempt is already scheduled.
+
+    removeConnection();
+    _backoffTimer.stop();
+    _reconnectRequired = false;
+    _connectionFilter = filter;
+    _connectionState = EnginioBackendConnection::ConnectingState;
+    _connection = new EnginioBackendConnection(this);
+    QObject::connect(_connection, &EnginioBackendConnection::notificationReceived, this, &EnginioNotificationHub::onNotificationReceived);
+    QObject::connect(_connection, &EnginioBackendConnection::stateChanged, this, &EnginioNotificationHub::onStateChanged);
+    QObject::connect(_connection, &EnginioBackendConnection::timeOut, this, &EnginioNotificationHub::onTimeOut);
+    _connection->connectToBackend(_client, filter);
+}
+
+void EnginioNotificationHub::removeConnection()
+{
+    if (!_connection)
+        return;
+    QObject::disconnect(_connection, 0, this, 0);
+    _connection->close();
+    // The connection may be calling us, e.g. on a ping time out.
+    _connection->deleteLater();
+    _connection = 0;
+    _connectionState = EnginioBackendConnection::DisconnectedState;
+    _connectionFilter = QJsonObject();
+}
+
+void EnginioNotificationHub::removeFromIndex(EnginioNotificationSubscriber *subscriber, const Subscription &subscription)
+{
+    QHash<QString, EventIndex>::iterator objectTypeIt = _index.find(subscription.objectType);
+    Q_ASSERT(objectTypeIt != _index.end());
+    EventIndex::iterator eventIt = objectTypeIt->find(subscription.event);
+    Q_ASSERT(eventIt != objectTypeIt->end());
+    eventIt->removeOne(subscriber);
+    if (eventIt->isEmpty())
+        objectTypeIt->erase(eventIt);
+    if (objectTypeIt->isEmpty())
+        _index.erase(objectTypeIt);
+}
+
+EnginioNotificationHub::SubscriberList EnginioNotificationHub::matchingSubscribers(const QString &objectType, const QString &event) const
+{
+    // Every subscriber is stored in exactly one bucket, so the exact
+    // and the wildcard buckets can be concatenated without duplicates.
+    SubscriberList result;
+    const QString objectTypes[] = { objectType, QString() };
+    const QString events[] = { event, QString() };
+    for (int i = objectType.isEmpty() ? 1 : 0; i < 2; ++i) {
+        QHash<QString, EventIndex>::const_iterator objectTypeIt = _index.constFind(objectTypes[i]);
+        if (objectTypeIt == _index.constEnd())
+            continue;
+        for (int j = event.isEmpty() ? 1 : 0; j < 2; ++j) {
+            EventIndex::const_iterator eventIt = objectTypeIt->constFind(events[j]);
+            if (eventIt != objectTypeIt->constEnd())
+                result.append(*eventIt);
+        }
+    }
+    return result;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIONOTIFICATIONHUB_P_H
+#define ENGINIONOTIFICATIONHUB_P_H
+
+#include <QtCore/qbasictimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+
+#include <Enginio/enginioclient_global.h>
+#include <Enginio/private/enginiobackendconnection_p.h>
+#include <Enginio/private/enginionotification_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class EnginioClientConnectionPrivate;
+
+/*!
+    \brief Receiver of the notifications dispatched by EnginioNotificationHub.
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioNotificationSubscriber
+{
+public:
+    virtual ~EnginioNotificationSubscriber() {}
+    virtual void receivedNotification(const EnginioNotification &notification) = 0;
+    // Called when the connection is back after messages may have been missed.
+    virtual void reconnected() {}
+};
+
+class ENGINIOCLIENT_EXPORT EnginioNotificationHub : public QObject
+{
+    Q_OBJECT
+
+    struct Subscription
+    {
+        QJsonObject filter;
+        QString objectType;
+        QString event;
+        bool wasConnected; // a connection was established since the subscription
+    };
+
+    typedef QList<EnginioNotificationSubscriber*> SubscriberList;
+    typedef QHash<QString, SubscriberList> EventIndex;
+
+    EnginioClientConnectionPrivate *_client;
+    EnginioBackendConnection *_connection;
+    EnginioBackendConnection::ConnectionState _connectionState;
+    QJsonObject _connectionFilter;
+    bool _reconnectRequired;
+    int _reconnectAttempts;
+    QBasicTimer _updateTimer;
+    QBasicTimer _backoffTimer;
+
+    QHash<EnginioNotificationSubscriber*, Subscription> _subscriptions;
+    // objectType -> event -> subscribers, an empty key matches everything.
+    QHash<QString, EventIndex> _index;
+
+public:
+    explicit EnginioNotificationHub(EnginioClientConnectionPrivate *client, QObject *parent = 0);
+    ~EnginioNotificationHub();
+
+    void subscribe(EnginioNotificationSubscriber *subscriber, const QJsonObject &messageFilter);
+    void unsubscribe(EnginioNotificationSubscriber *subscriber);
+
+    int subscriberCount() const { return _subscriptions.count(); }
+    EnginioBackendConnection *connection() const { return _connection; }
+    QJsonObject connectionFilter() const { return _connectionFilter; }
+
+    static QJsonObject mergeFilters(const QJsonObject &a, const QJsonObject &b) Q_REQUIRED_RESULT;
+
+public slots:
+    void reconnect();
+
+private slots:
+    void onNotificationReceived(const EnginioNotification &notification);
+    void onStateChanged(EnginioBackendConnection::ConnectionState state);
+    void onTimeOut();
+
+private:
+    void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
+    void scheduleUpdate();
+    void scheduleReconnect();
+    void updateConnection();
+    void removeConnection();
+    void removeFromIndex(EnginioNotificationSubscriber *subscriber, const Subscription &subscription);
+    SubscriberList matchingSubscribers(const QString &objectType, const QString &event) const Q_REQUIRED_RESULT;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIONOTIFICATIONHUB_P_H
@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOOBJECTPROPERTIES_P_H
+#define ENGINIOOBJECTPROPERTIES_P_H
+
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonvalue.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+
+#include <Enginio/private/enginiostring_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief Read-only accessors for the properties every backend object has.
+
+    The object is always taken by const reference. QJsonObject::operator[]
+    on a non-const object inserts missing keys, which detaches the object
+    from the array it was taken from and copies all of its data. The models
+    look these properties up for every row, so they have to use the const
+    lookup.
+
+    Query filters and sort orders address properties by dotted paths and
+    compare them with propertyValue() and compareValues().
+
+    \internal
+*/
+struct EnginioObjectProperties
+{
+    static QString objectId(const QJsonObject &object) Q_REQUIRED_RESULT
+    {
+        return object.value(EnginioString::id).toString();
+    }
+
+    static QString objectType(const QJsonObject &object) Q_REQUIRED_RESULT
+    {
+        return object.value(EnginioString::objectType).toString();
+    }
+
+    static QString updatedAt(const QJsonObject &object) Q_REQUIRED_RESULT
+    {
+        return object.value(EnginioString::updatedAt).toString();
+    }
+
+    // The value at a path like "creator.id", undefined if it is missing
+    static QJsonValue propertyValue(const QJsonObject &object, const QStringList &path) Q_REQUIRED_RESULT
+    {
+        QJsonValue value = object.value(path.first());
+        for (int i = 1; i < path.count(); ++i)
+            value = value.toObject().value(path.at(i));
+        return value;
+    }
+
+    // Returns false if the values can not be compared with each other
+    static bool compareValues(const QJsonValue &a, const QJsonValue &b, int *result)
+    {
+        if (a.isDouble() && b.isDouble()) {
+            const double left = a.toDouble();
+            const double right = b.toDouble();
+            *result = left < right ? -1 : (left > right ? 1 : 0);
+        } else if (a.isString() && b.isString()) {
+            *result = a.toString().compare(b.toString());
+        } else if (a.isBool() && b.isBool()) {
+            *result = int(a.toBool()) - int(b.toBool());
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOOBJECTPROPERTIES_P_H
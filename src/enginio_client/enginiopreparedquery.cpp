@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/enginiopreparedquery.h>
+#include <Enginio/private/enginiopreparedquery_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+  \class EnginioPreparedQuery
+  \since 1.8
+  \brief The EnginioPreparedQuery class holds a query ready to be sent repeatedly.
+  \inmodule enginio-qt
+  \ingroup enginio-client
+
+  A prepared query is created by EnginioClient::prepareQuery(). The request
+  path and the encoded URL parameters are computed once, so sending the same
+  query again, for example to fetch the next page of results, only adds the
+  \c limit and \c offset parameters.
+
+  Prepared queries are implicitly shared and cheap to copy. They do not
+  depend on the backend or the service URL of the client, those are applied
+  when the query is sent.
+
+  \sa EnginioClient::query()
+*/
+
+/*!
+  Constructs a null prepared query.
+  \sa isNull()
+*/
+EnginioPreparedQuery::EnginioPreparedQuery()
+{}
+
+/*!
+  Constructs a copy of \a other.
+*/
+EnginioPreparedQuery::EnginioPreparedQuery(const EnginioPreparedQuery &other)
+    : d(other.d)
+{}
+
+/*!
+  Assigns \a other to this query.
+*/
+EnginioPreparedQuery &EnginioPreparedQuery::operator=(const EnginioPreparedQuery &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+  Destroys the query.
+*/
+EnginioPreparedQuery::~EnginioPreparedQuery()
+{}
+
+/*!
+  Returns \c true if the query was default constructed.
+*/
+bool EnginioPreparedQuery::isNull() const
+{
+    return !d;
+}
+
+/*!
+  Returns \c true if the query can be sent. Sending an invalid query
+  results in a reply with the same error as sending the original query.
+*/
+bool EnginioPreparedQuery::isValid() const
+{
+    return d && d->_errorMessage.isEmpty();
+}
+
+/*!
+  Returns the operation the query was prepared for.
+*/
+Enginio::Operation EnginioPreparedQuery::operation() const
+{
+    return d ? d->_operation : Enginio::ObjectOperation;
+}
+
+/*!
+  Returns the \c limit of the original query, or 0 if it did not have one.
+*/
+int EnginioPreparedQuery::limit() const
+{
+    return d ? d->_limit : 0;
+}
+
+/*!
+  Returns the \c offset of the original query, or 0 if it did not have one.
+*/
+int EnginioPreparedQuery::offset() const
+{
+    return d ? d->_offset : 0;
+}
+
+QT_END_NAMESPACE
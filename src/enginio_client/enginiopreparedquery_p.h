@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOPREPAREDQUERY_P_H
+#define ENGINIOPREPAREDQUERY_P_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qshareddata.h>
+#include <QtCore/qstring.h>
+
+#include <Enginio/enginiopreparedquery.h>
+
+QT_BEGIN_NAMESPACE
+
+class EnginioPreparedQueryPrivate : public QSharedData
+{
+public:
+    Enginio::Operation _operation;
+    int _limit;
+    int _offset;
+    QString _path;
+    // Percent encoded query items which do not depend on limit and offset
+    QString _encodedQueryItems;
+    // Set if the query can not be sent, the error reply carries it
+    QByteArray _errorMessage;
+
+    EnginioPreparedQueryPrivate()
+        : _operation(Enginio::ObjectOperation)
+        , _limit(0)
+        , _offset(0)
+    {}
+
+    static EnginioPreparedQuery create(EnginioPreparedQueryPrivate *d)
+    {
+        EnginioPreparedQuery query;
+        query.d = d;
+        return query;
+    }
+
+    static const EnginioPreparedQueryPrivate *get(const EnginioPreparedQuery &query)
+    {
+        return query.d.constData();
+    }
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOPREPAREDQUERY_P_H
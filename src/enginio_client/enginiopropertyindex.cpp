@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/private/enginiopropertyindex_p.h>
+#include <Enginio/private/enginioobjectproperties_p.h>
+
+#include <QtCore/qjsondocument.h>
+
+QT_BEGIN_NAMESPACE
+
+EnginioPropertyIndex::EnginioPropertyIndex()
+{}
+
+/*!
+    \internal
+    Returns the hash key of \a value, values of different types never
+    share a key, equal numbers always do.
+*/
+QString EnginioPropertyIndex::key(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::String:
+        return QLatin1Char('s') + value.toString();
+    case QJsonValue::Double:
+        return QLatin1Char('d') + QString::number(value.toDouble(), 'g', 17);
+    case QJsonValue::Bool:
+        return QLatin1String(value.toBool() ? "b1" : "b0");
+    case QJsonValue::Null:
+        return QStringLiteral("n");
+    case QJsonValue::Array:
+        return QLatin1Char('j') + QString::fromUtf8(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+    case QJsonValue::Object:
+        return QLatin1Char('j') + QString::fromUtf8(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+    case QJsonValue::Undefined:
+        break;
+    }
+    return QString();
+}
+
+/*!
+    \internal
+    Indexes \a property of all \a objects, the previous content is dropped.
+    Without a property name the index stays empty.
+*/
+void EnginioPropertyIndex::rebuild(const QString &property, const QJsonArray &objects)
+{
+    _property = property;
+    _objectIds.clear();
+    if (_property.isEmpty())
+        return;
+    _objectIds.reserve(objects.count());
+    for (QJsonArray::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it)
+        insert((*it).toObject());
+}
+
+/*!
+    \internal
+    Adds \a object to the index. Objects without an id or without
+    the property are not indexed.
+*/
+void EnginioPropertyIndex::insert(const QJsonObject &object)
+{
+    insert(object, EnginioObjectProperties::objectId(object));
+}
+
+/*!
+    \internal
+    Adds \a object to the index under \a id, which is used for objects
+    the backend did not create yet.
+*/
+void EnginioPropertyIndex::insert(const QJsonObject &object, const QString &id)
+{
+    if (_property.isEmpty())
+        return;
+    const QString valueKey = key(object.value(_property));
+    if (!id.isEmpty() && !valueKey.isEmpty())
+        _objectIds.insert(valueKey, id);
+}
+
+void EnginioPropertyIndex::remove(const QJsonObject &object)
+{
+    remove(object, EnginioObjectProperties::objectId(object));
+}
+
+void EnginioPropertyIndex::remove(const QJsonObject &object, const QString &id)
+{
+    if (_property.isEmpty())
+        return;
+    const QString valueKey = key(object.value(_property));
+    if (!id.isEmpty() && !valueKey.isEmpty())
+        _objectIds.remove(valueKey, id);
+}
+
+QList<QString> EnginioPropertyIndex::objectIds(const QJsonValue &value) const
+{
+    return _objectIds.values(key(value));
+}
+
+QT_END_NAMESPACE
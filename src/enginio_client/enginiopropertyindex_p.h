@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOPROPERTYINDEX_P_H
+#define ENGINIOPROPERTYINDEX_P_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qstring.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief Maps the values of one property to the ids of the objects having them.
+
+    The index stores object ids instead of rows, so that inserting, removing
+    or moving rows of a model does not invalidate it. The rows are looked up
+    by id when the index is queried.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioPropertyIndex
+{
+public:
+    EnginioPropertyIndex();
+
+    QString property() const Q_REQUIRED_RESULT { return _property; }
+    void rebuild(const QString &property, const QJsonArray &objects);
+
+    void insert(const QJsonObject &object);
+    void insert(const QJsonObject &object, const QString &id);
+    void remove(const QJsonObject &object);
+    void remove(const QJsonObject &object, const QString &id);
+
+    QList<QString> objectIds(const QJsonValue &value) const Q_REQUIRED_RESULT;
+    static QString key(const QJsonValue &value) Q_REQUIRED_RESULT;
+
+private:
+    QString _property;
+    QMultiHash<QString, QString> _objectIds;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOPROPERTYINDEX_P_H
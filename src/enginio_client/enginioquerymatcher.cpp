@@ -0,0 +1,297 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/private/enginioquerymatcher_p.h>
+#include <Enginio/private/enginioobjectproperties_p.h>
+#include <Enginio/private/enginiostring_p.h>
+
+#include <QtCore/qjsonarray.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// {"$type": "time", "$value": ...} literals compare by their value
+QJsonValue operand(const QJsonValue &value)
+{
+    if (value.isObject()) {
+        const QJsonObject object = value.toObject();
+        if (object.contains(EnginioString::_type))
+            return object.value(EnginioString::_value);
+    }
+    return value;
+}
+
+// The backend follows a path through arrays into their elements, the
+// client does not, an object with such a path is always a match.
+bool pathCrossesArray(const QJsonObject &object, const QStringList &path)
+{
+    QJsonValue value = object.value(path.first());
+    for (int i = 1; i < path.count(); ++i) {
+        if (value.isArray())
+            return true;
+        value = value.toObject().value(path.at(i));
+    }
+    return false;
+}
+
+// As on the backend null also matches a missing property, and an array
+// matches if it is equal or one of its elements is.
+bool equals(const QJsonValue &value, const QJsonValue &operand)
+{
+    if (value == operand || (operand.isNull() && value.isUndefined()))
+        return true;
+    return value.isArray() && value.toArray().contains(operand);
+}
+
+bool equalsAny(const QJsonValue &value, const QVector<QJsonValue> &operands)
+{
+    foreach (const QJsonValue &operand, operands) {
+        if (equals(value, operand))
+            return true;
+    }
+    return false;
+}
+
+bool isOperatorObject(const QJsonValue &value)
+{
+    if (!value.isObject())
+        return false;
+    const QJsonObject object = value.toObject();
+    return !object.isEmpty()
+            && object.constBegin().key().startsWith(QLatin1Char('$'))
+            && !object.contains(EnginioString::_type);
+}
+
+} // namespace
+
+EnginioQueryMatcher::EnginioQueryMatcher()
+    : _root(InvalidCondition)
+{}
+
+/*!
+    \internal
+    Compiles \a filter, the value of the "query" option of an object query.
+    The returned matcher is invalid if the filter can not be evaluated on
+    the client.
+*/
+EnginioQueryMatcher EnginioQueryMatcher::compile(const QJsonObject &filter)
+{
+    EnginioQueryMatcher matcher;
+    matcher._root = matcher.compileFilter(filter);
+    if (matcher._root == InvalidCondition)
+        matcher._conditions.clear();
+    return matcher;
+}
+
+int EnginioQueryMatcher::append(const Condition &condition)
+{
+    _conditions.append(condition);
+    return _conditions.count() - 1;
+}
+
+int EnginioQueryMatcher::compileFilter(const QJsonObject &filter)
+{
+    QVector<int> children;
+    for (QJsonObject::const_iterator it = filter.constBegin(); it != filter.constEnd(); ++it) {
+        const QString key = it.key();
+        if (key == EnginioString::_and || key == QStringLiteral("$or")) {
+            if (!it.value().isArray())
+                return InvalidCondition;
+            Condition group;
+            group.op = key == EnginioString::_and ? And : Or;
+            foreach (const QJsonValue &value, it.value().toArray()) {
+                if (!value.isObject())
+                    return InvalidCondition;
+                const int child = compileFilter(value.toObject());
+                if (child == InvalidCondition)
+                    return InvalidCondition;
+                group.children.append(child);
+            }
+            children.append(append(group));
+        } else if (key.startsWith(QLatin1Char('$'))) {
+            return InvalidCondition;
+        } else if (isOperatorObject(it.value())) {
+            if (!compileOperators(key.split(QLatin1Char('.')), it.value().toObject(), &children))
+                return InvalidCondition;
+        } else {
+            Condition equal;
+            equal.op = Equal;
+            equal.path = key.split(QLatin1Char('.'));
+            equal.operand = operand(it.value());
+            children.append(append(equal));
+        }
+    }
+
+    if (children.count() == 1)
+        return children.first();
+    Condition all;
+    all.op = And;
+    all.children = children;
+    return append(all);
+}
+
+bool EnginioQueryMatcher::compileOperators(const QStringList &path, const QJsonObject &operators, QVector<int> *children)
+{
+    for (QJsonObject::const_iterator it = operators.constBegin(); it != operators.constEnd(); ++it) {
+        const QString op = it.key();
+        Condition condition;
+        condition.path = path;
+        condition.operand = operand(it.value());
+        if (op == QStringLiteral("$eq")) {
+            condition.op = Equal;
+        } else if (op == QStringLiteral("$ne")) {
+            condition.op = NotEqual;
+        } else if (op == EnginioString::_gt) {
+            condition.op = Greater;
+        } else if (op == QStringLiteral("$gte")) {
+            condition.op = GreaterOrEqual;
+        } else if (op == QStringLiteral("$lt")) {
+            condition.op = Less;
+        } else if (op == QStringLiteral("$lte")) {
+            condition.op = LessOrEqual;
+        } else if (op == QStringLiteral("$in") || op == QStringLiteral("$nin")) {
+            if (!it.value().isArray())
+                return false;
+            condition.op = op == QStringLiteral("$in") ? In : NotIn;
+            foreach (const QJsonValue &value, it.value().toArray())
+                condition.operands.append(operand(value));
+        } else if (op == QStringLiteral("$exists")) {
+            condition.op = Exists;
+        } else if (op == QStringLiteral("$regex")) {
+            if (!condition.operand.isString())
+                return false;
+            QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+            const QString flags = operators.value(QStringLiteral("$options")).toString();
+            if (flags.contains(QLatin1Char('i')))
+                options |= QRegularExpression::CaseInsensitiveOption;
+            if (flags.contains(QLatin1Char('m')))
+                options |= QRegularExpression::MultilineOption;
+            if (flags.contains(QLatin1Char('s')))
+                options |= QRegularExpression::DotMatchesEverythingOption;
+            condition.op = Regex;
+            condition.regex = QRegularExpression(condition.operand.toString(), options);
+            if (!condition.regex.isValid())
+                return false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+            condition.regex.optimize();
+#endif
+        } else if (op == QStringLiteral("$options")) {
+            continue; // belongs to "$regex"
+        } else {
+            return false;
+        }
+        children->append(append(condition));
+    }
+    return true;
+}
+
+/*!
+    \internal
+    Returns true if the backend would return \a object for the filter.
+*/
+bool EnginioQueryMatcher::matches(const QJsonObject &object) const
+{
+    return _root == InvalidCondition || evaluate(_root, object);
+}
+
+bool EnginioQueryMatcher::evaluate(int index, const QJsonObject &object) const
+{
+    const Condition &condition = _conditions.at(index);
+    switch (condition.op) {
+    case And:
+        foreach (int child, condition.children) {
+            if (!evaluate(child, object))
+                return false;
+        }
+        return true;
+    case Or:
+        foreach (int child, condition.children) {
+            if (evaluate(child, object))
+                return true;
+        }
+        return false;
+    default:
+        break;
+    }
+
+    if (pathCrossesArray(object, condition.path))
+        return true;
+    const QJsonValue value = EnginioObjectProperties::propertyValue(object, condition.path);
+    switch (condition.op) {
+    case Equal:
+        return equals(value, condition.operand);
+    case NotEqual:
+        return !equals(value, condition.operand);
+    case In:
+        return equalsAny(value, condition.operands);
+    case NotIn:
+        return !equalsAny(value, condition.operands);
+    case Exists:
+        return value.isUndefined() != condition.operand.toBool();
+    default:
+        break;
+    }
+
+    // The other operators match an array if one of its elements does
+    if (!value.isArray())
+        return evaluateValue(condition, value);
+    foreach (const QJsonValue &element, value.toArray()) {
+        if (evaluateValue(condition, element))
+            return true;
+    }
+    return false;
+}
+
+bool EnginioQueryMatcher::evaluateValue(const Condition &condition, const QJsonValue &value)
+{
+    int result;
+    switch (condition.op) {
+    case Greater:
+        return EnginioObjectProperties::compareValues(value, condition.operand, &result) && result > 0;
+    case GreaterOrEqual:
+        return EnginioObjectProperties::compareValues(value, condition.operand, &result) && result >= 0;
+    case Less:
+        return EnginioObjectProperties::compareValues(value, condition.operand, &result) && result < 0;
+    case LessOrEqual:
+        return EnginioObjectProperties::compareValues(value, condition.operand, &result) && result <= 0;
+    case Regex:
+        return value.isString() && condition.regex.match(value.toString()).hasMatch();
+    default:
+        Q_UNREACHABLE();
+    }
+    return false;
+}
+
+QT_END_NAMESPACE
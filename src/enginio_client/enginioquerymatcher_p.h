@@ -0,0 +1,121 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOQUERYMATCHER_P_H
+#define ENGINIOQUERYMATCHER_P_H
+
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qregularexpression.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvector.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief The "query" filter of an object query, compiled into a predicate.
+
+    The filter is parsed once, matching an object afterwards does not
+    touch any strings except the property names. Supported are property
+    equality, the operators "$ne", "$gt", "$gte", "$lt", "$lte", "$in",
+    "$nin", "$exists" and "$regex" (with "$options"), "$and" and "$or",
+    dotted paths like "creator.id" and {"$type": ..., "$value": ...}
+    literals.
+
+    As on the backend an array property matches if one of its elements
+    does, and null matches missing properties. Paths leading through an
+    array are not followed, such objects always match.
+
+    A filter using anything else can not be decided on the client, the
+    matcher is then invalid and matches every object.
+
+    The models use it to drop notifications about objects their query
+    would not return.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioQueryMatcher
+{
+public:
+    EnginioQueryMatcher();
+
+    static EnginioQueryMatcher compile(const QJsonObject &filter) Q_REQUIRED_RESULT;
+
+    bool isValid() const Q_REQUIRED_RESULT { return _root != InvalidCondition; }
+    bool matches(const QJsonObject &object) const Q_REQUIRED_RESULT;
+
+private:
+    enum Operator {
+        And,
+        Or,
+        Equal,
+        NotEqual,
+        Greater,
+        GreaterOrEqual,
+        Less,
+        LessOrEqual,
+        In,
+        NotIn,
+        Exists,
+        Regex
+    };
+
+    // Conditions are stored in a flat vector, "$and" and "$or" refer to
+    // their operands by index.
+    struct Condition
+    {
+        Operator op;
+        QStringList path;
+        QJsonValue operand;
+        QVector<QJsonValue> operands;
+        QRegularExpression regex;
+        QVector<int> children;
+    };
+
+    const static int InvalidCondition = -1;
+
+    int compileFilter(const QJsonObject &filter);
+    bool compileOperators(const QStringList &path, const QJsonObject &operators, QVector<int> *children);
+    int append(const Condition &condition);
+    bool evaluate(int index, const QJsonObject &object) const;
+    static bool evaluateValue(const Condition &condition, const QJsonValue &value);
+
+    QVector<Condition> _conditions;
+    int _root;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOQUERYMATCHER_P_H
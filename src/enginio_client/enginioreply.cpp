@@ -196,9 +196,6 @@ void EnginioReplyStatePrivate::setNetworkReply(QNetworkReply *reply)
     Q_Q(EnginioReplyState);
     _client->unregisterReply(_nreply);
 
-    if (gEnableEnginioDebugInfo)
-        _client->_requestData.remove(_nreply);
-
     if (!_nreply->isFinished()) {
         _nreply->setParent(_nreply->manager());
         QObject::connect(_nreply, &QNetworkReply::finished, _nreply, &QNetworkReply::deleteLater);
@@ -207,7 +204,8 @@ void EnginioReplyStatePrivate::setNetworkReply(QNetworkReply *reply)
         _nreply->deleteLater();
     }
     _nreply = reply;
-    _data = QByteArray();
+    clearData();
+    connectFirstByte();
 
     _client->registerReply(reply, q);
 }
@@ -229,7 +227,11 @@ void EnginioReplyStatePrivate::swapNetworkReply(EnginioReplyStatePrivate *other)
     _client->unregisterReply(other->_nreply);
 
     qSwap(_nreply, other->_nreply);
-    _data = other->_data = QByteArray();
+    qSwap(_timing, other->_timing);
+    clearData();
+    other->clearData();
+    connectFirstByte();
+    other->connectFirstByte();
 
     _client->registerReply(_nreply, q);
     _client->registerReply(other->_nreply, other->q_func());
@@ -343,6 +345,8 @@ EnginioReplyState::EnginioReplyState(EnginioClientConnectionPrivate *parent, QNe
     : QObject(*priv, parent->q_ptr)
 {
     parent->registerReply(reply, this);
+    if (Q_UNLIKELY(parent->_requestTiming))
+        priv->startTiming();
 }
 
 EnginioReplyState::~EnginioReplyState()
@@ -353,7 +357,9 @@ EnginioReplyState::~EnginioReplyState()
         QObject::connect(d->_nreply, &QNetworkReply::finished, d->_nreply, &QNetworkReply::deleteLater);
         d->_client->unregisterReply(d->_nreply);
         d->_nreply->setParent(d->_nreply->manager());
-        d->_nreply->abort();
+        // Other queries may wait for the result of this one.
+        if (!d->_client->hasSharedQueryFollowers(d->_nreply))
+            d->_nreply->abort();
     }
 }
 
@@ -366,5 +372,28 @@ QJsonObject EnginioReplyState::data() const
     return d->data();
 }
 
+/*!
+  \fn QJsonObject EnginioReplyState::timing() const
+  \since 1.8
+  Returns the timing record of the request, or an empty object if
+  EnginioClientConnection::isRequestTimingEnabled() was false when the
+  request was sent.
+
+  The stages are milliseconds relative to the creation of the request:
+  \c created, \c sent (accepted by the QNetworkAccessManager), \c firstByte
+  (response headers received), \c finished, \c parsed (data() parsed the
+  body) and \c delivered (the finished signals returned). Stages which were
+  not reached yet are left out. \c parseDuration is the time spent in parsing
+  the body, and \c serverTiming holds the metrics of the Server-Timing header
+  if the backend sent one.
+
+  \sa EnginioClientConnection::requestTimingStatistics()
+*/
+QJsonObject EnginioReplyState::timing() const
+{
+    Q_D(const EnginioReplyState);
+    return d->_timing.toJson();
+}
+
 QT_END_NAMESPACE
 
@@ -55,7 +55,13 @@ public:
     EnginioClientConnectionPrivate *_client;
     QNetworkReply *_nreply;
     mutable QByteArray _data;
+    mutable QJsonObject _jsonData;
+    mutable bool _jsonDataParsed;
+    mutable QString _requestId;
     bool _delay;
+    // Empty unless the client had request timing enabled when the request was prepared
+    mutable EnginioRequestTiming _timing;
+    QMetaObject::Connection _firstByteConnection;
 
     static EnginioReplyStatePrivate *get(EnginioReplyState *p)
     {
@@ -66,6 +72,7 @@ public:
     EnginioReplyStatePrivate(EnginioClientConnectionPrivate *p, QNetworkReply *reply)
         : _client(p)
         , _nreply(reply)
+        , _jsonDataParsed(false)
         , _delay(false)
     {
         Q_ASSERT(reply);
@@ -88,7 +95,10 @@ public:
 
     QString requestId() const Q_REQUIRED_RESULT
     {
-        return QString::fromUtf8(_nreply->request().rawHeader(EnginioString::X_Request_Id));
+        // Asked for by the models for every reply and notification echo
+        if (_requestId.isNull())
+            _requestId = QString::fromLatin1(_nreply->request().rawHeader(EnginioString::X_Request_Id));
+        return _requestId;
     }
 
     QString errorString() const Q_REQUIRED_RESULT
@@ -109,7 +119,21 @@ public:
 
     QJsonObject data() const Q_REQUIRED_RESULT
     {
-        return QJsonDocument::fromJson(pData()).object();
+        // Models and user code may ask for the data many times, parse it once
+        if (!_jsonDataParsed && _nreply->isFinished()) {
+            if (Q_UNLIKELY(_timing.isValid())) {
+                const QByteArray data = pData();
+                const qint64 start = _client->_timingClock.nsecsElapsed();
+                _jsonData = QJsonDocument::fromJson(data).object();
+                const qint64 end = _client->_timingClock.nsecsElapsed();
+                _timing.stamp(EnginioRequestTiming::Parsed, end);
+                _timing.setParseDuration(end - start);
+            } else {
+                _jsonData = QJsonDocument::fromJson(pData()).object();
+            }
+            _jsonDataParsed = true;
+        }
+        return _jsonData;
     }
 
     QByteArray pData() const Q_REQUIRED_RESULT
@@ -140,7 +164,7 @@ public:
         qDebug() << "  RawHeaders[Content-Type]:" << request.rawHeader(EnginioString::Content_Type);
         qDebug() << "  RawHeaders[X_Request_Id]:" << request.rawHeader(EnginioString::X_Request_Id);
 
-        QByteArray json = _client->_requestData.value(_nreply);
+        QByteArray json = _client->_requestLog.payload(_nreply);
         if (!json.isEmpty()) {
             if (request.url().toString(QUrl::None).endsWith(QString::fromUtf8("account/auth/identity")))
                 qDebug() << "Request Data hidden because it contains password";
@@ -151,6 +175,69 @@ public:
             qDebug() << "Reply Data:" << pData();
     }
 
+    class FirstByteFunctor
+    {
+        EnginioReplyStatePrivate *_reply;
+    public:
+        FirstByteFunctor(EnginioReplyStatePrivate *reply)
+            : _reply(reply)
+        {}
+        void operator ()()
+        {
+            _reply->stampFirstByte();
+        }
+    };
+
+    void startTiming()
+    {
+        _timing.start(_nreply->request(), _client->_timingClock.nsecsElapsed());
+        connectFirstByte();
+    }
+
+    void connectFirstByte()
+    {
+        QObject::disconnect(_firstByteConnection);
+        if (_timing.isValid() && !_timing.contains(EnginioRequestTiming::FirstByte))
+            _firstByteConnection = QObject::connect(_nreply, &QNetworkReply::metaDataChanged, q_func(), FirstByteFunctor(this));
+    }
+
+    void stampFirstByte()
+    {
+        QObject::disconnect(_firstByteConnection);
+        _timing.stamp(EnginioRequestTiming::FirstByte, _client->_timingClock.nsecsElapsed());
+    }
+
+    void stampFinished()
+    {
+        if (Q_LIKELY(!_timing.isValid()))
+            return;
+        const qint64 now = _client->_timingClock.nsecsElapsed();
+        if (!_timing.contains(EnginioRequestTiming::FirstByte)) {
+            // Replies without headers, like the ones of failed connections
+            QObject::disconnect(_firstByteConnection);
+            _timing.stamp(EnginioRequestTiming::FirstByte, now);
+        }
+        _timing.stamp(EnginioRequestTiming::Finished, now);
+        const QByteArray serverTiming = _nreply->rawHeader(EnginioString::Server_Timing);
+        if (!serverTiming.isEmpty())
+            _timing.setServerTiming(serverTiming);
+    }
+
+    void setParsedData(const QByteArray &data, const QJsonObject &json)
+    {
+        _data = data;
+        _jsonData = json;
+        _jsonDataParsed = true;
+    }
+
+    virtual void clearData()
+    {
+        _requestId = QString();
+        _data = QByteArray();
+        _jsonData = QJsonObject();
+        _jsonDataParsed = false;
+    }
+
     virtual void emitFinished() = 0;
     void setNetworkReply(QNetworkReply *reply);
     void swapNetworkReply(EnginioReplyStatePrivate *other);
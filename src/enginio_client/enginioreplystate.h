@@ -82,6 +82,7 @@ public:
     void setNetworkReply(QNetworkReply *reply);
 
     QJsonObject data() const Q_REQUIRED_RESULT;
+    QJsonObject timing() const Q_REQUIRED_RESULT;
 
 public Q_SLOTS:
     void dumpDebugInfo() const;
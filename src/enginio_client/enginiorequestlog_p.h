@@ -0,0 +1,159 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOREQUESTLOG_P_H
+#define ENGINIOREQUESTLOG_P_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qvector.h>
+#include <QtNetwork/qnetworkreply.h>
+
+#include <Enginio/enginioclient_global.h>
+#include <Enginio/private/enginiostring_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+  \internal
+  Keeps the payloads of the most recent requests for EnginioReply::dumpDebugInfo().
+
+  The log is a ring of a fixed number of entries which also respects a byte
+  budget, older payloads are dropped first and a payload larger than the
+  budget is truncated. Entries are keyed by the request id, so they stay
+  valid after the network reply was deleted. With a sampling of n only every
+  n-th request is kept. Nothing is allocated until the first payload is
+  recorded, and nothing is recorded if gEnableEnginioDebugInfo is false.
+
+  ENGINIO_DEBUG_INFO_BUDGET and ENGINIO_DEBUG_INFO_SAMPLING override the
+  defaults.
+*/
+class EnginioRequestLog
+{
+    struct Entry
+    {
+        QByteArray requestId;
+        QByteArray payload;
+    };
+
+    QVector<Entry> _entries;
+    int _next;
+    int _bytes;
+    int _budget;
+    int _sampling;
+    unsigned _requestCount;
+
+    static int environmentValue(const char *name, int defaultValue)
+    {
+        bool ok;
+        const int value = qgetenv(name).toInt(&ok);
+        return ok && value >= 0 ? value : defaultValue;
+    }
+
+    void drop(Entry &entry)
+    {
+        _bytes -= entry.payload.size();
+        entry = Entry();
+    }
+
+public:
+    enum {
+        DefaultCapacity = 32,
+        DefaultBudget = 256 * 1024,
+        DefaultSampling = 1
+    };
+
+    EnginioRequestLog()
+        : _next(0)
+        , _bytes(0)
+        , _budget(environmentValue("ENGINIO_DEBUG_INFO_BUDGET", DefaultBudget))
+        , _sampling(environmentValue("ENGINIO_DEBUG_INFO_SAMPLING", DefaultSampling))
+        , _requestCount(0)
+    {}
+
+    /*!
+      \internal
+      Returns true if the payload of the request about to be sent should be
+      recorded, it has to be called once per request.
+    */
+    bool sample()
+    {
+        if (!gEnableEnginioDebugInfo || !_budget || !_sampling)
+            return false;
+        return _requestCount++ % _sampling == 0;
+    }
+
+    void record(const QNetworkReply *reply, const QByteArray &payload)
+    {
+        if (payload.isEmpty())
+            return;
+        if (_entries.isEmpty())
+            _entries.resize(DefaultCapacity);
+
+        Entry &entry = _entries[_next];
+        drop(entry);
+        _next = (_next + 1) % _entries.count();
+
+        entry.requestId = reply->request().rawHeader(EnginioString::X_Request_Id);
+        entry.payload = payload.size() > _budget ? payload.left(_budget) : payload;
+        _bytes += entry.payload.size();
+
+        // Make room within the budget, starting with the oldest entry
+        for (int i = _next; _bytes > _budget; i = (i + 1) % _entries.count())
+            drop(_entries[i]);
+    }
+
+    QByteArray payload(const QNetworkReply *reply) const Q_REQUIRED_RESULT
+    {
+        const QByteArray requestId = reply->request().rawHeader(EnginioString::X_Request_Id);
+        for (int i = 0; i < _entries.count(); ++i) {
+            if (_entries[i].requestId == requestId)
+                return _entries[i].payload;
+        }
+        return QByteArray();
+    }
+
+    int bytes() const Q_REQUIRED_RESULT { return _bytes; }
+    void setBudget(int bytes) { _budget = bytes; clear(); }
+    void setSampling(int sampling) { _sampling = sampling; _requestCount = 0; }
+    void clear()
+    {
+        _entries.clear();
+        _next = 0;
+        _bytes = 0;
+    }
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOREQUESTLOG_P_H
@@ -0,0 +1,311 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <Enginio/private/enginiorequesttiming_p.h>
+#include <Enginio/enginio.h>
+
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qmetaobject.h>
+#include <QtCore/qvariant.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+const char *StageNames[EnginioRequestTiming::StageCount] = {
+    "created",
+    "sent",
+    "firstByte",
+    "finished",
+    "parsed",
+    "delivered"
+};
+
+const char *PhaseNames[EnginioRequestTimingStatistics::PhaseCount] = {
+    "queued",
+    "waiting",
+    "receiving",
+    "delivering",
+    "parsing",
+    "server",
+    "total"
+};
+
+inline double toMsecs(qint64 nsecs)
+{
+    return nsecs / 1000000.0;
+}
+
+// Splits at separator, but not inside a quoted string
+QList<QByteArray> splitUnquoted(const QByteArray &value, char separator)
+{
+    QList<QByteArray> result;
+    bool quoted = false;
+    int start = 0;
+    for (int i = 0; i < value.size(); ++i) {
+        const char c = value.at(i);
+        if (c == '"')
+            quoted = !quoted;
+        else if (c == '\\' && quoted)
+            ++i;
+        else if (c == separator && !quoted) {
+            result.append(value.mid(start, i - start).trimmed());
+            start = i + 1;
+        }
+    }
+    result.append(value.mid(start).trimmed());
+    return result;
+}
+
+QByteArray unquote(const QByteArray &value)
+{
+    if (value.size() < 2 || !value.startsWith('"') || !value.endsWith('"'))
+        return value;
+    QByteArray result;
+    result.reserve(value.size() - 2);
+    for (int i = 1; i < value.size() - 1; ++i) {
+        if (value.at(i) == '\\' && i + 1 < value.size() - 1)
+            ++i;
+        result.append(value.at(i));
+    }
+    return result;
+}
+
+} // namespace
+
+EnginioRequestTiming::EnginioRequestTiming()
+    : _parseDuration(-1)
+    , _operation(CustomRequest)
+{
+    for (int i = 0; i < StageCount; ++i)
+        _stamps[i] = -1;
+}
+
+/*!
+  \internal
+  Starts the record of a request which was just handed to the network
+  access manager, \a now is the time of the client's timing clock.
+*/
+void EnginioRequestTiming::start(const QNetworkRequest &request, qint64 now)
+{
+    const QVariant created = request.attribute(CreatedAttribute);
+    if (!created.isValid())
+        return;
+    _stamps[Created] = created.toLongLong();
+    _stamps[Sent] = now;
+    _operation = request.attribute(OperationAttribute, int(CustomRequest)).toInt();
+}
+
+qint64 EnginioRequestTiming::elapsed(Stage from, Stage to) const
+{
+    if (!contains(from) || !contains(to) || _stamps[to] < _stamps[from])
+        return -1;
+    return _stamps[to] - _stamps[from];
+}
+
+double EnginioRequestTiming::serverDuration() const
+{
+    double duration = -1;
+    for (QJsonObject::const_iterator i = _serverTiming.constBegin(); i != _serverTiming.constEnd(); ++i) {
+        const QJsonValue value = i.value().toObject().value(QStringLiteral("duration"));
+        if (value.isDouble())
+            duration = qMax(duration, 0.0) + value.toDouble();
+    }
+    return duration;
+}
+
+/*!
+  \internal
+  Returns the stages as milliseconds relative to the creation of the request.
+  Stages which were not reached are left out.
+*/
+QJsonObject EnginioRequestTiming::toJson() const
+{
+    QJsonObject result;
+    if (!isValid())
+        return result;
+
+    result[QStringLiteral("operation")] = operationName(_operation);
+    for (int i = 0; i < StageCount; ++i) {
+        if (contains(Stage(i)))
+            result[QString::fromLatin1(StageNames[i])] = toMsecs(_stamps[i] - _stamps[Created]);
+    }
+    if (_parseDuration >= 0)
+        result[QStringLiteral("parseDuration")] = toMsecs(_parseDuration);
+    if (!_serverTiming.isEmpty())
+        result[QStringLiteral("serverTiming")] = _serverTiming;
+    return result;
+}
+
+/*!
+  \internal
+  Parses a Server-Timing header like \c{db;dur=53.2, cache;desc="Cache Read";dur=23}
+  into \c{{"db": {"duration": 53.2}, "cache": {"duration": 23, "description": "Cache Read"}}}.
+*/
+QJsonObject EnginioRequestTiming::parseServerTiming(const QByteArray &header)
+{
+    QJsonObject result;
+    foreach (const QByteArray &metric, splitUnquoted(header, ',')) {
+        const QList<QByteArray> parameters = splitUnquoted(metric, ';');
+        const QByteArray name = parameters.first();
+        if (name.isEmpty())
+            continue;
+
+        QJsonObject entry;
+        for (int i = 1; i < parameters.count(); ++i) {
+            const QByteArray &parameter = parameters.at(i);
+            const int equals = parameter.indexOf('=');
+            const QByteArray key = parameter.left(equals).trimmed().toLower();
+            const QByteArray value = equals < 0 ? QByteArray() : unquote(parameter.mid(equals + 1).trimmed());
+            if (key == "dur") {
+                bool ok;
+                const double duration = value.toDouble(&ok);
+                if (ok)
+                    entry[QStringLiteral("duration")] = duration;
+            } else if (key == "desc") {
+                entry[QStringLiteral("description")] = QString::fromUtf8(value);
+            }
+        }
+        result[QString::fromUtf8(name)] = entry;
+    }
+    return result;
+}
+
+QString EnginioRequestTiming::operationName(int operation)
+{
+    if (operation == CustomRequest)
+        return QStringLiteral("CustomRequest");
+    const QMetaObject &metaObject = Enginio::staticMetaObject;
+    const QMetaEnum operations = metaObject.enumerator(metaObject.indexOfEnumerator("Operation"));
+    const char *name = operations.valueToKey(operation);
+    return name ? QString::fromLatin1(name) : QString::number(operation);
+}
+
+// Upper bounds in milliseconds, the last bucket counts everything above
+const double EnginioRequestTimingHistogram::BucketBounds[BucketCount - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000
+};
+
+EnginioRequestTimingHistogram::EnginioRequestTimingHistogram()
+    : _count(0)
+    , _sum(0)
+    , _min(0)
+    , _max(0)
+{
+    for (int i = 0; i < BucketCount; ++i)
+        _buckets[i] = 0;
+}
+
+void EnginioRequestTimingHistogram::add(double msecs)
+{
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && msecs > BucketBounds[bucket])
+        ++bucket;
+    ++_buckets[bucket];
+    _min = _count ? qMin(_min, msecs) : msecs;
+    _max = _count ? qMax(_max, msecs) : msecs;
+    _sum += msecs;
+    ++_count;
+}
+
+QJsonObject EnginioRequestTimingHistogram::toJson() const
+{
+    QJsonObject result;
+    QJsonArray buckets;
+    for (int i = 0; i < BucketCount; ++i)
+        buckets.append(_buckets[i]);
+    result[QStringLiteral("count")] = _count;
+    result[QStringLiteral("min")] = _min;
+    result[QStringLiteral("max")] = _max;
+    result[QStringLiteral("mean")] = _count ? _sum / _count : 0;
+    result[QStringLiteral("buckets")] = buckets;
+    return result;
+}
+
+void EnginioRequestTimingStatistics::add(const EnginioRequestTiming &timing)
+{
+    typedef EnginioRequestTiming Timing;
+    if (!timing.isValid())
+        return;
+
+    qint64 elapsed[PhaseCount];
+    elapsed[Queued] = timing.elapsed(Timing::Created, Timing::Sent);
+    elapsed[Waiting] = timing.elapsed(Timing::Sent, Timing::FirstByte);
+    elapsed[Receiving] = timing.elapsed(Timing::FirstByte, Timing::Finished);
+    elapsed[Delivering] = timing.elapsed(Timing::Finished, Timing::Delivered);
+    elapsed[Parsing] = timing.parseDuration();
+    elapsed[Server] = -1;
+    elapsed[Total] = timing.elapsed(Timing::Created, Timing::Delivered);
+
+    Histograms &histograms = _operations[timing.operation()];
+    for (int i = 0; i < PhaseCount; ++i) {
+        if (elapsed[i] >= 0)
+            histograms.phases[i].add(toMsecs(elapsed[i]));
+    }
+    const double server = timing.serverDuration();
+    if (server >= 0)
+        histograms.phases[Server].add(server);
+}
+
+/*!
+  \internal
+  Returns a snapshot of the histograms of every operation, with the bucket
+  bounds in milliseconds:
+  \c{{"bounds": [1, 2, ...], "operations": {"ObjectOperation": {"total": {"count": 3, ...}, ...}}}}
+  Phases without any sample are left out.
+*/
+QJsonObject EnginioRequestTimingStatistics::toJson() const
+{
+    QJsonArray bounds;
+    for (int i = 0; i < EnginioRequestTimingHistogram::BucketCount - 1; ++i)
+        bounds.append(EnginioRequestTimingHistogram::BucketBounds[i]);
+
+    QJsonObject operations;
+    for (QMap<int, Histograms>::const_iterator i = _operations.constBegin(); i != _operations.constEnd(); ++i) {
+        QJsonObject phases;
+        for (int phase = 0; phase < PhaseCount; ++phase) {
+            const EnginioRequestTimingHistogram &histogram = i.value().phases[phase];
+            if (histogram.count())
+                phases[QString::fromLatin1(PhaseNames[phase])] = histogram.toJson();
+        }
+        operations[EnginioRequestTiming::operationName(i.key())] = phases;
+    }
+
+    QJsonObject result;
+    result[QStringLiteral("bounds")] = bounds;
+    result[QStringLiteral("operations")] = operations;
+    return result;
+}
+
+QT_END_NAMESPACE
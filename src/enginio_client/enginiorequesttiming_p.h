@@ -0,0 +1,144 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOREQUESTTIMING_P_H
+#define ENGINIOREQUESTTIMING_P_H
+
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qmap.h>
+#include <QtNetwork/qnetworkrequest.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+class ENGINIOCLIENT_EXPORT EnginioRequestTiming
+{
+public:
+    enum Stage {
+        Created,    // the request was prepared
+        Sent,       // QNetworkAccessManager accepted the request
+        FirstByte,  // the response headers arrived
+        Finished,   // the whole response arrived
+        Parsed,     // the body was parsed by EnginioReply::data()
+        Delivered,  // the finished signals were delivered
+        StageCount
+    };
+
+    enum { CustomRequest = -1 };
+
+    // Set by EnginioClientConnectionPrivate::prepareRequest() if timing is enabled,
+    // counted down from UserMax to stay out of the way of application attributes.
+    static const QNetworkRequest::Attribute CreatedAttribute = QNetworkRequest::Attribute(QNetworkRequest::UserMax - 1);
+    static const QNetworkRequest::Attribute OperationAttribute = QNetworkRequest::Attribute(QNetworkRequest::UserMax - 2);
+
+    EnginioRequestTiming();
+
+    // Returns false if the request was sent without timing
+    bool isValid() const Q_REQUIRED_RESULT { return _stamps[Created] >= 0; }
+    void start(const QNetworkRequest &request, qint64 now);
+
+    bool contains(Stage stage) const Q_REQUIRED_RESULT { return _stamps[stage] >= 0; }
+    void stamp(Stage stage, qint64 now) { _stamps[stage] = now; }
+    qint64 elapsed(Stage from, Stage to) const Q_REQUIRED_RESULT;
+
+    qint64 parseDuration() const Q_REQUIRED_RESULT { return _parseDuration; }
+    void setParseDuration(qint64 nsecs) { _parseDuration = nsecs; }
+
+    int operation() const Q_REQUIRED_RESULT { return _operation; }
+    QJsonObject serverTiming() const Q_REQUIRED_RESULT { return _serverTiming; }
+    void setServerTiming(const QByteArray &header) { _serverTiming = parseServerTiming(header); }
+    double serverDuration() const Q_REQUIRED_RESULT;
+
+    QJsonObject toJson() const Q_REQUIRED_RESULT;
+
+    static QJsonObject parseServerTiming(const QByteArray &header) Q_REQUIRED_RESULT;
+    static QString operationName(int operation) Q_REQUIRED_RESULT;
+
+private:
+    qint64 _stamps[StageCount];
+    qint64 _parseDuration;
+    int _operation;
+    QJsonObject _serverTiming;
+};
+
+class ENGINIOCLIENT_EXPORT EnginioRequestTimingHistogram
+{
+public:
+    enum { BucketCount = 13 };
+    static const double BucketBounds[BucketCount - 1];
+
+    EnginioRequestTimingHistogram();
+
+    void add(double msecs);
+    int count() const Q_REQUIRED_RESULT { return _count; }
+    QJsonObject toJson() const Q_REQUIRED_RESULT;
+
+private:
+    int _buckets[BucketCount];
+    int _count;
+    double _sum;
+    double _min;
+    double _max;
+};
+
+class ENGINIOCLIENT_EXPORT EnginioRequestTimingStatistics
+{
+public:
+    enum Phase {
+        Queued,     // Created -> Sent
+        Waiting,    // Sent -> FirstByte
+        Receiving,  // FirstByte -> Finished
+        Delivering, // Finished -> Delivered
+        Parsing,    // time spent in parsing the body
+        Server,     // sum of the Server-Timing durations
+        Total,      // Created -> Delivered
+        PhaseCount
+    };
+
+    void add(const EnginioRequestTiming &timing);
+    void clear() { _operations.clear(); }
+    QJsonObject toJson() const Q_REQUIRED_RESULT;
+
+private:
+    struct Histograms
+    {
+        EnginioRequestTimingHistogram phases[PhaseCount];
+    };
+    QMap<int, Histograms> _operations;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOREQUESTTIMING_P_H
@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <Enginio/private/enginiosharedreply_p.h>
+#include <Enginio/private/enginioclient_p.h>
+#include <QtCore/qmetaobject.h>
+#include <QtNetwork/qnetworkrequest.h>
+
+QT_BEGIN_NAMESPACE
+
+struct SharedReplyFinishedFunctor
+{
+    QNetworkAccessManager *_qnam;
+    EnginioSharedReply *_reply;
+    void operator ()()
+    {
+        _qnam->finished(_reply);
+    }
+};
+
+EnginioSharedReply::EnginioSharedReply(EnginioClientConnectionPrivate *parent, const QNetworkRequest &request)
+    : QNetworkReply(parent->q_ptr)
+    , _qnam(parent->networkManager())
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::GetOperation);
+}
+
+/*!
+    \internal
+    Takes over the result of \a reply, whose body is \a data.
+*/
+void EnginioSharedReply::finishFrom(const QNetworkReply *reply, const QByteArray &data)
+{
+    if (isFinished())
+        return;
+
+    _data = data;
+    foreach (const RawHeaderPair &header, reply->rawHeaderPairs())
+        setRawHeader(header.first, header.second);
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, reply->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+    setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute));
+    if (reply->error() != NoError)
+        setError(reply->error(), reply->errorString());
+    QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    emitFinished();
+}
+
+void EnginioSharedReply::abort()
+{
+    if (isFinished())
+        return;
+    QNetworkReply::close();
+    setError(OperationCanceledError, tr("Operation canceled"));
+    emitFinished();
+}
+
+void EnginioSharedReply::emitFinished()
+{
+    setFinished(true);
+    SharedReplyFinishedFunctor fin = {_qnam, this};
+    QObject::connect(this, &EnginioSharedReply::finished, fin);
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+}
+
+bool EnginioSharedReply::isSequential() const
+{
+    return false;
+}
+
+qint64 EnginioSharedReply::size() const
+{
+    return _data.size();
+}
+
+qint64 EnginioSharedReply::readData(char *dest, qint64 n)
+{
+    if (pos() > _data.size())
+        return -1;
+    qint64 size = qMin(qint64(_data.size() - pos()), n);
+    memcpy(dest, _data.constData() + pos(), size);
+    return size;
+}
+
+qint64 EnginioSharedReply::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+QT_END_NAMESPACE
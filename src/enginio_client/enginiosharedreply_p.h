@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef ENGINIOSHAREDREPLY_P_H
+#define ENGINIOSHAREDREPLY_P_H
+
+#include <Enginio/enginioclient_global.h>
+
+#include <QtNetwork/qnetworkreply.h>
+#include <QtCore/qbytearray.h>
+
+QT_BEGIN_NAMESPACE
+
+class EnginioClientConnectionPrivate;
+
+/*!
+    \brief The reply of a query sent while an identical one was in flight.
+
+    The reply does not send a request of its own. It finishes together with
+    the reply of the first query and gets a copy of its status, headers and
+    body.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioSharedReply : public QNetworkReply
+{
+    Q_OBJECT
+    QByteArray _data;
+    QNetworkAccessManager *_qnam;
+public:
+    explicit EnginioSharedReply(EnginioClientConnectionPrivate *parent, const QNetworkRequest &request);
+
+    void finishFrom(const QNetworkReply *reply, const QByteArray &data);
+
+    virtual void abort() Q_DECL_OVERRIDE;
+    virtual bool isSequential() const Q_DECL_OVERRIDE;
+    virtual qint64 size() const Q_DECL_OVERRIDE;
+    virtual qint64 readData(char *dest, qint64 n) Q_DECL_OVERRIDE;
+    virtual qint64 writeData(const char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+
+private:
+    void emitFinished();
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOSHAREDREPLY_P_H
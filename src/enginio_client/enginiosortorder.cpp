@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <Enginio/private/enginiosortorder_p.h>
+#include <Enginio/private/enginioobjectproperties_p.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+bool isComparable(const QJsonValue &value)
+{
+    return value.isDouble() || value.isString() || value.isBool();
+}
+
+} // namespace
+
+EnginioSortOrder EnginioSortOrder::fromJson(const QJsonValue &sort)
+{
+    EnginioSortOrder order;
+    const QJsonArray keys = sort.toArray();
+    order._keys.reserve(keys.count());
+    foreach (const QJsonValue &value, keys) {
+        const QJsonObject key = value.toObject();
+        const QString sortBy = key.value(QStringLiteral("sortBy")).toString();
+        if (sortBy.isEmpty())
+            continue;
+        Key compiled;
+        compiled.path = sortBy.split(QLatin1Char('.'));
+        compiled.descending = key.value(QStringLiteral("direction")).toString() == QStringLiteral("desc");
+        order._keys.append(compiled);
+    }
+    return order;
+}
+
+/*!
+    \internal
+    Returns a negative number if \a a sorts before \a b, a positive one
+    if it sorts after it and 0 if their order is undefined.
+*/
+int EnginioSortOrder::compare(const QJsonObject &a, const QJsonObject &b) const
+{
+    foreach (const Key &key, _keys) {
+        const QJsonValue left = EnginioObjectProperties::propertyValue(a, key.path);
+        const QJsonValue right = EnginioObjectProperties::propertyValue(b, key.path);
+        int result;
+        if (!EnginioObjectProperties::compareValues(left, right, &result)) {
+            // Missing values come last
+            result = int(!isComparable(left)) - int(!isComparable(right));
+            if (result)
+                return result;
+            continue;
+        }
+        if (result)
+            return key.descending ? -result : result;
+    }
+    return 0;
+}
+
+/*!
+    \internal
+    Returns true if the object at \a row is in order with its neighbours.
+*/
+bool EnginioSortOrder::isInOrder(const QJsonArray &rows, int row) const
+{
+    const QJsonObject object = rows.at(row).toObject();
+    if (row > 0 && compare(rows.at(row - 1).toObject(), object) > 0)
+        return false;
+    if (row + 1 < rows.count() && compare(object, rows.at(row + 1).toObject()) > 0)
+        return false;
+    return true;
+}
+
+/*!
+    \internal
+    Returns the row at which \a object has to be inserted into the sorted
+    \a rows, behind the objects sorting equal to it. If \a excludedRow is
+    given, the row is treated as if it was removed already, the result is
+    the row the object has once it is taken out from there.
+*/
+int EnginioSortOrder::insertionRow(const QJsonArray &rows, const QJsonObject &object, int excludedRow) const
+{
+    int low = 0;
+    int high = rows.count() - (excludedRow == -1 ? 0 : 1);
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        const int row = excludedRow != -1 && middle >= excludedRow ? middle + 1 : middle;
+        if (compare(object, rows.at(row).toObject()) < 0)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+QT_END_NAMESPACE
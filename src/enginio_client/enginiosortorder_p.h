@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef ENGINIOSORTORDER_P_H
+#define ENGINIOSORTORDER_P_H
+
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvector.h>
+
+#include <Enginio/enginioclient_global.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \brief The "sort" option of a query, compiled into a comparator.
+
+    The option is a list of keys like
+    \code
+    [{"sortBy": "createdAt", "direction": "desc"}, {"sortBy": "title"}]
+    \endcode
+    Numbers, strings and booleans are compared the way the backend does,
+    objects without a comparable value come last in either direction.
+
+    The models use it to put created and updated objects where the backend
+    would return them, instead of at the end.
+
+    \internal
+*/
+class ENGINIOCLIENT_EXPORT EnginioSortOrder
+{
+public:
+    static EnginioSortOrder fromJson(const QJsonValue &sort) Q_REQUIRED_RESULT;
+
+    bool isEmpty() const Q_REQUIRED_RESULT { return _keys.isEmpty(); }
+
+    int compare(const QJsonObject &a, const QJsonObject &b) const Q_REQUIRED_RESULT;
+    bool isInOrder(const QJsonArray &rows, int row) const Q_REQUIRED_RESULT;
+    int insertionRow(const QJsonArray &rows, const QJsonObject &object, int excludedRow = -1) const Q_REQUIRED_RESULT;
+
+private:
+    struct Key
+    {
+        QStringList path;
+        bool descending;
+    };
+
+    QVector<Key> _keys;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOSORTORDER_P_H
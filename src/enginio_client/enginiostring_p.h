@@ -40,6 +40,10 @@
 #define FOR_EACH_ENGINIO_STRING(F)\
     F(_synced, "_synced")\
     F(_delete, "delete")\
+    F(_and, "$and")\
+    F(_gt, "$gt")\
+    F(_type, "$type")\
+    F(_value, "$value")\
     F(access, "access")\
     F(access_token, "access_token")\
     F(apiEnginIo, "https://api.engin.io")\
@@ -57,6 +61,7 @@
     F(files, "files")\
     F(grant_type, "grant_type")\
     F(headers, "headers")\
+    F(https, "https")\
     F(id, "id")\
     F(include, "include")\
     F(incomplete, "incomplete")\
@@ -84,6 +89,7 @@
     F(stagingEnginIo, "https://staging.engin.io")\
     F(status, "status")\
     F(targetFileProperty, "targetFileProperty")\
+    F(time, "time")\
     F(update, "update")\
     F(updatedAt, "updatedAt")\
     F(url, "url")\
@@ -123,6 +129,7 @@
     F(EnginioModel_Trying_to_update_an_item_with_an_empty_object, "EnginioModel: Trying to update an item with an empty object")\
     F(Content_Range, "Content-Range")\
     F(Content_Type, "Content-Type")\
+    F(Server_Timing, "Server-Timing")\
     F(Get, "GET")\
     F(Accept, "Accept")\
     F(Bearer_, "Bearer ")\
@@ -20,6 +20,7 @@ TARGET.module_name = Enginio
 
 SOURCES += \
     enginioqmlclient.cpp \
+    enginioqmljsonconverter.cpp \
     enginioqmlmodel.cpp \
     enginioplugin.cpp \
     enginioqmlreply.cpp \
@@ -29,6 +30,7 @@ HEADERS += \
     enginioqmlclient_p_p.h \
     enginioplugin_p.h \
     enginioqmlclient_p.h \
+    enginioqmljsonconverter_p.h \
     enginioqmlmodel_p.h \
     enginioqmlreply_p.h
 
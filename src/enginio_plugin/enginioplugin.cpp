@@ -35,6 +35,7 @@
 #include "enginioqmlclient_p.h"
 #include "enginioqmlmodel_p.h"
 #include "enginioqmlreply_p.h"
+#include <Enginio/enginioaggregatemodel.h>
 #include <Enginio/enginiomodel.h>
 #include <Enginio/enginioreply.h>
 #include <Enginio/enginioidentity.h>
@@ -125,6 +126,52 @@ void EnginioPlugin::initializeEngine(QQmlEngine *engine, const char *uri)
 */
 
 
+/*!
+  \qmltype EnginioAggregateModel
+  \since 1.8
+  \instantiates EnginioAggregateModel
+  \inqmlmodule Enginio
+  \ingroup engino-qml
+  \brief Groups the rows of a model and keeps the count, sum, minimum and maximum of each group.
+
+  The model has a row for each distinct value of \l groupRole in
+  \l sourceModel, with the roles \c group, \c count, \c sum, \c minimum
+  and \c maximum. Created, changed and removed objects only update their
+  own group, instead of recomputing all of them.
+
+  \code
+    EnginioModel {
+        id: orders
+        client: client
+        query: { "objectType": "objects.orders" }
+    }
+    EnginioAggregateModel {
+        id: ordersPerCustomer
+        sourceModel: orders
+        groupRole: "customer"
+        valueRole: "total"
+    }
+  \endcode
+
+  \sa {EnginioAggregateModelCpp}{EnginioAggregateModel C++}
+*/
+
+/*!
+  \qmlproperty QAbstractItemModel EnginioAggregateModel::sourceModel
+  The model whose rows are grouped, usually an \l EnginioModel.
+*/
+
+/*!
+  \qmlproperty string EnginioAggregateModel::groupRole
+  The name of the role the rows of \l sourceModel are grouped by.
+*/
+
+/*!
+  \qmlproperty string EnginioAggregateModel::valueRole
+  The name of the role with the values summed up per group. Rows without
+  a numeric value are only counted.
+*/
+
 void EnginioPlugin::registerTypes(const char *uri)
 {
     // @uri Enginio
@@ -133,6 +180,7 @@ void EnginioPlugin::registerTypes(const char *uri)
     qmlRegisterType<EnginioQmlClient>(uri, 1, 0, "EnginioClient");
     qmlRegisterUncreatableType<EnginioBaseModel>(uri, 1, 0, "EnginioBaseModel", "EnginioBaseModel should not be instantiated in QML directly.");
     qmlRegisterType<EnginioQmlModel>(uri, 1, 0, "EnginioModel");
+    qmlRegisterType<EnginioAggregateModel>(uri, 1, 0, "EnginioAggregateModel");
     qmlRegisterUncreatableType<EnginioReplyState>(uri, 1, 0, "EnginioReplyState", "EnginioReplyState cannot be instantiated.");
     qmlRegisterUncreatableType<EnginioQmlReply>(uri, 1, 0, "EnginioReply", "EnginioReply cannot be instantiated.");
     qmlRegisterUncreatableType<EnginioIdentity>(uri, 1, 0, "EnginioIdentity", "EnginioIdentity can not be instantiated directly");
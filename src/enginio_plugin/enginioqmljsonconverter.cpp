@@ -0,0 +1,168 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "enginioqmljsonconverter_p.h"
+
+#include <Enginio/private/enginiostring_p.h>
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qnumeric.h>
+#include <QtQml/qjsengine.h>
+#include <QtQml/qjsvalueiterator.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// JSON.stringify() throws on cyclic structures, we stop at a depth which
+// no reasonable Enginio object reaches.
+const static int MaximumDepth = 512;
+
+QJsonValue convert(const QJSValue &value, int depth);
+
+inline bool isOmitted(const QJSValue &value)
+{
+    return value.isUndefined() || value.isCallable();
+}
+
+QJsonObject convertObject(const QJSValue &object, int depth)
+{
+    QJsonObject result;
+    QJSValueIterator it(object);
+    while (it.hasNext()) {
+        it.next();
+        const QJSValue property = it.value();
+        if (!isOmitted(property))
+            result.insert(it.name(), convert(property, depth));
+    }
+    return result;
+}
+
+QJsonArray convertArray(const QJSValue &array, int depth)
+{
+    QJsonArray result;
+    const quint32 length = array.property(EnginioString::length).toUInt();
+    for (quint32 i = 0; i < length; ++i) {
+        const QJSValue element = array.property(i);
+        result.append(isOmitted(element) ? QJsonValue(QJsonValue::Null) : convert(element, depth));
+    }
+    return result;
+}
+
+QJsonValue convert(const QJSValue &value, int depth)
+{
+    if (value.isString())
+        return value.toString();
+    if (value.isNumber()) {
+        const double number = value.toNumber();
+        return qIsFinite(number) ? QJsonValue(number) : QJsonValue(QJsonValue::Null);
+    }
+    if (value.isBool())
+        return value.toBool();
+    if (value.isNull())
+        return QJsonValue(QJsonValue::Null);
+    if (value.isUndefined())
+        return QJsonValue(QJsonValue::Undefined);
+
+    if (++depth > MaximumDepth) {
+        qWarning("EnginioQmlJsonConverter: the value is nested too deeply or contains a cycle");
+        return QJsonValue(QJsonValue::Null);
+    }
+
+    if (value.isDate()) {
+        // Date.prototype.toJSON() uses toISOString().
+        const QDateTime dateTime = value.toDateTime();
+        if (!dateTime.isValid())
+            return QJsonValue(QJsonValue::Null);
+        return dateTime.toUTC().toString(QStringLiteral("yyyy-MM-dd'T'HH:mm:ss.zzz'Z'"));
+    }
+    if (value.isArray())
+        return convertArray(value, depth);
+    if (value.isVariant())
+        return QJsonValue::fromVariant(value.toVariant());
+    if (value.isObject())
+        return convertObject(value, depth);
+    return QJsonValue(QJsonValue::Null);
+}
+
+} // namespace
+
+QJsonValue EnginioQmlJsonConverter::toJsonValue(const QJSValue &value)
+{
+    return convert(value, 0);
+}
+
+QJsonObject EnginioQmlJsonConverter::toJsonObject(const QJSValue &value)
+{
+    return convert(value, 0).toObject();
+}
+
+QJSValue EnginioQmlJsonConverter::toJSValue(QJSEngine *engine, const QJsonValue &value)
+{
+    Q_ASSERT(engine);
+    switch (value.type()) {
+    case QJsonValue::Null:
+        return QJSValue(QJSValue::NullValue);
+    case QJsonValue::Bool:
+        return QJSValue(value.toBool());
+    case QJsonValue::Double:
+        return QJSValue(value.toDouble());
+    case QJsonValue::String:
+        return QJSValue(value.toString());
+    case QJsonValue::Array: {
+        const QJsonArray array = value.toArray();
+        QJSValue result = engine->newArray(array.count());
+        for (int i = 0; i < array.count(); ++i)
+            result.setProperty(i, toJSValue(engine, array.at(i)));
+        return result;
+    }
+    case QJsonValue::Object:
+        return toJSValue(engine, value.toObject());
+    case QJsonValue::Undefined:
+        break;
+    }
+    return QJSValue();
+}
+
+QJSValue EnginioQmlJsonConverter::toJSValue(QJSEngine *engine, const QJsonObject &object)
+{
+    Q_ASSERT(engine);
+    QJSValue result = engine->newObject();
+    for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it)
+        result.setProperty(it.key(), toJSValue(engine, it.value()));
+    return result;
+}
+
+QT_END_NAMESPACE
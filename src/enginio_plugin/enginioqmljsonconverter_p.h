@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtEnginio module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOQMLJSONCONVERTER_P_H
+#define ENGINIOQMLJSONCONVERTER_P_H
+
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonvalue.h>
+#include <QtQml/qjsvalue.h>
+
+QT_BEGIN_NAMESPACE
+
+class QJSEngine;
+
+/*!
+    \brief Converts between QJSValue and QJsonValue trees directly.
+
+    The result is the same as a round trip through JSON.stringify() and
+    JSON.parse(), but no JSON text is produced in between. Like
+    JSON.stringify(), undefined values and functions are left out of objects
+    and become null in arrays, non finite numbers become null and dates
+    become ISO 8601 strings. toJSON() methods are not called.
+
+    \internal
+*/
+struct EnginioQmlJsonConverter
+{
+    static QJsonValue toJsonValue(const QJSValue &value) Q_REQUIRED_RESULT;
+    static QJsonObject toJsonObject(const QJSValue &value) Q_REQUIRED_RESULT;
+    static QJSValue toJSValue(QJSEngine *engine, const QJsonValue &value) Q_REQUIRED_RESULT;
+    static QJSValue toJSValue(QJSEngine *engine, const QJsonObject &object) Q_REQUIRED_RESULT;
+};
+
+QT_END_NAMESPACE
+
+#endif // ENGINIOQMLJSONCONVERTER_P_H
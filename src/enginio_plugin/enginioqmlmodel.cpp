@@ -37,6 +37,7 @@
 #include "enginioqmlclient_p_p.h"
 #include "enginioqmlreply_p.h"
 #include "enginioqmlobjectadaptor_p.h"
+#include "enginioqmljsonconverter_p.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -84,6 +85,13 @@ QT_BEGIN_NAMESPACE
   The instance of \l EnginioClient used for this model.
 */
 
+/*!
+  \qmlproperty int EnginioModel::queryDebounceInterval
+  \since 1.8
+  The time in milliseconds to wait after a change of the \l query before
+  it is executed, 0 by default. Useful if the query follows user input.
+*/
+
 /*!
   \qmlproperty Enginio::Operation EnginioModel::operation
   The operation used for the \l query.
@@ -133,21 +141,13 @@ public:
 
     QJSValue convert(const QJsonObject &object) const
     {
-        // TODO that is sooo bad, that I can not look at this.
-        // TODO trace all calls and try to remove them
         EnginioQmlClientPrivate *enginio = static_cast<EnginioQmlClientPrivate*>(_enginio);
-        QJsonDocument doc(object);
-        QByteArray buffer = doc.toJson(QJsonDocument::Compact);
-        return enginio->fromJson(buffer);
+        return EnginioQmlJsonConverter::toJSValue(enginio->jsengine(), object);
     }
 
     QJsonObject convert(const QJSValue &object) const
     {
-        // TODO that is sooo bad, that I can not look at this.
-        // TODO trace all calls and try to remove them
-        EnginioQmlClientPrivate *enginio = static_cast<EnginioQmlClientPrivate*>(_enginio);
-        QByteArray buffer = enginio->toJson(object);
-        return QJsonDocument::fromJson(buffer).object();
+        return EnginioQmlJsonConverter::toJsonObject(object);
     }
 
     EnginioQmlModelPrivate(EnginioBaseModel *pub)
@@ -156,32 +156,35 @@ public:
 
     virtual QJsonObject replyData(const EnginioReplyState *reply) const Q_DECL_OVERRIDE
     {
-        QJSValue data = static_cast<const EnginioQmlReply*>(reply)->data();
-        return convert(data);
+        // Use the JSON parsed by the reply itself instead of converting the
+        // JS object back, QML code may not even have looked at it.
+        return reply->data();
+    }
+
+    // Snapshot of _query, the JS object is converted only when the query is set
+    QJsonObject _queryJson;
+
+    void updateQueryJson()
+    {
+        _queryJson = convert(_query);
+        _preparedQuery = EnginioPreparedQuery();
+    }
+
+    void setQuery(const QJSValue &query)
+    {
+        _query = query;
+        updateQueryJson();
+        Base::setQuery(query);
     }
 
     virtual QJsonValue queryData(const QString &name) Q_DECL_OVERRIDE
     {
-        QJSValue value = _query.property(name);
-        if (value.isObject())
-            return convert(value);
-        if (value.isString())
-            return QJsonValue(value.toString());
-        if (value.isBool())
-            return QJsonValue(value.toBool());
-        if (value.isNumber())
-            return QJsonValue(value.toNumber());
-        if (value.isUndefined())
-            return QJsonValue(QJsonValue::Undefined);
-        if (value.isNull())
-            return QJsonValue(QJsonValue::Null);
-        Q_ASSERT(false);
-        return QJsonValue();
+        return _queryJson[name];
     }
 
     virtual QJsonObject queryAsJson() const Q_DECL_OVERRIDE
     {
-        return convert(_query);
+        return _queryJson;
     }
 };
 
@@ -277,8 +280,11 @@ QJSValue EnginioQmlModel::query()
 void EnginioQmlModel::setQuery(const QJSValue &query)
 {
     Q_D(EnginioQmlModel);
-    if (d->query().equals(query))
+    if (d->query().equals(query)) {
+        // The same object may have been modified in place before it was set again
+        d->updateQueryJson();
         return;
+    }
     return d->setQuery(query);
 }
 
@@ -116,12 +116,21 @@ public:
         emit q->finished(static_cast<EnginioQmlClientPrivate*>(_client)->jsengine()->newQObject(q));
     }
 
+    // The parsed value is kept alive by the QJSValue handle only, so it is
+    // collected together with the reply once QML drops the reply.
+    mutable QJSValue _value;
+
     QJSValue data() const
     {
-        if (_data.isEmpty() && _nreply->isFinished())
-            _data = _nreply->readAll();
+        if (_value.isUndefined() && _nreply->isFinished())
+            _value = static_cast<EnginioQmlClientPrivate*>(_client)->fromJson(pData());
+        return _value;
+    }
 
-        return static_cast<EnginioQmlClientPrivate*>(_client)->fromJson(_data);
+    void clearData() Q_DECL_OVERRIDE
+    {
+        EnginioReplyStatePrivate::clearData();
+        _value = QJSValue();
     }
 };
 
@@ -2,9 +2,12 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
 #     cmake \
+    backendconnection \
     enginioclient \
     notifications \
     identity \
+    mockbackend \
+    enginiomodelsync \
 
 qtHaveModule(gui) {
     SUBDIRS += files
@@ -0,0 +1,487 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qobject.h>
+#include <QtCore/qbytearray.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/private/enginiobackendconnection_p.h>
+#include <Enginio/private/enginioclient_p.h>
+#include <Enginio/private/enginionotificationhub_p.h>
+
+class tst_BackendConnection: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void handshakeResponse_data();
+    void handshakeResponse();
+    void handshakeResponseConnectionTokens_data();
+    void handshakeResponseConnectionTokens();
+    void handshakeResponsePerMessageDeflate_data();
+    void handshakeResponsePerMessageDeflate();
+    void handshakeResponseFuzz();
+    void notification_data();
+    void notification();
+    void notificationHubMergeFilters_data();
+    void notificationHubMergeFilters();
+    void notificationHubDispatch();
+    void notificationHubReconnected();
+};
+
+static const QByteArray ValidHandshake(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+        "\r\n");
+
+void tst_BackendConnection::handshakeResponse_data()
+{
+    QTest::addColumn<QByteArray>("response");
+    QTest::addColumn<bool>("isValid");
+    QTest::addColumn<int>("statusCode");
+    QTest::addColumn<QByteArray>("secWebSocketAccept");
+    QTest::addColumn<bool>("isUpgradeToWebSocket");
+
+    const QByteArray accept("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+
+    QTest::newRow("valid") << ValidHandshake << true << 101 << accept << true;
+    QTest::newRow("lower case names") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "upgrade: WebSocket\r\n"
+        "connection: upgrade\r\n"
+        "sec-websocket-accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+        "\r\n") << true << 101 << accept << true;
+    QTest::newRow("upper case names") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "UPGRADE: WEBSOCKET\r\n"
+        "CONNECTION: UPGRADE\r\n"
+        "SEC-WEBSOCKET-ACCEPT: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+        "\r\n") << true << 101 << accept << true;
+    QTest::newRow("LF only") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\n"
+        "Upgrade: websocket\n"
+        "Connection: Upgrade\n"
+        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\n"
+        "\n") << true << 101 << accept << true;
+    QTest::newRow("optional whitespace") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade:websocket \r\n"
+        "Connection:\t Upgrade\r\n"
+        "Sec-WebSocket-Accept:    s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\t\r\n"
+        "\r\n") << true << 101 << accept << true;
+    QTest::newRow("other headers") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Server: nginx\r\n"
+        "Upgrade: websocket\r\n"
+        "X-Upgrade: something else\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+        "Date: Mon, 19 Oct 2015 10:00:00 GMT\r\n"
+        "\r\n") << true << 101 << accept << true;
+    QTest::newRow("missing reason phrase") << QByteArray(
+        "HTTP/1.1 101\r\n"
+        "Upgrade: websocket\r\n"
+        "\r\n") << true << 101 << QByteArray() << true;
+    QTest::newRow("not switching protocols") << QByteArray(
+        "HTTP/1.1 403 Forbidden\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n") << true << 403 << QByteArray() << false;
+    QTest::newRow("http/1.0") << QByteArray(
+        "HTTP/1.0 400 Bad Request\r\n"
+        "\r\n") << true << 400 << QByteArray() << false;
+    QTest::newRow("wrong upgrade") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocketx\r\n"
+        "\r\n") << true << 101 << QByteArray() << false;
+
+    QTest::newRow("empty") << QByteArray() << false << 0 << QByteArray() << false;
+    QTest::newRow("http/2") << QByteArray("HTTP/2.0 101 Switching Protocols\r\n\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("short status code") << QByteArray("HTTP/1.1 10 Switching Protocols\r\n\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("long status code") << QByteArray("HTTP/1.1 1010 Switching Protocols\r\n\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("unterminated") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("missing colon") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade websocket\r\n"
+        "\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("whitespace before colon") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade : websocket\r\n"
+        "\r\n") << false << 0 << QByteArray() << false;
+    QTest::newRow("obsolete line folding") << QByteArray(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade:\r\n"
+        " websocket\r\n"
+        "\r\n") << false << 0 << QByteArray() << false;
+}
+
+void tst_BackendConnection::handshakeResponse()
+{
+    QFETCH(QByteArray, response);
+    QFETCH(bool, isValid);
+    QFETCH(int, statusCode);
+    QFETCH(QByteArray, secWebSocketAccept);
+    QFETCH(bool, isUpgradeToWebSocket);
+
+    EnginioHandshakeResponse parser;
+    QCOMPARE(parser.parse(response), isValid);
+    QCOMPARE(parser.statusCode, statusCode);
+    if (isValid) {
+        QCOMPARE(parser.secWebSocketAccept, secWebSocketAccept);
+        QCOMPARE(parser.isUpgradeToWebSocket(), isUpgradeToWebSocket);
+    }
+}
+
+void tst_BackendConnection::handshakeResponseConnectionTokens_data()
+{
+    QTest::addColumn<QByteArray>("connection");
+    QTest::addColumn<bool>("hasUpgradeToken");
+
+    QTest::newRow("upgrade") << QByteArray("Upgrade") << true;
+    QTest::newRow("lower case") << QByteArray("upgrade") << true;
+    QTest::newRow("list") << QByteArray("keep-alive, Upgrade") << true;
+    QTest::newRow("list without spaces") << QByteArray("Upgrade,keep-alive") << true;
+    QTest::newRow("empty elements") << QByteArray(" , ,upgrade ,") << true;
+    QTest::newRow("keep-alive") << QByteArray("keep-alive") << false;
+    QTest::newRow("prefix") << QByteArray("Upgraded") << false;
+    QTest::newRow("empty") << QByteArray() << false;
+}
+
+void tst_BackendConnection::handshakeResponseConnectionTokens()
+{
+    QFETCH(QByteArray, connection);
+    QFETCH(bool, hasUpgradeToken);
+
+    QByteArray response("HTTP/1.1 101 Switching Protocols\r\nConnection: ");
+    response.append(connection);
+    response.append("\r\n\r\n");
+
+    EnginioHandshakeResponse parser;
+    QVERIFY(parser.parse(response));
+    QCOMPARE(parser.hasConnectionUpgradeToken(), hasUpgradeToken);
+}
+
+Q_DECLARE_METATYPE(EnginioHandshakeResponse::ExtensionNegotiation)
+
+void tst_BackendConnection::handshakeResponsePerMessageDeflate_data()
+{
+    QTest::addColumn<QByteArray>("extensions");
+    QTest::addColumn<EnginioHandshakeResponse::ExtensionNegotiation>("negotiation");
+    QTest::addColumn<bool>("serverNoContextTakeover");
+
+    const EnginioHandshakeResponse::ExtensionNegotiation None = EnginioHandshakeResponse::NoExtensionNegotiated;
+    const EnginioHandshakeResponse::ExtensionNegotiation Deflate = EnginioHandshakeResponse::PerMessageDeflateNegotiated;
+    const EnginioHandshakeResponse::ExtensionNegotiation Invalid = EnginioHandshakeResponse::InvalidExtensionNegotiated;
+
+    QTest::newRow("none") << QByteArray() << None << false;
+    QTest::newRow("empty list") << QByteArray(" , ") << None << false;
+    QTest::newRow("permessage-deflate") << QByteArray("permessage-deflate") << Deflate << false;
+    QTest::newRow("upper case") << QByteArray("PerMessage-Deflate") << Deflate << false;
+    QTest::newRow("server_no_context_takeover") << QByteArray("permessage-deflate; server_no_context_takeover") << Deflate << true;
+    QTest::newRow("all parameters") << QByteArray("permessage-deflate;server_no_context_takeover ; client_no_context_takeover; server_max_window_bits=10") << Deflate << true;
+    QTest::newRow("quoted window bits") << QByteArray("permessage-deflate; server_max_window_bits=\"8\"") << Deflate << false;
+
+    QTest::newRow("unknown extension") << QByteArray("x-webkit-deflate-frame") << Invalid << false;
+    QTest::newRow("twice") << QByteArray("permessage-deflate, permessage-deflate") << Invalid << false;
+    QTest::newRow("unknown parameter") << QByteArray("permessage-deflate; foo") << Invalid << false;
+    QTest::newRow("repeated parameter") << QByteArray("permessage-deflate; server_no_context_takeover; server_no_context_takeover") << Invalid << false;
+    QTest::newRow("not offered client_max_window_bits") << QByteArray("permessage-deflate; client_max_window_bits=10") << Invalid << false;
+    QTest::newRow("window bits too small") << QByteArray("permessage-deflate; server_max_window_bits=7") << Invalid << false;
+    QTest::newRow("window bits too large") << QByteArray("permessage-deflate; server_max_window_bits=16") << Invalid << false;
+    QTest::newRow("window bits missing") << QByteArray("permessage-deflate; server_max_window_bits") << Invalid << false;
+    QTest::newRow("value for flag") << QByteArray("permessage-deflate; server_no_context_takeover=1") << Invalid << false;
+}
+
+void tst_BackendConnection::handshakeResponsePerMessageDeflate()
+{
+    QFETCH(QByteArray, extensions);
+    QFETCH(EnginioHandshakeResponse::ExtensionNegotiation, negotiation);
+    QFETCH(bool, serverNoContextTakeover);
+
+    QByteArray response(ValidHandshake);
+    response.chop(2);
+    if (!extensions.isEmpty()) {
+        response.append("Sec-WebSocket-Extensions: ");
+        response.append(extensions);
+        response.append("\r\n");
+    }
+    response.append("\r\n");
+
+    EnginioHandshakeResponse parser;
+    QVERIFY(parser.parse(response));
+    bool noContextTakeover = true;
+    QCOMPARE(parser.perMessageDeflate(&noContextTakeover), negotiation);
+    if (negotiation == EnginioHandshakeResponse::PerMessageDeflateNegotiated)
+        QCOMPARE(noContextTakeover, serverNoContextTakeover);
+}
+
+void tst_BackendConnection::handshakeResponseFuzz()
+{
+    // Mutate a valid response randomly, the parser has to stay within the
+    // buffer and report a sane state for every input.
+    static const char interestingBytes[] = { '\r', '\n', ':', ' ', '\t', ',', '0', '9', 'H', '\0', '\x7f', '\xff' };
+    qsrand(0xE6617);
+
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        // Make a detached copy so that reads past the end are visible to memory checkers.
+        QByteArray input(ValidHandshake.constData(), ValidHandshake.size());
+        const int mutations = 1 + qrand() % 8;
+        for (int m = 0; m < mutations && !input.isEmpty(); ++m) {
+            const int position = qrand() % input.size();
+            switch (qrand() % 5) {
+            case 0:
+                input[position] = interestingBytes[qrand() % sizeof(interestingBytes)];
+                break;
+            case 1:
+                input[position] = char(qrand());
+                break;
+            case 2:
+                input.truncate(position);
+                break;
+            case 3:
+                input.insert(position, interestingBytes[qrand() % sizeof(interestingBytes)]);
+                break;
+            case 4:
+                input.remove(position, 1 + qrand() % 4);
+                break;
+            }
+        }
+
+        EnginioHandshakeResponse parser;
+        if (parser.parse(input)) {
+            QVERIFY(parser.statusCode >= 0 && parser.statusCode <= 999);
+            const char *begin = input.constData();
+            const char *end = begin + input.size();
+            QVERIFY(parser.upgrade.isEmpty() || (parser.upgrade.constData() >= begin && parser.upgrade.constData() + parser.upgrade.size() <= end));
+            QVERIFY(parser.connection.isEmpty() || (parser.connection.constData() >= begin && parser.connection.constData() + parser.connection.size() <= end));
+            QVERIFY(parser.secWebSocketAccept.isEmpty() || (parser.secWebSocketAccept.constData() >= begin && parser.secWebSocketAccept.constData() + parser.secWebSocketAccept.size() <= end));
+            (void)parser.isUpgradeToWebSocket();
+            (void)parser.hasConnectionUpgradeToken();
+            bool serverNoContextTakeover;
+            (void)parser.perMessageDeflate(&serverNoContextTakeover);
+        } else {
+            QCOMPARE(parser.statusCode, 0);
+        }
+    }
+}
+
+static QJsonObject fromJson(const char *json)
+{
+    return QJsonDocument::fromJson(QByteArray(json)).object();
+}
+
+void tst_BackendConnection::notificationHubMergeFilters_data()
+{
+    QTest::addColumn<QJsonObject>("a");
+    QTest::addColumn<QJsonObject>("b");
+    QTest::addColumn<QJsonObject>("merged");
+
+    QTest::newRow("equal") << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}")
+                           << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}")
+                           << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}");
+    QTest::newRow("different objectType") << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}")
+                                          << fromJson("{\"data\":{\"objectType\":\"objects.lists\"}}")
+                                          << QJsonObject();
+    QTest::newRow("different event") << fromJson("{\"data\":{\"objectType\":\"objects.todos\"},\"event\":\"create\"}")
+                                     << fromJson("{\"data\":{\"objectType\":\"objects.todos\"},\"event\":\"delete\"}")
+                                     << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}");
+    QTest::newRow("missing event") << fromJson("{\"data\":{\"objectType\":\"objects.todos\"},\"event\":\"create\"}")
+                                   << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}")
+                                   << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}");
+    QTest::newRow("empty") << fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}")
+                           << QJsonObject()
+                           << QJsonObject();
+}
+
+void tst_BackendConnection::notificationHubMergeFilters()
+{
+    QFETCH(QJsonObject, a);
+    QFETCH(QJsonObject, b);
+    QFETCH(QJsonObject, merged);
+
+    QCOMPARE(EnginioNotificationHub::mergeFilters(a, b), merged);
+    QCOMPARE(EnginioNotificationHub::mergeFilters(b, a), merged);
+}
+
+struct RecordingSubscriber: public EnginioNotificationSubscriber
+{
+    QList<QJsonObject> received;
+    int reconnects;
+
+    RecordingSubscriber()
+        : reconnects()
+    {}
+
+    void receivedNotification(const EnginioNotification &notification) Q_DECL_OVERRIDE
+    {
+        received.append(notification.toJsonObject());
+    }
+
+    void reconnected() Q_DECL_OVERRIDE
+    {
+        ++reconnects;
+    }
+};
+
+void tst_BackendConnection::notification_data()
+{
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<int>("event");
+    QTest::addColumn<QString>("objectId");
+    QTest::addColumn<QString>("objectType");
+    QTest::addColumn<QString>("requestId");
+
+    QTest::newRow("update") << QByteArray("{\"event\":\"update\",\"data\":{\"id\":\"5406\",\"objectType\":\"objects.todos\",\"title\":\"Buy \\\"milk\\\"\"},\"origin\":{\"apiRequestId\":\"abc\"}}")
+                            << int(EnginioNotification::UpdateEvent) << QString::fromLatin1("5406") << QString::fromLatin1("objects.todos") << QString::fromLatin1("abc");
+    QTest::newRow("reordered with whitespace") << QByteArray(" { \"origin\" : { \"apiRequestId\" : \"abc\" } ,\n \"data\" : { \"objectType\" : \"objects.todos\" , \"id\" : \"5406\" } , \"event\" : \"delete\" } ")
+                            << int(EnginioNotification::DeleteEvent) << QString::fromLatin1("5406") << QString::fromLatin1("objects.todos") << QString::fromLatin1("abc");
+    QTest::newRow("nested values are skipped") << QByteArray("{\"event\":\"create\",\"data\":{\"list\":{\"id\":\"no\",\"x\":[\"}\",{\"objectType\":\"no\"}]},\"id\":\"yes\",\"n\":-1.5e3,\"b\":true,\"z\":null}}")
+                            << int(EnginioNotification::CreateEvent) << QString::fromLatin1("yes") << QString() << QString();
+    QTest::newRow("escaped value") << QByteArray("{\"event\":\"create\",\"data\":{\"id\":\"a\\u0062c\",\"objectType\":\"objects.\\u00e4\"}}")
+                            << int(EnginioNotification::CreateEvent) << QString::fromLatin1("abc") << QString(QStringLiteral("objects.\u00e4")) << QString();
+    QTest::newRow("escaped key") << QByteArray("{\"ev\\u0065nt\":\"update\",\"data\":{\"id\":\"1\"}}")
+                            << int(EnginioNotification::UpdateEvent) << QString::fromLatin1("1") << QString() << QString();
+    QTest::newRow("utf-8") << QByteArray("{\"event\":\"update\",\"data\":{\"id\":\"1\",\"objectType\":\"objects.\xc3\xa4\"}}")
+                            << int(EnginioNotification::UpdateEvent) << QString::fromLatin1("1") << QString(QStringLiteral("objects.\u00e4")) << QString();
+    QTest::newRow("unknown event") << QByteArray("{\"event\":\"rename\"}")
+                            << int(EnginioNotification::UnknownEvent) << QString() << QString() << QString();
+    QTest::newRow("not a string") << QByteArray("{\"event\":1,\"data\":{\"id\":2}}")
+                            << int(EnginioNotification::UnknownEvent) << QString() << QString() << QString();
+    QTest::newRow("truncated") << QByteArray("{\"event\":\"update\",\"data\":{\"id\":\"1\"")
+                            << int(EnginioNotification::UnknownEvent) << QString() << QString() << QString();
+    QTest::newRow("array") << QByteArray("[{\"event\":\"update\"}]")
+                            << int(EnginioNotification::UnknownEvent) << QString() << QString() << QString();
+    QTest::newRow("empty") << QByteArray()
+                            << int(EnginioNotification::UnknownEvent) << QString() << QString() << QString();
+}
+
+void tst_BackendConnection::notification()
+{
+    QFETCH(QByteArray, json);
+    QFETCH(int, event);
+    QFETCH(QString, objectId);
+    QFETCH(QString, objectType);
+    QFETCH(QString, requestId);
+
+    const EnginioNotification notification = EnginioNotification::fromJson(json);
+    QCOMPARE(int(notification.event()), event);
+    QCOMPARE(notification.objectId(), objectId);
+    QCOMPARE(notification.objectType(), objectType);
+    QCOMPARE(notification.requestId(), requestId);
+
+    // The scan has to agree with the JSON parser.
+    const QJsonObject message = QJsonDocument::fromJson(json).object();
+    QCOMPARE(notification.toJsonObject(), message);
+    QCOMPARE(notification.data(), message[QStringLiteral("data")].toObject());
+    if (message[QStringLiteral("event")].isString())
+        QCOMPARE(notification.eventName(), message[QStringLiteral("event")].toString());
+}
+
+static bool notify(EnginioNotificationHub *hub, const QJsonObject &message)
+{
+    const EnginioNotification notification = EnginioNotification::fromJson(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    return QMetaObject::invokeMethod(hub, "onNotificationReceived", Q_ARG(EnginioNotification, notification));
+}
+
+void tst_BackendConnection::notificationHubDispatch()
+{
+    // Without a backend id no connection is opened, the dispatching can be tested offline.
+    EnginioClient client;
+    EnginioNotificationHub hub(EnginioClientConnectionPrivate::get(&client));
+
+    RecordingSubscriber todos, todosCreate, lists, everything;
+    hub.subscribe(&todos, fromJson("{\"data\":{\"objectType\":\"objects.todos\"}}"));
+    hub.subscribe(&todosCreate, fromJson("{\"data\":{\"objectType\":\"objects.todos\"},\"event\":\"create\"}"));
+    hub.subscribe(&lists, fromJson("{\"data\":{\"objectType\":\"objects.lists\"}}"));
+    hub.subscribe(&everything, QJsonObject());
+    QCOMPARE(hub.subscriberCount(), 4);
+
+    const QJsonObject createTodo = fromJson("{\"event\":\"create\",\"data\":{\"id\":\"1\",\"objectType\":\"objects.todos\"}}");
+    const QJsonObject updateTodo = fromJson("{\"event\":\"update\",\"data\":{\"id\":\"1\",\"objectType\":\"objects.todos\"}}");
+    const QJsonObject deleteList = fromJson("{\"event\":\"delete\",\"data\":{\"id\":\"2\",\"objectType\":\"objects.lists\"}}");
+    QVERIFY(notify(&hub, createTodo));
+    QVERIFY(notify(&hub, updateTodo));
+    QVERIFY(notify(&hub, deleteList));
+
+    QCOMPARE(todos.received, QList<QJsonObject>() << createTodo << updateTodo);
+    QCOMPARE(todosCreate.received, QList<QJsonObject>() << createTodo);
+    QCOMPARE(lists.received, QList<QJsonObject>() << deleteList);
+    QCOMPARE(everything.received.count(), 3);
+
+    // Changing the filter moves the subscriber to another bucket.
+    hub.subscribe(&todosCreate, fromJson("{\"data\":{\"objectType\":\"objects.lists\"}}"));
+    hub.unsubscribe(&everything);
+    QCOMPARE(hub.subscriberCount(), 3);
+    QVERIFY(notify(&hub, createTodo));
+    QVERIFY(notify(&hub, deleteList));
+    QCOMPARE(todos.received.count(), 3);
+    QCOMPARE(todosCreate.received, QList<QJsonObject>() << createTodo << deleteList);
+    QCOMPARE(lists.received.count(), 2);
+    QCOMPARE(everything.received.count(), 3);
+
+    hub.unsubscribe(&todos);
+    hub.unsubscribe(&todosCreate);
+    hub.unsubscribe(&lists);
+    QCOMPARE(hub.subscriberCount(), 0);
+    QVERIFY(!hub.connection());
+}
+
+void tst_BackendConnection::notificationHubReconnected()
+{
+    EnginioClient client;
+    EnginioNotificationHub hub(EnginioClientConnectionPrivate::get(&client));
+
+    RecordingSubscriber first, second, third;
+    hub.subscribe(&first, QJsonObject());
+    QVERIFY(QMetaObject::invokeMethod(&hub, "onStateChanged", Q_ARG(EnginioBackendConnection::ConnectionState, EnginioBackendConnection::ConnectedState)));
+    // The first connection does not miss anything.
+    QCOMPARE(first.reconnects, 0);
+
+    hub.subscribe(&second, QJsonObject());
+    QVERIFY(QMetaObject::invokeMethod(&hub, "onStateChanged", Q_ARG(EnginioBackendConnection::ConnectionState, EnginioBackendConnection::DisconnectedState)));
+    hub.subscribe(&third, QJsonObject());
+    QVERIFY(QMetaObject::invokeMethod(&hub, "onStateChanged", Q_ARG(EnginioBackendConnection::ConnectionState, EnginioBackendConnection::ConnectedState)));
+
+    // Only subscribers served by the lost connection have to recover.
+    QCOMPARE(first.reconnects, 1);
+    QCOMPARE(second.reconnects, 1);
+    QCOMPARE(third.reconnects, 0);
+}
+
+QTEST_MAIN(tst_BackendConnection)
+#include "tst_backendconnection.moc"
@@ -0,0 +1,1141 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "mockbackend.h"
+
+#include <QtCore/qcoreevent.h>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qregularexpression.h>
+#include <QtCore/qurlquery.h>
+#include <QtCore/qvector.h>
+#include <QtNetwork/qhostaddress.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <algorithm>
+
+namespace EnginioTests {
+
+namespace {
+
+const int ShapingInterval = 1; // ms
+
+const QString Id = QStringLiteral("id");
+const QString ObjectType = QStringLiteral("objectType");
+const QString CreatedAt = QStringLiteral("createdAt");
+const QString UpdatedAt = QStringLiteral("updatedAt");
+const QString Results = QStringLiteral("results");
+const QString Files = QStringLiteral("files");
+const QString Users = QStringLiteral("users");
+const QString Usergroups = QStringLiteral("usergroups");
+
+QJsonObject errorObject(const QString &message, const QString &reason)
+{
+    QJsonObject error;
+    error[QStringLiteral("message")] = message;
+    error[QStringLiteral("reason")] = reason;
+    QJsonObject result;
+    result[QStringLiteral("errors")] = QJsonArray() << error;
+    return result;
+}
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 101: return QByteArrayLiteral("Switching Protocols");
+    case 200: return QByteArrayLiteral("OK");
+    case 201: return QByteArrayLiteral("Created");
+    case 400: return QByteArrayLiteral("Bad Request");
+    case 401: return QByteArrayLiteral("Unauthorized");
+    case 404: return QByteArrayLiteral("Not Found");
+    case 405: return QByteArrayLiteral("Method Not Allowed");
+    default: return QByteArrayLiteral("Unknown");
+    }
+}
+
+QByteArray webSocketFrame(int opcode, const QByteArray &payload)
+{
+    QByteArray frame;
+    frame.reserve(payload.size() + 10);
+    frame.append(char(0x80 | opcode));
+    if (payload.size() < 126) {
+        frame.append(char(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.append(char(126));
+        frame.append(char(payload.size() >> 8));
+        frame.append(char(payload.size() & 0xFF));
+    } else {
+        frame.append(char(127));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame.append(char((quint64(payload.size()) >> shift) & 0xFF));
+    }
+    frame.append(payload);
+    return frame;
+}
+
+QJsonObject parseObject(const QByteArray &json, bool *ok)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+    *ok = error.error == QJsonParseError::NoError && document.isObject();
+    return document.object();
+}
+
+// Properties may be addressed with a dotted path, e.g. "creator.id"
+QJsonValue propertyValue(const QJsonObject &object, const QString &path)
+{
+    if (!path.contains(QLatin1Char('.')))
+        return object.value(path);
+    QJsonValue value = object;
+    foreach (const QString &key, path.split(QLatin1Char('.')))
+        value = value.toObject().value(key);
+    return value;
+}
+
+// {"$type": "time", "$value": ...} literals compare by their value
+QJsonValue operand(const QJsonValue &value)
+{
+    const QJsonObject object = value.toObject();
+    if (object.contains(QStringLiteral("$type")))
+        return object.value(QStringLiteral("$value"));
+    return value;
+}
+
+bool isOperatorObject(const QJsonValue &value)
+{
+    const QJsonObject object = value.toObject();
+    return !object.isEmpty()
+            && object.constBegin().key().startsWith(QLatin1Char('$'))
+            && !object.contains(QStringLiteral("$type"));
+}
+
+int compare(const QJsonValue &a, const QJsonValue &b, bool *comparable)
+{
+    *comparable = true;
+    if (a.isDouble() && b.isDouble())
+        return a.toDouble() < b.toDouble() ? -1 : (a.toDouble() > b.toDouble() ? 1 : 0);
+    if (a.isString() && b.isString())
+        return a.toString().compare(b.toString());
+    if (a.isBool() && b.isBool())
+        return int(a.toBool()) - int(b.toBool());
+    *comparable = false;
+    return 0;
+}
+
+bool matches(const QJsonObject &object, const QJsonObject &filter);
+
+// Like MongoDB, null stands for a missing property too and a value is
+// found in an array property containing it.
+bool equalsValue(const QJsonValue &value, const QJsonValue &other)
+{
+    if (value.isUndefined())
+        return other.isNull();
+    if (value.isArray() && !other.isArray())
+        return value.toArray().contains(other);
+    return value == other;
+}
+
+bool inValues(const QJsonValue &value, const QJsonArray &values)
+{
+    foreach (const QJsonValue &other, values) {
+        if (equalsValue(value, operand(other)))
+            return true;
+    }
+    return false;
+}
+
+// Range and pattern operators are applied to every element of an array
+bool matchesScalarOperator(const QString &op, const QJsonValue &value, const QJsonValue &other, const QJsonObject &operators)
+{
+    if (value.isArray()) {
+        foreach (const QJsonValue &element, value.toArray()) {
+            if (matchesScalarOperator(op, element, other, operators))
+                return true;
+        }
+        return false;
+    }
+
+    if (op == QStringLiteral("$regex")) {
+        const QString options = operators.value(QStringLiteral("$options")).toString();
+        const QRegularExpression regex(other.toString(), options.contains(QLatin1Char('i')) ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption);
+        return value.isString() && regex.match(value.toString()).hasMatch();
+    }
+
+    bool comparable;
+    const int result = compare(value, other, &comparable);
+    if (!comparable)
+        return false;
+    if (op == QStringLiteral("$gt"))
+        return result > 0;
+    if (op == QStringLiteral("$gte"))
+        return result >= 0;
+    if (op == QStringLiteral("$lt"))
+        return result < 0;
+    return result <= 0;
+}
+
+bool matchesOperators(const QJsonValue &value, const QJsonObject &operators)
+{
+    for (QJsonObject::const_iterator it = operators.constBegin(); it != operators.constEnd(); ++it) {
+        const QString op = it.key();
+        const QJsonValue other = operand(it.value());
+        if (op == QStringLiteral("$eq")) {
+            if (!equalsValue(value, other))
+                return false;
+        } else if (op == QStringLiteral("$ne")) {
+            if (equalsValue(value, other))
+                return false;
+        } else if (op == QStringLiteral("$in") || op == QStringLiteral("$nin")) {
+            if (inValues(value, it.value().toArray()) != (op == QStringLiteral("$in")))
+                return false;
+        } else if (op == QStringLiteral("$exists")) {
+            if (value.isUndefined() == other.toBool())
+                return false;
+        } else if (op == QStringLiteral("$options")) {
+            continue;
+        } else if (!matchesScalarOperator(op, value, other, operators)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool matches(const QJsonObject &object, const QJsonObject &filter)
+{
+    for (QJsonObject::const_iterator it = filter.constBegin(); it != filter.constEnd(); ++it) {
+        if (it.key() == QStringLiteral("$and")) {
+            foreach (const QJsonValue &condition, it.value().toArray()) {
+                if (!matches(object, condition.toObject()))
+                    return false;
+            }
+        } else if (it.key() == QStringLiteral("$or")) {
+            bool any = false;
+            foreach (const QJsonValue &condition, it.value().toArray())
+                any = any || matches(object, condition.toObject());
+            if (!any)
+                return false;
+        } else {
+            const QJsonValue value = propertyValue(object, it.key());
+            if (isOperatorObject(it.value())) {
+                if (!matchesOperators(value, it.value().toObject()))
+                    return false;
+            } else if (!equalsValue(value, operand(it.value()))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// A notification is delivered if every property of the filter is present in it
+bool containsFilter(const QJsonObject &message, const QJsonObject &filter)
+{
+    for (QJsonObject::const_iterator it = filter.constBegin(); it != filter.constEnd(); ++it) {
+        const QJsonValue value = message.value(it.key());
+        if (it.value().isObject()) {
+            if (!value.isObject() || !containsFilter(value.toObject(), it.value().toObject()))
+                return false;
+        } else if (value != it.value()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct SortKeyLess
+{
+    QString sortBy;
+    bool descending;
+
+    bool operator()(const QJsonObject &a, const QJsonObject &b) const
+    {
+        bool comparable;
+        const QJsonValue left = propertyValue(a, sortBy);
+        const QJsonValue right = propertyValue(b, sortBy);
+        const int result = compare(left, right, &comparable);
+        if (!comparable)
+            return !left.isUndefined() && right.isUndefined(); // missing values last
+        return descending ? result > 0 : result < 0;
+    }
+};
+
+struct MultipartPart
+{
+    QByteArray name;
+    QByteArray contentType;
+    QByteArray body;
+};
+
+QList<MultipartPart> parseMultipart(const QByteArray &contentType, const QByteArray &body)
+{
+    QList<MultipartPart> parts;
+    int boundaryIndex = contentType.indexOf("boundary=");
+    if (boundaryIndex == -1)
+        return parts;
+    QByteArray boundary = contentType.mid(boundaryIndex + 9).trimmed();
+    if (boundary.startsWith('"'))
+        boundary = boundary.mid(1, boundary.indexOf('"', 1) - 1);
+    const QByteArray delimiter = "--" + boundary;
+
+    int position = body.indexOf(delimiter);
+    while (position != -1) {
+        position += delimiter.size();
+        if (body.mid(position, 2) == "--")
+            break;
+        const int next = body.indexOf(delimiter, position);
+        if (next == -1)
+            break;
+        QByteArray part = body.mid(position, next - position);
+        if (part.startsWith("\r\n"))
+            part.remove(0, 2);
+        if (part.endsWith("\r\n"))
+            part.chop(2);
+        const int headerEnd = part.indexOf("\r\n\r\n");
+        if (headerEnd != -1) {
+            MultipartPart result;
+            foreach (const QByteArray &line, part.left(headerEnd).split('\n')) {
+                const QByteArray lower = line.trimmed().toLower();
+                if (lower.startsWith("content-disposition:")) {
+                    const int nameIndex = lower.indexOf("name=\"");
+                    if (nameIndex != -1)
+                        result.name = lower.mid(nameIndex + 6, lower.indexOf('"', nameIndex + 6) - nameIndex - 6);
+                } else if (lower.startsWith("content-type:")) {
+                    result.contentType = line.mid(line.indexOf(':') + 1).trimmed();
+                }
+            }
+            result.body = part.mid(headerEnd + 4);
+            parts.append(result);
+        }
+        position = next;
+    }
+    return parts;
+}
+
+} // namespace
+
+MockBackend::Response::Response(int status, const QJsonObject &object)
+    : status(status)
+    , contentType(QByteArrayLiteral("application/json"))
+    , body(QJsonDocument(object).toJson(QJsonDocument::Compact))
+{}
+
+MockBackend::Response::Response(int status, const QByteArray &contentType, const QByteArray &body)
+    : status(status)
+    , contentType(contentType)
+    , body(body)
+{}
+
+MockBackend::MockBackend(QObject *parent)
+    : QTcpServer(parent)
+    , _lastTimestamp(0)
+    , _lastId(0)
+    , _latency(0)
+    , _bandwidth(0)
+    , _handshakeLatency(0)
+    , _requestCount(0)
+{
+    _clock.start();
+    connect(this, &QTcpServer::newConnection, this, &MockBackend::onNewConnection);
+}
+
+MockBackend::~MockBackend()
+{
+    qDeleteAll(_connections);
+}
+
+bool MockBackend::start()
+{
+    return listen(QHostAddress::LocalHost);
+}
+
+QUrl MockBackend::serviceUrl() const
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("http"));
+    url.setHost(serverAddress().toString());
+    url.setPort(serverPort());
+    return url;
+}
+
+QByteArray MockBackend::backendId()
+{
+    return QByteArrayLiteral("5376f0f5e5bde5398a000001");
+}
+
+/*
+    Delays every response and notification by \a msecs, measured from the
+    moment the request was received.
+*/
+void MockBackend::setLatency(int msecs)
+{
+    _latency = qMax(0, msecs);
+}
+
+/*
+    Limits the data sent on each connection to \a bytesPerSecond,
+    0 means unlimited.
+*/
+void MockBackend::setBandwidth(int bytesPerSecond)
+{
+    _bandwidth = qMax(0, bytesPerSecond);
+}
+
+/*
+    Holds back everything sent on a connection until \a msecs after it was
+    accepted, the cost of the handshakes of a new connection. A client that
+    opened its connections early does not pay it on its first request.
+*/
+void MockBackend::setHandshakeLatency(int msecs)
+{
+    _handshakeLatency = qMax(0, msecs);
+}
+
+int MockBackend::webSocketCount() const
+{
+    int count = 0;
+    foreach (const Connection *connection, _connections)
+        count += connection->isWebSocket;
+    return count;
+}
+
+QJsonObject MockBackend::insertObject(const QString &objectType, const QJsonObject &object)
+{
+    return create(objectType, object, QByteArray());
+}
+
+QJsonArray MockBackend::objects(const QString &objectType) const
+{
+    QJsonArray result;
+    const Collection collection = _collections.value(objectType);
+    foreach (const QString &id, collection.ids)
+        result.append(collection.objects.value(id));
+    return result;
+}
+
+void MockBackend::insertUser(const QString &username, const QString &password)
+{
+    QJsonObject user;
+    user[QStringLiteral("username")] = username;
+    create(Users, user, QByteArray());
+    _passwords.insert(username, password);
+}
+
+void MockBackend::clear()
+{
+    _collections.clear();
+    _access.clear();
+    _members.clear();
+    _fileData.clear();
+    _fileTargets.clear();
+    _passwords.clear();
+}
+
+void MockBackend::onNewConnection()
+{
+    while (QTcpSocket *socket = nextPendingConnection()) {
+        Connection *connection = new Connection;
+        connection->socket = socket;
+        connection->isWebSocket = false;
+        connection->lastFlush = 0;
+        connection->credit = 0;
+        connection->acceptedAt = _clock.elapsed();
+        _connections.insert(socket, connection);
+        connect(socket, &QTcpSocket::readyRead, this, &MockBackend::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &MockBackend::onDisconnected);
+    }
+}
+
+void MockBackend::onDisconnected()
+{
+    QTcpSocket *socket = static_cast<QTcpSocket*>(sender());
+    delete _connections.take(socket);
+    socket->deleteLater();
+}
+
+void MockBackend::onReadyRead()
+{
+    Connection *connection = _connections.value(static_cast<QTcpSocket*>(sender()));
+    if (!connection)
+        return;
+    connection->input.append(connection->socket->readAll());
+    if (connection->isWebSocket)
+        processWebSocket(connection);
+    else
+        while (processHttp(connection)) {}
+}
+
+bool MockBackend::processHttp(Connection *connection)
+{
+    QByteArray &input = connection->input;
+    const int headerEnd = input.indexOf("\r\n\r\n");
+    if (headerEnd == -1)
+        return false;
+
+    Request request;
+    const QList<QByteArray> lines = input.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.count() != 3) {
+        connection->socket->disconnectFromHost();
+        return false;
+    }
+    for (int i = 1; i < lines.count(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon > 0)
+            request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+    }
+
+    const int contentLength = request.headers.value("content-length").toInt();
+    if (input.size() < headerEnd + 4 + contentLength)
+        return false; // wait for the rest of the body
+
+    request.method = requestLine[0];
+    const QByteArray target = requestLine[1];
+    const int queryIndex = target.indexOf('?');
+    request.path = QUrl::fromPercentEncoding(target.left(queryIndex));
+    if (queryIndex != -1)
+        request.query = QString::fromLatin1(target.mid(queryIndex + 1));
+    request.body = input.mid(headerEnd + 4, contentLength);
+    input.remove(0, headerEnd + 4 + contentLength);
+
+    ++_requestCount;
+    if (request.headers.value("upgrade").toLower() == "websocket") {
+        acceptWebSocket(connection, request);
+        return false;
+    }
+
+    QElapsedTimer handling;
+    handling.start();
+    const Response response = handle(request);
+    const QByteArray serverTiming = "app;dur=" + QByteArray::number(handling.nsecsElapsed() / 1000000.0, 'f', 3) + ";desc=\"mock backend\"";
+    QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n"
+            "Content-Type: " + response.contentType + "\r\n"
+            "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+            "Server-Timing: " + serverTiming + "\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n";
+    data.append(response.body);
+    send(connection, data);
+    emit requestFinished(request.method, request.path, response.status);
+    return true;
+}
+
+void MockBackend::acceptWebSocket(Connection *connection, const Request &request)
+{
+    if (request.path != QStringLiteral("/v1/stream")) {
+        connection->socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        connection->socket->disconnectFromHost();
+        return;
+    }
+
+    const QByteArray key = request.headers.value("sec-websocket-key");
+    const QByteArray accept = QCryptographicHash::hash(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", QCryptographicHash::Sha1).toBase64();
+    const QUrlQuery query(request.query);
+    bool ok;
+    connection->filter = parseObject(query.queryItemValue(QStringLiteral("filter"), QUrl::FullyDecoded).toUtf8(), &ok);
+    connection->isWebSocket = true;
+
+    // permessage-deflate is not offered, the client has to cope without it
+    send(connection, "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + accept + "\r\n"
+                     "\r\n");
+    emit requestFinished(request.method, request.path, 101);
+
+    if (!connection->input.isEmpty())
+        processWebSocket(connection);
+}
+
+void MockBackend::processWebSocket(Connection *connection)
+{
+    QByteArray &input = connection->input;
+    forever {
+        if (input.size() < 2)
+            return;
+        const uchar *data = reinterpret_cast<const uchar *>(input.constData());
+        const int opcode = data[0] & 0x0F;
+        const bool masked = data[1] & 0x80;
+        quint64 length = data[1] & 0x7F;
+        int headerSize = 2;
+        if (length == 126) {
+            headerSize = 4;
+            if (input.size() < headerSize)
+                return;
+            length = (quint64(data[2]) << 8) | data[3];
+        } else if (length == 127) {
+            headerSize = 10;
+            if (input.size() < headerSize)
+                return;
+            length = 0;
+            for (int i = 2; i < 10; ++i)
+                length = (length << 8) | data[i];
+        }
+        const int maskOffset = headerSize;
+        if (masked)
+            headerSize += 4;
+        if (quint64(input.size()) < headerSize + length)
+            return;
+
+        QByteArray payload = input.mid(headerSize, int(length));
+        if (masked) {
+            for (int i = 0; i < payload.size(); ++i)
+                payload[i] = payload[i] ^ data[maskOffset + (i % 4)];
+        }
+        input.remove(0, headerSize + int(length));
+
+        switch (opcode) {
+        case 0x8: // close
+            send(connection, webSocketFrame(0x8, payload.left(2)));
+            connection->socket->disconnectFromHost();
+            return;
+        case 0x9: // ping
+            send(connection, webSocketFrame(0xA, payload));
+            break;
+        default: // the client has nothing to tell
+            break;
+        }
+    }
+}
+
+MockBackend::Response MockBackend::handle(const Request &request)
+{
+    if (!request.path.startsWith(QStringLiteral("/v1/")))
+        return Response(404, errorObject(QStringLiteral("Unknown path"), QStringLiteral("NotFound")));
+
+    const QStringList segments = request.path.mid(4).split(QLatin1Char('/'), QString::SkipEmptyParts);
+    if (segments.isEmpty())
+        return Response(404, errorObject(QStringLiteral("Unknown path"), QStringLiteral("NotFound")));
+
+    const QString root = segments.first();
+    if (root == QStringLiteral("objects") && segments.count() >= 2) {
+        const QString objectType = QStringLiteral("objects.") + segments[1];
+        if (segments.count() == 4 && segments[3] == QStringLiteral("access"))
+            return handleAccess(request, objectType, segments[2]);
+        if (segments.count() <= 3)
+            return handleCollection(request, objectType, segments.value(2));
+    } else if (root == Users && segments.count() <= 2) {
+        return handleCollection(request, Users, segments.value(1));
+    } else if (root == Usergroups) {
+        if (segments.count() == 3 && segments[2] == QStringLiteral("members"))
+            return handleMembers(request, segments[1]);
+        if (segments.count() <= 2)
+            return handleCollection(request, Usergroups, segments.value(1));
+    } else if (root == Files) {
+        return handleFiles(request, segments);
+    } else if (root == QStringLiteral("search") && segments.count() == 1) {
+        return handleSearch(request);
+    } else if (request.path == QStringLiteral("/v1/auth/oauth2/token")) {
+        return handleToken(request);
+    } else if (root == QStringLiteral("stream_url")) {
+        QUrl url = serviceUrl();
+        url.setScheme(QStringLiteral("ws"));
+        url.setPath(QStringLiteral("/v1/stream"));
+        url.setQuery(request.query);
+        QJsonObject result;
+        result[QStringLiteral("expiringUrl")] = url.toString(QUrl::FullyEncoded);
+        return Response(200, result);
+    }
+    return Response(404, errorObject(QStringLiteral("Unknown path"), QStringLiteral("NotFound")));
+}
+
+MockBackend::Response MockBackend::handleCollection(const Request &request, const QString &objectType, const QString &id)
+{
+    const QByteArray requestId = request.headers.value("x-request-id");
+    bool ok = true;
+    const QJsonObject body = request.body.isEmpty() ? QJsonObject() : parseObject(request.body, &ok);
+    if (!ok)
+        return Response(400, errorObject(QStringLiteral("Invalid JSON"), QStringLiteral("BadRequest")));
+
+    if (id.isEmpty()) {
+        if (request.method == "GET")
+            return handleQuery(objectType, QUrlQuery(request.query));
+        if (request.method == "POST") {
+            if (objectType == Users && body.contains(QStringLiteral("password")))
+                _passwords.insert(body.value(QStringLiteral("username")).toString(), body.value(QStringLiteral("password")).toString());
+            return Response(201, create(objectType, body, requestId));
+        }
+        return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+    }
+
+    Collection &collection = _collections[objectType];
+    if (!collection.objects.contains(id))
+        return Response(404, errorObject(QStringLiteral("Object not found"), QStringLiteral("NotFound")));
+
+    if (request.method == "GET")
+        return Response(200, collection.objects.value(id));
+    if (request.method == "PUT")
+        return Response(200, update(objectType, id, body, requestId));
+    if (request.method == "DELETE") {
+        const QJsonObject object = collection.objects.take(id);
+        collection.ids.removeOne(id);
+        _access.remove(objectType + QLatin1Char('/') + id);
+        QJsonObject removed;
+        removed[Id] = id;
+        removed[ObjectType] = objectType;
+        notify(QStringLiteral("delete"), removed, requestId);
+        return Response(200, object);
+    }
+    return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+}
+
+MockBackend::Response MockBackend::handleQuery(const QString &objectType, const QUrlQuery &query)
+{
+    bool ok = true;
+    const QString filterJson = query.queryItemValue(QStringLiteral("q"), QUrl::FullyDecoded);
+    const QJsonObject filter = filterJson.isEmpty() ? QJsonObject() : parseObject(filterJson.toUtf8(), &ok);
+    if (!ok)
+        return Response(400, errorObject(QStringLiteral("Invalid query"), QStringLiteral("BadRequest")));
+
+    const Collection collection = _collections.value(objectType);
+    QVector<QJsonObject> found;
+    found.reserve(collection.ids.count());
+    foreach (const QString &id, collection.ids) {
+        const QJsonObject object = collection.objects.value(id);
+        if (matches(object, filter))
+            found.append(object);
+    }
+
+    const QJsonArray sort = QJsonDocument::fromJson(query.queryItemValue(QStringLiteral("sort"), QUrl::FullyDecoded).toUtf8()).array();
+    for (int i = sort.count() - 1; i >= 0; --i) {
+        const QJsonObject sortKey = sort[i].toObject();
+        SortKeyLess less = { sortKey.value(QStringLiteral("sortBy")).toString(),
+                             sortKey.value(QStringLiteral("direction")).toString() == QStringLiteral("desc") };
+        std::stable_sort(found.begin(), found.end(), less);
+    }
+
+    const QJsonObject include = QJsonDocument::fromJson(query.queryItemValue(QStringLiteral("include"), QUrl::FullyDecoded).toUtf8()).object();
+    const int offset = qMax(0, query.queryItemValue(QStringLiteral("offset")).toInt());
+    int limit = query.queryItemValue(QStringLiteral("limit")).toInt();
+    if (limit <= 0)
+        limit = 100;
+
+    QJsonArray results;
+    for (int i = offset; i < found.count() && i < offset + limit; ++i)
+        results.append(include.isEmpty() ? found[i] : includeReferences(found[i], include));
+
+    QJsonObject result;
+    result[Results] = results;
+    if (query.hasQueryItem(QStringLiteral("count")))
+        result[QStringLiteral("count")] = found.count();
+    return Response(200, result);
+}
+
+MockBackend::Response MockBackend::handleAccess(const Request &request, const QString &objectType, const QString &id)
+{
+    if (!_collections.value(objectType).objects.contains(id))
+        return Response(404, errorObject(QStringLiteral("Object not found"), QStringLiteral("NotFound")));
+
+    const QString key = objectType + QLatin1Char('/') + id;
+    QJsonObject access = _access.value(key);
+    bool ok = true;
+    const QJsonObject body = request.body.isEmpty() ? QJsonObject() : parseObject(request.body, &ok);
+    if (!ok)
+        return Response(400, errorObject(QStringLiteral("Invalid JSON"), QStringLiteral("BadRequest")));
+
+    if (request.method == "PUT") {
+        access = body;
+    } else if (request.method == "POST" || request.method == "DELETE") {
+        for (QJsonObject::const_iterator it = body.constBegin(); it != body.constEnd(); ++it) {
+            QJsonArray entries = access.value(it.key()).toArray();
+            foreach (const QJsonValue &entry, it.value().toArray()) {
+                for (int i = entries.count() - 1; i >= 0; --i) {
+                    if (entries[i] == entry)
+                        entries.removeAt(i);
+                }
+                if (request.method == "POST")
+                    entries.append(entry);
+            }
+            access[it.key()] = entries;
+        }
+    } else if (request.method != "GET") {
+        return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+    }
+    _access.insert(key, access);
+    return Response(200, access);
+}
+
+MockBackend::Response MockBackend::handleMembers(const Request &request, const QString &groupId)
+{
+    if (!_collections.value(Usergroups).objects.contains(groupId))
+        return Response(404, errorObject(QStringLiteral("Usergroup not found"), QStringLiteral("NotFound")));
+
+    QJsonArray &members = _members[groupId];
+    if (request.method == "GET") {
+        const QUrlQuery query(request.query);
+        const int offset = qMax(0, query.queryItemValue(QStringLiteral("offset")).toInt());
+        int limit = query.queryItemValue(QStringLiteral("limit")).toInt();
+        if (limit <= 0)
+            limit = 100;
+        QJsonArray results;
+        for (int i = offset; i < members.count() && i < offset + limit; ++i)
+            results.append(members[i]);
+        QJsonObject result;
+        result[Results] = results;
+        if (query.hasQueryItem(QStringLiteral("count")))
+            result[QStringLiteral("count")] = members.count();
+        return Response(200, result);
+    }
+
+    bool ok = true;
+    const QJsonObject member = parseObject(request.body, &ok);
+    if (!ok || member.value(Id).toString().isEmpty())
+        return Response(400, errorObject(QStringLiteral("Member id is missing"), QStringLiteral("BadRequest")));
+
+    for (int i = members.count() - 1; i >= 0; --i) {
+        if (members[i].toObject().value(Id) == member.value(Id))
+            members.removeAt(i);
+    }
+    if (request.method == "POST")
+        members.append(member);
+    else if (request.method != "DELETE")
+        return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+    return Response(200, member);
+}
+
+MockBackend::Response MockBackend::handleFiles(const Request &request, const QStringList &segments)
+{
+    const QByteArray requestId = request.headers.value("x-request-id");
+
+    if (segments.count() == 1 && request.method == "POST") {
+        const QByteArray contentType = request.headers.value("content-type");
+        QJsonObject upload;
+        QByteArray data;
+        QByteArray mimeType = QByteArrayLiteral("application/octet-stream");
+        bool complete = false;
+        bool ok = true;
+        if (contentType.startsWith("multipart/")) {
+            foreach (const MultipartPart &part, parseMultipart(contentType, request.body)) {
+                if (part.name == "object") {
+                    upload = parseObject(part.body, &ok);
+                } else if (part.name == "file") {
+                    data = part.body;
+                    if (!part.contentType.isEmpty())
+                        mimeType = part.contentType;
+                    complete = true;
+                }
+            }
+        } else {
+            upload = parseObject(request.body, &ok);
+        }
+        if (!ok)
+            return Response(400, errorObject(QStringLiteral("Invalid JSON"), QStringLiteral("BadRequest")));
+
+        QJsonObject file = upload.value(QStringLiteral("file")).toObject();
+        file[QStringLiteral("status")] = complete ? QStringLiteral("complete") : QStringLiteral("empty");
+        file[QStringLiteral("fileSize")] = data.size();
+        file[QStringLiteral("contentType")] = QString::fromLatin1(mimeType);
+        file = create(Files, file, QByteArray());
+        _fileData.insert(file.value(Id).toString(), data);
+        const QJsonObject target = upload.value(QStringLiteral("targetFileProperty")).toObject();
+        if (!target.isEmpty()) {
+            _fileTargets.insert(file.value(Id).toString(), target);
+            if (complete)
+                attachFile(file, target, requestId);
+        }
+        return Response(201, file);
+    }
+
+    if (segments.count() < 2)
+        return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+
+    const QString id = segments[1];
+    const QString subresource = segments.value(2);
+    Collection &collection = _collections[Files];
+    if (!collection.objects.contains(id))
+        return Response(404, errorObject(QStringLiteral("File not found"), QStringLiteral("NotFound")));
+    QJsonObject file = collection.objects.value(id);
+
+    if (subresource.isEmpty() && request.method == "GET")
+        return Response(200, file);
+    if (subresource == QStringLiteral("download_url") && request.method == "GET") {
+        QUrl url = serviceUrl();
+        url.setPath(QStringLiteral("/v1/files/") + id + QStringLiteral("/data"));
+        QJsonObject result;
+        result[QStringLiteral("expiringUrl")] = url.toString(QUrl::FullyEncoded);
+        result[QStringLiteral("expiresAt")] = QDateTime::currentDateTimeUtc().addSecs(3600).toString(Qt::ISODate);
+        return Response(200, result);
+    }
+    if (subresource == QStringLiteral("data") && request.method == "GET")
+        return Response(200, file.value(QStringLiteral("contentType")).toString().toLatin1(), _fileData.value(id));
+    if (subresource == QStringLiteral("chunk") && request.method == "PUT") {
+        // Content-Range: {chunkStart}-{chunkEnd}/{totalFileSize}
+        QByteArray range = request.headers.value("content-range");
+        if (range.startsWith("bytes "))
+            range.remove(0, 6);
+        const int dash = range.indexOf('-');
+        const int slash = range.indexOf('/');
+        if (dash <= 0 || slash <= dash)
+            return Response(400, errorObject(QStringLiteral("Invalid Content-Range"), QStringLiteral("BadRequest")));
+        const int start = range.left(dash).toInt();
+        const int total = range.mid(slash + 1).toInt();
+
+        QByteArray &data = _fileData[id];
+        if (start != data.size())
+            return Response(400, errorObject(QStringLiteral("Unexpected chunk"), QStringLiteral("BadRequest")));
+        data.append(request.body);
+
+        QJsonObject changes;
+        changes[QStringLiteral("fileSize")] = data.size();
+        changes[QStringLiteral("status")] = data.size() >= total ? QStringLiteral("complete") : QStringLiteral("incomplete");
+        file = update(Files, id, changes, QByteArray());
+        const QJsonObject target = _fileTargets.value(id);
+        if (data.size() >= total && !target.isEmpty())
+            attachFile(file, target, requestId);
+        return Response(200, file);
+    }
+    if (subresource.isEmpty() && request.method == "DELETE") {
+        collection.objects.remove(id);
+        collection.ids.removeOne(id);
+        _fileData.remove(id);
+        _fileTargets.remove(id);
+        return Response(200, file);
+    }
+    return Response(405, errorObject(QStringLiteral("Method not allowed"), QStringLiteral("BadRequest")));
+}
+
+MockBackend::Response MockBackend::handleSearch(const Request &request)
+{
+    const QUrlQuery query(request.query);
+    const QJsonObject search = QJsonDocument::fromJson(query.queryItemValue(QStringLiteral("search"), QUrl::FullyDecoded).toUtf8()).object();
+    QString phrase = search.value(QStringLiteral("phrase")).toString();
+    phrase.remove(QLatin1Char('*'));
+    const QJsonArray properties = search.value(QStringLiteral("properties")).toArray();
+
+    QJsonArray results;
+    foreach (const QString &objectType, query.allQueryItemValues(QStringLiteral("objectTypes[]"), QUrl::FullyDecoded)) {
+        const Collection collection = _collections.value(objectType);
+        foreach (const QString &id, collection.ids) {
+            const QJsonObject object = collection.objects.value(id);
+            bool found = false;
+            for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd() && !found; ++it) {
+                if (!properties.isEmpty() && !properties.contains(it.key()))
+                    continue;
+                found = it.value().isString() && it.value().toString().contains(phrase, Qt::CaseInsensitive);
+            }
+            if (found)
+                results.append(object);
+        }
+    }
+    QJsonObject result;
+    result[Results] = results;
+    return Response(200, result);
+}
+
+MockBackend::Response MockBackend::handleToken(const Request &request)
+{
+    const QUrlQuery form(QString::fromUtf8(request.body));
+    const QString username = form.queryItemValue(QStringLiteral("username"), QUrl::FullyDecoded);
+    const QString password = form.queryItemValue(QStringLiteral("password"), QUrl::FullyDecoded);
+    if (request.method != "POST" || !_passwords.contains(username) || _passwords.value(username) != password) {
+        QJsonObject error;
+        error[QStringLiteral("error")] = QStringLiteral("invalid_grant");
+        error[QStringLiteral("error_description")] = QStringLiteral("Invalid username or password");
+        return Response(401, error);
+    }
+
+    QJsonObject user;
+    const Collection users = _collections.value(Users);
+    foreach (const QString &id, users.ids) {
+        if (users.objects.value(id).value(QStringLiteral("username")).toString() == username)
+            user = users.objects.value(id);
+    }
+    QJsonObject token;
+    token[QStringLiteral("access_token")] = nextId();
+    token[QStringLiteral("refresh_token")] = nextId();
+    token[QStringLiteral("token_type")] = QStringLiteral("bearer");
+    token[QStringLiteral("expires_in")] = 3600;
+    token[QStringLiteral("user")] = user;
+    return Response(200, token);
+}
+
+QJsonObject MockBackend::create(const QString &objectType, const QJsonObject &object, const QByteArray &requestId)
+{
+    QJsonObject stored = object;
+    stored.remove(QStringLiteral("password"));
+    const QString timestamp = nextTimestamp();
+    const QString id = nextId();
+    stored[Id] = id;
+    stored[ObjectType] = objectType;
+    stored[CreatedAt] = timestamp;
+    stored[UpdatedAt] = timestamp;
+
+    Collection &collection = _collections[objectType];
+    collection.ids.append(id);
+    collection.objects.insert(id, stored);
+    notify(QStringLiteral("create"), stored, requestId);
+    return stored;
+}
+
+QJsonObject MockBackend::update(const QString &objectType, const QString &id, const QJsonObject &changes, const QByteArray &requestId)
+{
+    QJsonObject &stored = _collections[objectType].objects[id];
+    for (QJsonObject::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (it.key() != Id && it.key() != ObjectType && it.key() != CreatedAt && it.key() != QStringLiteral("password"))
+            stored[it.key()] = it.value();
+    }
+    stored[UpdatedAt] = nextTimestamp();
+    const QJsonObject result = stored;
+    notify(QStringLiteral("update"), result, requestId);
+    return result;
+}
+
+void MockBackend::attachFile(const QJsonObject &file, const QJsonObject &target, const QByteArray &requestId)
+{
+    const QString objectType = target.value(ObjectType).toString();
+    const QString id = target.value(Id).toString();
+    if (!_collections.value(objectType).objects.contains(id))
+        return;
+    QJsonObject reference;
+    reference[Id] = file.value(Id);
+    reference[ObjectType] = Files;
+    QJsonObject changes;
+    changes[target.value(QStringLiteral("propertyName")).toString()] = reference;
+    update(objectType, id, changes, requestId);
+}
+
+QJsonObject MockBackend::includeReferences(const QJsonObject &object, const QJsonObject &include) const
+{
+    QJsonObject result = object;
+    for (QJsonObject::const_iterator it = include.constBegin(); it != include.constEnd(); ++it) {
+        const QJsonObject reference = object.value(it.key()).toObject();
+        const QString objectType = reference.value(ObjectType).toString();
+        const QString id = reference.value(Id).toString();
+        const QJsonObject referenced = _collections.value(objectType).objects.value(id);
+        if (!referenced.isEmpty())
+            result[it.key()] = includeReferences(referenced, it.value().toObject());
+    }
+    return result;
+}
+
+void MockBackend::notify(const QString &event, const QJsonObject &object, const QByteArray &requestId)
+{
+    if (!webSocketCount())
+        return;
+
+    QJsonObject origin;
+    origin[QStringLiteral("apiRequestId")] = QString::fromLatin1(requestId);
+    QJsonObject message;
+    message[QStringLiteral("messageType")] = QStringLiteral("data");
+    message[QStringLiteral("event")] = event;
+    message[QStringLiteral("data")] = object;
+    message[QStringLiteral("origin")] = origin;
+    const QByteArray frame = webSocketFrame(0x1, QJsonDocument(message).toJson(QJsonDocument::Compact));
+
+    foreach (Connection *connection, _connections) {
+        if (connection->isWebSocket && containsFilter(message, connection->filter))
+            send(connection, frame);
+    }
+}
+
+void MockBackend::send(Connection *connection, const QByteArray &data)
+{
+    if (!_latency && !_bandwidth && !_handshakeLatency && connection->output.isEmpty()) {
+        connection->socket->write(data);
+        return;
+    }
+
+    const qint64 now = _clock.elapsed();
+    const qint64 due = qMax(now + _latency, connection->acceptedAt + _handshakeLatency);
+    if (!_bandwidth && due <= now && connection->output.isEmpty()) {
+        connection->socket->write(data);
+        return;
+    }
+    if (connection->output.isEmpty()) {
+        connection->lastFlush = now;
+        connection->credit = 0;
+    }
+    connection->output.append(qMakePair(due, data));
+    if (!_shapingTimer.isActive())
+        _shapingTimer.start(ShapingInterval, Qt::PreciseTimer, this);
+}
+
+void MockBackend::flush(Connection *connection, qint64 now)
+{
+    if (_bandwidth) {
+        // Allow short bursts only, an idle connection does not save up credit
+        connection->credit = qMin(connection->credit + (now - connection->lastFlush) * _bandwidth / 1000.0,
+                                  qMax(_bandwidth / 100.0, 1.0) + 1460);
+        connection->lastFlush = now;
+    }
+
+    while (!connection->output.isEmpty() && connection->output.first().first <= now) {
+        QByteArray &data = connection->output.first().second;
+        if (!_bandwidth) {
+            connection->socket->write(data);
+            connection->output.removeFirst();
+            continue;
+        }
+        const int size = qMin(int(connection->credit), data.size());
+        if (size <= 0)
+            return;
+        connection->socket->write(data.constData(), size);
+        connection->credit -= size;
+        if (size == data.size())
+            connection->output.removeFirst();
+        else
+            data.remove(0, size);
+    }
+}
+
+void MockBackend::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != _shapingTimer.timerId()) {
+        QTcpServer::timerEvent(event);
+        return;
+    }
+
+    const qint64 now = _clock.elapsed();
+    bool pending = false;
+    foreach (Connection *connection, _connections) {
+        flush(connection, now);
+        pending = pending || !connection->output.isEmpty();
+    }
+    if (!pending)
+        _shapingTimer.stop();
+}
+
+QString MockBackend::nextId()
+{
+    return QString::number(++_lastId, 16).rightJustified(24, QLatin1Char('0'));
+}
+
+// Timestamps are unique, so that "updatedAt" orders all changes
+QString MockBackend::nextTimestamp()
+{
+    _lastTimestamp = qMax(_lastTimestamp + 1, QDateTime::currentMSecsSinceEpoch());
+    return QDateTime::fromMSecsSinceEpoch(_lastTimestamp, Qt::UTC).toString(QStringLiteral("yyyy-MM-dd'T'HH:mm:ss.zzz'Z'"));
+}
+
+}
@@ -0,0 +1,190 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOTESTSMOCKBACKEND_H
+#define ENGINIOTESTSMOCKBACKEND_H
+
+#include <QtCore/qbasictimer.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qpair.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qurl.h>
+#include <QtNetwork/qtcpserver.h>
+
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+QT_FORWARD_DECLARE_CLASS(QUrlQuery)
+
+namespace EnginioTests
+{
+
+/*
+    In-process stand-in for the Enginio REST API and its notification stream.
+
+    It serves the paths EnginioClient builds: objects (with access control),
+    users, usergroups and their members, files (multipart and chunked
+    uploads, download urls), full text search, the oauth2 token and the
+    stream_url WebSocket. Data lives in memory only and any backend id is
+    accepted.
+
+    Responses and notification frames can be delayed by a fixed latency and
+    throttled to a bandwidth, so that request pipelines can be measured
+    without depending on a real network. Every response carries a
+    Server-Timing header with the time spent handling the request.
+*/
+class MockBackend: public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit MockBackend(QObject *parent = 0);
+    ~MockBackend();
+
+    bool start();
+    QUrl serviceUrl() const Q_REQUIRED_RESULT;
+    static QByteArray backendId() Q_REQUIRED_RESULT;
+
+    void setLatency(int msecs);
+    int latency() const Q_REQUIRED_RESULT { return _latency; }
+    void setBandwidth(int bytesPerSecond);
+    int bandwidth() const Q_REQUIRED_RESULT { return _bandwidth; }
+    void setHandshakeLatency(int msecs);
+    int handshakeLatency() const Q_REQUIRED_RESULT { return _handshakeLatency; }
+
+    int requestCount() const Q_REQUIRED_RESULT { return _requestCount; }
+    int webSocketCount() const Q_REQUIRED_RESULT;
+
+    // Direct access to the stored data, without notifications
+    QJsonObject insertObject(const QString &objectType, const QJsonObject &object);
+    QJsonArray objects(const QString &objectType) const Q_REQUIRED_RESULT;
+    void insertUser(const QString &username, const QString &password);
+    void clear();
+
+Q_SIGNALS:
+    void requestFinished(const QByteArray &method, const QString &path, int status);
+
+protected:
+    void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
+
+private Q_SLOTS:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    struct Request
+    {
+        QByteArray method;
+        QString path;
+        QString query;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    struct Response
+    {
+        int status;
+        QByteArray contentType;
+        QByteArray body;
+
+        Response(int status = 200, const QJsonObject &object = QJsonObject());
+        Response(int status, const QByteArray &contentType, const QByteArray &body);
+    };
+
+    struct Connection
+    {
+        QTcpSocket *socket;
+        QByteArray input;
+        bool isWebSocket;
+        QJsonObject filter;
+        // Data waiting for its time, and the bandwidth credit in bytes
+        QList<QPair<qint64, QByteArray> > output;
+        qint64 lastFlush;
+        double credit;
+        qint64 acceptedAt;
+    };
+
+    struct Collection
+    {
+        QStringList ids;
+        QHash<QString, QJsonObject> objects;
+    };
+
+    bool processHttp(Connection *connection);
+    void processWebSocket(Connection *connection);
+    void acceptWebSocket(Connection *connection, const Request &request);
+    Response handle(const Request &request);
+    Response handleCollection(const Request &request, const QString &objectType, const QString &id);
+    Response handleAccess(const Request &request, const QString &objectType, const QString &id);
+    Response handleMembers(const Request &request, const QString &groupId);
+    Response handleFiles(const Request &request, const QStringList &segments);
+    Response handleSearch(const Request &request);
+    Response handleToken(const Request &request);
+    Response handleQuery(const QString &objectType, const QUrlQuery &query);
+
+    QJsonObject create(const QString &objectType, const QJsonObject &object, const QByteArray &requestId);
+    QJsonObject update(const QString &objectType, const QString &id, const QJsonObject &changes, const QByteArray &requestId);
+    void attachFile(const QJsonObject &file, const QJsonObject &target, const QByteArray &requestId);
+    QJsonObject includeReferences(const QJsonObject &object, const QJsonObject &include) const;
+    void notify(const QString &event, const QJsonObject &object, const QByteArray &requestId);
+
+    void send(Connection *connection, const QByteArray &data);
+    void flush(Connection *connection, qint64 now);
+    QString nextId();
+    QString nextTimestamp();
+
+    QHash<QTcpSocket*, Connection*> _connections;
+    QHash<QString, Collection> _collections;
+    QHash<QString, QJsonObject> _access;
+    QHash<QString, QJsonArray> _members;
+    QHash<QString, QByteArray> _fileData;
+    QHash<QString, QJsonObject> _fileTargets;
+    QHash<QString, QString> _passwords;
+    QBasicTimer _shapingTimer;
+    QElapsedTimer _clock;
+    qint64 _lastTimestamp;
+    quint64 _lastId;
+    int _latency;
+    int _bandwidth;
+    int _handshakeLatency;
+    int _requestCount;
+};
+
+}
+
+#endif // ENGINIOTESTSMOCKBACKEND_H
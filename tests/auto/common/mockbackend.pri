@@ -0,0 +1,4 @@
+QT += network
+INCLUDEPATH += $$PWD
+SOURCES += $$PWD/mockbackend.cpp
+HEADERS += $$PWD/mockbackend.h
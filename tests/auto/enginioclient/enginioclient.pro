@@ -8,5 +8,6 @@ CONFIG   -= app_bundle
 TEMPLATE = app
 
 include(../common/common.pri)
+include(../common/mockbackend.pri)
 
 SOURCES += tst_enginioclient.cpp
\ No newline at end of file
@@ -39,8 +39,10 @@
 #include <Enginio/enginioreply.h>
 #include <Enginio/enginioidentity.h>
 #include <Enginio/enginiooauth2authentication.h>
+#include <Enginio/private/enginioclient_p.h>
 
 #include "../common/common.h"
+#include "../common/mockbackend.h"
 
 class tst_EnginioClient: public QObject
 {
@@ -49,6 +51,7 @@ class tst_EnginioClient: public QObject
     QString _backendName;
     EnginioTests::EnginioBackendManager _backendManager;
     QByteArray _backendId;
+    EnginioTests::MockBackend _mockBackend;
 
 public slots:
     void error(EnginioReply *reply) {
@@ -61,6 +64,7 @@ public slots:
 private slots:
     void initTestCase();
     void cleanupTestCase();
+    void init();
     void internal_createObjectType();
     void deleteReply();
     void create_todos();
@@ -68,6 +72,7 @@ private slots:
     void query_todos();
     void query_todos_filter();
     void query_todos_limit();
+    void query_todos_prepared();
     void query_todos_count();
     void query_todos_sort();
     void remove_todos();
@@ -91,6 +96,10 @@ private slots:
     void fullTextSearch();
     void assignUserToGroup();
     void userAgent();
+    void requestIds();
+    void requestLog();
+    void requestTiming();
+    void sharedQueries();
 
 private:
     QString usergroupId(EnginioClient *client)
@@ -119,6 +128,8 @@ private:
 
 void tst_EnginioClient::initTestCase()
 {
+    QVERIFY(_mockBackend.start());
+
     if (EnginioTests::TESTAPP_URL.isEmpty())
         QFAIL("Needed environment variable ENGINIO_API_URL is not set!");
 
@@ -182,6 +193,13 @@ void tst_EnginioClient::cleanupTestCase()
     QVERIFY(_backendManager.removeBackend(_backendName));
 }
 
+void tst_EnginioClient::init()
+{
+    // Tests which do not need the real backend use the mock one
+    _mockBackend.clear();
+    _mockBackend.setLatency(0);
+}
+
 void tst_EnginioClient::internal_createObjectType()
 {
     EnginioTests::EnginioBackendManager backendManager;
@@ -297,6 +315,47 @@ void tst_EnginioClient::query_todos_limit()
     QCOMPARE(data["results"].toArray().count(), 1);
 }
 
+void tst_EnginioClient::query_todos_prepared()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    QVERIFY(!client.prepareQuery(QJsonObject()).isNull());
+    QVERIFY(!client.prepareQuery(QJsonObject()).isValid());
+
+    QJsonObject obj;
+    obj["objectType"] = QString::fromUtf8("objects.todos");
+    obj["limit"] = 1;
+    obj["sort"] = QJsonDocument::fromJson(QByteArrayLiteral("[{\"sortBy\": \"createdAt\", \"direction\": \"asc\"}]")).array();
+    const EnginioPreparedQuery query = client.prepareQuery(obj);
+    QVERIFY(query.isValid());
+    QCOMPARE(query.operation(), Enginio::ObjectOperation);
+    QCOMPARE(query.limit(), 1);
+    QCOMPARE(query.offset(), 0);
+
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+    QSignalSpy spyError(&client, SIGNAL(error(EnginioReply*)));
+
+    // The same prepared query fetches two consecutive pages
+    const EnginioReply *first = client.query(query);
+    const EnginioReply *second = client.query(query, 1, 1);
+    QVERIFY(first);
+    QVERIFY(second);
+
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(spyError.count(), 0);
+    CHECK_NO_ERROR(first);
+    CHECK_NO_ERROR(second);
+
+    const QJsonArray firstResults = first->data()["results"].toArray();
+    const QJsonArray secondResults = second->data()["results"].toArray();
+    QCOMPARE(firstResults.count(), 1);
+    QCOMPARE(secondResults.count(), 1);
+    QVERIFY(firstResults[0].toObject()["id"] != secondResults[0].toObject()["id"]);
+}
+
 void tst_EnginioClient::query_todos_count()
 {
     EnginioClient client;
@@ -873,6 +932,243 @@ void tst_EnginioClient::userAgent()
         QTRY_VERIFY(reply->isFinished());
 }
 
+static bool isRequestId(const QByteArray &id)
+{
+    if (id.size() != 32)
+        return false;
+    foreach (const char c, id) {
+        if (!(c >= '0' && c <= '9') && !(c >= 'a' && c <= 'f'))
+            return false;
+    }
+    return true;
+}
+
+void tst_EnginioClient::requestIds()
+{
+    // The backend echoes the id in the notifications of the request, the
+    // models match them by it, so ids of all clients have to be distinct.
+    const int count = 100000;
+    EnginioRequestIdGenerator first;
+    EnginioRequestIdGenerator second;
+    QSet<QByteArray> ids;
+    ids.reserve(2 * count);
+    for (int i = 0; i < count; ++i) {
+        ids.insert(first.next());
+        ids.insert(second.next());
+    }
+    QCOMPARE(ids.count(), 2 * count);
+    foreach (const QByteArray &id, ids)
+        QVERIFY2(isRequestId(id), id.constData());
+
+    // Requests carry ids of the same format
+    EnginioClient client;
+    client.setBackendId(_backendId);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+    EnginioReply *reply = client.query(QJsonObject(), Enginio::UserOperation);
+    QVERIFY(isRequestId(reply->requestId().toLatin1()));
+    QTRY_VERIFY(reply->isFinished());
+}
+
+static QStringList debugMessages;
+
+static void collectDebugMessage(QtMsgType, const QMessageLogContext &, const QString &message)
+{
+    debugMessages.append(message);
+}
+
+// The request payload printed by dumpDebugInfo(), if it was kept
+static QString requestData(const EnginioReply *reply)
+{
+    debugMessages.clear();
+    QtMessageHandler handler = qInstallMessageHandler(collectDebugMessage);
+    reply->dumpDebugInfo();
+    qInstallMessageHandler(handler);
+    foreach (const QString &message, debugMessages) {
+        if (message.startsWith(QStringLiteral("Request Data:")))
+            return message;
+    }
+    return QString();
+}
+
+static EnginioReply *createTodo(EnginioClient *client, const QString &title)
+{
+    QJsonObject object;
+    object["objectType"] = QStringLiteral("objects.todos");
+    object["title"] = title;
+    return client->create(object);
+}
+
+void tst_EnginioClient::requestLog()
+{
+    if (!gEnableEnginioDebugInfo)
+        QSKIP("Debug info is disabled by ENGINIO_DEBUG_INFO");
+    qunsetenv("ENGINIO_DEBUG_INFO_BUDGET");
+    qunsetenv("ENGINIO_DEBUG_INFO_SAMPLING");
+
+    QList<EnginioReply*> replies;
+    EnginioClient client;
+    client.setBackendId(_backendId);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+    EnginioRequestLog &log = EnginioClientConnectionPrivate::get(&client)->_requestLog;
+
+    // Only the payloads of the most recent requests are kept
+    for (int i = 0; i <= EnginioRequestLog::DefaultCapacity; ++i)
+        replies.append(createTodo(&client, QString::fromLatin1("log %1").arg(i)));
+    QVERIFY(requestData(replies.first()).isEmpty());
+    QVERIFY(requestData(replies[1]).contains(QStringLiteral("log 1")));
+    QVERIFY(requestData(replies.last()).contains(QString::fromLatin1("log %1").arg(int(EnginioRequestLog::DefaultCapacity))));
+    QVERIFY(log.bytes() > 0 && log.bytes() <= EnginioRequestLog::DefaultBudget);
+
+    // A payload larger than the budget is truncated, older ones are dropped
+    // to stay within the budget
+    log.setBudget(300);
+    QCOMPARE(log.bytes(), 0);
+    QVERIFY(requestData(replies.last()).isEmpty());
+    EnginioReply *large = createTodo(&client, QString(400, QLatin1Char('x')) + QStringLiteral("end"));
+    replies.append(large);
+    QCOMPARE(log.bytes(), 300);
+    QVERIFY(requestData(large).contains(QStringLiteral("xxx")));
+    QVERIFY(!requestData(large).contains(QStringLiteral("end")));
+    EnginioReply *small = createTodo(&client, QStringLiteral("small"));
+    replies.append(small);
+    QVERIFY(requestData(large).isEmpty());
+    QVERIFY(requestData(small).contains(QStringLiteral("small")));
+    QVERIFY(log.bytes() < 300);
+
+    // With a sampling of n only every n-th request is kept, 0 keeps none
+    log.setSampling(2);
+    for (int i = 0; i < 3; ++i)
+        replies.append(createTodo(&client, QStringLiteral("sampled")));
+    QVERIFY(!requestData(replies[replies.count() - 3]).isEmpty());
+    QVERIFY(requestData(replies[replies.count() - 2]).isEmpty());
+    QVERIFY(!requestData(replies.last()).isEmpty());
+    log.setSampling(0);
+    replies.append(createTodo(&client, QStringLiteral("not sampled")));
+    QVERIFY(requestData(replies.last()).isEmpty());
+
+    // The environment sets the defaults of new clients, invalid values are ignored
+    qputenv("ENGINIO_DEBUG_INFO_BUDGET", "64");
+    qputenv("ENGINIO_DEBUG_INFO_SAMPLING", "3");
+    {
+        EnginioClient configured;
+        configured.setBackendId(_backendId);
+        configured.setServiceUrl(EnginioTests::TESTAPP_URL);
+        EnginioRequestLog &configuredLog = EnginioClientConnectionPrivate::get(&configured)->_requestLog;
+        QList<EnginioReply*> configuredReplies;
+        for (int i = 0; i < 3; ++i)
+            configuredReplies.append(createTodo(&configured, QString(100, QLatin1Char('y'))));
+        QCOMPARE(configuredLog.bytes(), 64);
+        QVERIFY(!requestData(configuredReplies[0]).isEmpty());
+        QVERIFY(requestData(configuredReplies[1]).isEmpty());
+        QVERIFY(requestData(configuredReplies[2]).isEmpty());
+        foreach (const EnginioReply *reply, configuredReplies)
+            QTRY_VERIFY(reply->isFinished());
+    }
+    qputenv("ENGINIO_DEBUG_INFO_BUDGET", "-1");
+    qputenv("ENGINIO_DEBUG_INFO_SAMPLING", "none");
+    {
+        EnginioClient defaults;
+        defaults.setBackendId(_backendId);
+        defaults.setServiceUrl(EnginioTests::TESTAPP_URL);
+        EnginioReply *first = createTodo(&defaults, QStringLiteral("default 1"));
+        EnginioReply *second = createTodo(&defaults, QStringLiteral("default 2"));
+        QVERIFY(requestData(first).contains(QStringLiteral("default 1")));
+        QVERIFY(requestData(second).contains(QStringLiteral("default 2")));
+        QTRY_VERIFY(first->isFinished() && second->isFinished());
+    }
+    qunsetenv("ENGINIO_DEBUG_INFO_BUDGET");
+    qunsetenv("ENGINIO_DEBUG_INFO_SAMPLING");
+
+    foreach (const EnginioReply *reply, replies)
+        QTRY_VERIFY(reply->isFinished());
+}
+
+void tst_EnginioClient::requestTiming()
+{
+    EnginioClient client;
+    client.setBackendId(EnginioTests::MockBackend::backendId());
+    client.setServiceUrl(_mockBackend.serviceUrl());
+    QVERIFY(!client.isRequestTimingEnabled());
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+    const EnginioReply *untimed = client.query(query);
+    QTRY_VERIFY(untimed->isFinished());
+    QVERIFY(untimed->timing().isEmpty());
+
+    client.setRequestTimingEnabled(true);
+    _mockBackend.setLatency(50);
+    const EnginioReply *reply = client.query(query);
+    QTRY_VERIFY(reply->isFinished());
+    QVERIFY(!reply->isError());
+    QVERIFY(!reply->data().isEmpty());
+
+    const QJsonObject timing = reply->timing();
+    QCOMPARE(timing["operation"].toString(), QStringLiteral("ObjectOperation"));
+    QCOMPARE(timing["created"].toDouble(), 0.0);
+    QVERIFY(timing["sent"].toDouble() >= 0);
+    QVERIFY(timing["firstByte"].toDouble() - timing["sent"].toDouble() >= 45);
+    QVERIFY(timing["finished"].toDouble() >= timing["firstByte"].toDouble());
+    QVERIFY(timing["delivered"].toDouble() >= timing["finished"].toDouble());
+    QVERIFY(timing.contains("parsed"));
+    QVERIFY(timing["parseDuration"].toDouble() >= 0);
+    const QJsonObject server = timing["serverTiming"].toObject()["app"].toObject();
+    QVERIFY(server["duration"].isDouble());
+    QCOMPARE(server["description"].toString(), QStringLiteral("mock backend"));
+
+    QJsonObject statistics = client.requestTimingStatistics();
+    QCOMPARE(statistics["bounds"].toArray().count() + 1, statistics["operations"].toObject()["ObjectOperation"].toObject()["total"].toObject()["buckets"].toArray().count());
+    const QJsonObject phases = statistics["operations"].toObject()["ObjectOperation"].toObject();
+    QCOMPARE(phases["total"].toObject()["count"].toInt(), 1);
+    QVERIFY(phases["total"].toObject()["min"].toDouble() >= 45);
+    QCOMPARE(phases["server"].toObject()["count"].toInt(), 1);
+    QVERIFY(!phases.contains("parsing")); // parsed after the statistics were taken
+
+    client.resetRequestTimingStatistics();
+    statistics = client.requestTimingStatistics();
+    QVERIFY(statistics["operations"].toObject().isEmpty());
+}
+
+void tst_EnginioClient::sharedQueries()
+{
+    EnginioClient client;
+    client.setBackendId(EnginioTests::MockBackend::backendId());
+    client.setServiceUrl(_mockBackend.serviceUrl());
+    for (int i = 0; i < 3; ++i)
+        _mockBackend.insertObject(QStringLiteral("objects.todos"), QJsonObject());
+    const QJsonObject query = QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object();
+
+    _mockBackend.setLatency(100);
+    const int requests = _mockBackend.requestCount();
+    EnginioReply *first = client.query(query);
+    const EnginioReply *second = client.query(query);
+    const EnginioReply *third = client.query(query);
+    QVERIFY(second->requestId() != third->requestId());
+
+    // The others still get the result if the first one is deleted.
+    delete first;
+    QTRY_VERIFY(second->isFinished() && third->isFinished());
+    QVERIFY(!second->isError());
+    QCOMPARE(second->backendStatus(), 200);
+    QCOMPARE(second->data()["results"].toArray().count(), 3);
+    QCOMPARE(third->data(), second->data());
+    QCOMPARE(_mockBackend.requestCount(), requests + 1);
+
+    // Only queries in flight are shared
+    const EnginioReply *fourth = client.query(query);
+    QTRY_VERIFY(fourth->isFinished());
+    QCOMPARE(_mockBackend.requestCount(), requests + 2);
+
+    // A different query is sent on its own
+    const EnginioReply *all = client.query(query);
+    QJsonObject limited = query;
+    limited["limit"] = 1;
+    const EnginioReply *one = client.query(limited);
+    QTRY_VERIFY(all->isFinished() && one->isFinished());
+    QCOMPARE(one->data()["results"].toArray().count(), 1);
+    QCOMPARE(_mockBackend.requestCount(), requests + 4);
+}
+
 struct DeleteReplyCountHelper
 {
     QSet<QString> &requests;
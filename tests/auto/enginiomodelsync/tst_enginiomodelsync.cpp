@@ -0,0 +1,774 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+
+#include <Enginio/enginioaggregatemodel.h>
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginiomodel.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/private/enginiomodeldiff_p.h>
+#include <Enginio/private/enginioquerymatcher_p.h>
+
+#include "mockbackend.h"
+
+class tst_EnginioModelSync: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockBackend _backend;
+    EnginioClient _client;
+
+private slots:
+    void initTestCase();
+    void init();
+    void diff_data();
+    void diff();
+    void reload();
+    void reloadPendingChanges();
+    void queryChanges();
+    void sortOrder();
+    void queryMatcher_data();
+    void queryMatcher();
+    void queryFilter();
+    void cellCache();
+    void roleIndex();
+    void aggregateModel();
+    void sharedModels();
+};
+
+void tst_EnginioModelSync::initTestCase()
+{
+    QVERIFY(_backend.start());
+    _client.setBackendId(EnginioTests::MockBackend::backendId());
+    _client.setServiceUrl(_backend.serviceUrl());
+}
+
+void tst_EnginioModelSync::init()
+{
+    _backend.clear();
+    _backend.setLatency(0);
+}
+
+static QJsonArray objectsWithIds(const QString &ids)
+{
+    QJsonArray objects;
+    foreach (const QChar id, ids) {
+        QJsonObject object;
+        object["id"] = QString(id.toLower());
+        object["title"] = id.isUpper() ? QStringLiteral("changed") : QStringLiteral("title");
+        objects.append(object);
+    }
+    return objects;
+}
+
+void tst_EnginioModelSync::diff_data()
+{
+    // An upper case id stands for an object with a changed title
+    QTest::addColumn<QString>("from");
+    QTest::addColumn<QString>("to");
+    QTest::addColumn<int>("moves");
+
+    QTest::newRow("same") << QString("abcdef") << QString("abcdef") << 0;
+    QTest::newRow("removed") << QString("abcdef") << QString("acdf") << 0;
+    QTest::newRow("inserted") << QString("abcdef") << QString("xabcydefz") << 0;
+    QTest::newRow("changed") << QString("abcdef") << QString("aBcdEf") << 0;
+    QTest::newRow("last to first") << QString("abcdef") << QString("fabcde") << 1;
+    QTest::newRow("first to last") << QString("abcdef") << QString("bcdefa") << 1;
+    QTest::newRow("block") << QString("abcdefgh") << QString("aefbcdgh") << 1;
+    QTest::newRow("swapped") << QString("abcdef") << QString("afcdeb") << 2;
+    QTest::newRow("mixed") << QString("abcdefgh") << QString("hxaCgdyb") << 3;
+}
+
+void tst_EnginioModelSync::diff()
+{
+    QFETCH(QString, from);
+    QFETCH(QString, to);
+    QFETCH(int, moves);
+
+    const QJsonArray toObjects = objectsWithIds(to);
+    const EnginioModelDiff diff = EnginioModelDiff::compute(objectsWithIds(from), toObjects);
+    QVERIFY(!diff.isReset());
+
+    // Replay the steps the way the model does.
+    QString rows = from;
+    QString changed;
+    int moveCount = 0;
+    int structuralSteps = 0;
+    foreach (const EnginioModelDiff::Step &step, diff.steps()) {
+        const int count = step.last - step.first + 1;
+        structuralSteps += step.type != EnginioModelDiff::ChangeRows;
+        switch (step.type) {
+        case EnginioModelDiff::RemoveRows:
+            rows.remove(step.first, count);
+            break;
+        case EnginioModelDiff::MoveRows: {
+            QVERIFY(step.destination < step.first || step.destination > step.last + 1);
+            const QString moved = rows.mid(step.first, count);
+            rows.remove(step.first, count);
+            rows.insert(step.destination > step.first ? step.destination - count : step.destination, moved);
+            ++moveCount;
+            break;
+        }
+        case EnginioModelDiff::InsertRows:
+            rows.insert(step.first, to.mid(step.first, count));
+            break;
+        case EnginioModelDiff::ChangeRows:
+            changed += to.mid(step.first, count);
+            break;
+        }
+    }
+    QCOMPARE(rows.toLower(), to.toLower());
+    QCOMPARE(moveCount, moves);
+    foreach (const QChar id, to) {
+        if (id.isUpper() && from.contains(id.toLower()))
+            QVERIFY(changed.contains(id));
+    }
+
+    // Results that can not be matched need a reset
+    QVERIFY(EnginioModelDiff::compute(objectsWithIds(from), objectsWithIds("xyz")).isReset());
+    QVERIFY(EnginioModelDiff::compute(objectsWithIds(from), objectsWithIds("aab")).isReset());
+    QCOMPARE(EnginioModelDiff::compute(objectsWithIds(from), toObjects, 0).isReset(), structuralSteps > 0);
+}
+
+void tst_EnginioModelSync::reload()
+{
+    QStringList ids;
+    for (int i = 0; i < 5; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::fromLatin1("todo %1").arg(i);
+        ids.append(_backend.insertObject(QStringLiteral("objects.todos"), todo)["id"].toString());
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object());
+    QTRY_COMPARE(model.rowCount(), 5);
+
+    QJsonObject removed;
+    removed["objectType"] = QStringLiteral("objects.todos");
+    removed["id"] = ids[1];
+    QJsonObject changed = removed;
+    changed["id"] = ids[3];
+    changed["title"] = QStringLiteral("changed");
+    QJsonObject created;
+    created["objectType"] = QStringLiteral("objects.todos");
+    created["title"] = QStringLiteral("new");
+    QList<const EnginioReply*> replies;
+    replies << _client.remove(removed) << _client.update(changed) << _client.create(created);
+    foreach (const EnginioReply *reply, replies) {
+        QTRY_VERIFY(reply->isFinished());
+        QVERIFY(!reply->isError());
+    }
+
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    model.reload();
+    QTRY_COMPARE(insertedSpy.count(), 1);
+
+    // A reload keeps the rows which did not change.
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy[0][1].toInt(), 1);
+    QCOMPARE(insertedSpy[0][1].toInt(), 4);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy[0][0].value<QModelIndex>().row(), 2);
+
+    const QJsonArray objects = _backend.objects(QStringLiteral("objects.todos"));
+    QCOMPARE(model.rowCount(), objects.count());
+    for (int row = 0; row < objects.count(); ++row)
+        QCOMPARE(model.data(model.index(row), Enginio::JsonObjectRole).toJsonValue(), QJsonValue(objects[row]));
+}
+
+void tst_EnginioModelSync::reloadPendingChanges()
+{
+    for (int i = 0; i < 2; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::fromLatin1("todo %1").arg(i);
+        _backend.insertObject(QStringLiteral("objects.todos"), todo);
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object());
+    QTRY_COMPARE(model.rowCount(), 2);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+
+    // The backend stores the changes right away, but answers after the reload
+    _backend.setLatency(500);
+    const int requests = _backend.requestCount();
+    QJsonObject appended;
+    appended["title"] = QStringLiteral("appended");
+    const EnginioReply *created = model.append(appended);
+    const EnginioReply *updated = model.setData(0, QStringLiteral("changed"), QStringLiteral("title"));
+    QTRY_COMPARE(_backend.requestCount(), requests + 2);
+    _backend.setLatency(0);
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(!model.data(model.index(0), Enginio::SyncedRole).toBool());
+
+    // The appended row without an id is replaced by the stored object,
+    // the changed row stays pending.
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    model.reload();
+    QTRY_COMPARE(insertedSpy.count(), 1);
+    QVERIFY(!created->isFinished());
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(!model.data(model.index(2), Enginio::IdRole).toString().isEmpty());
+    QVERIFY(!model.data(model.index(0), Enginio::SyncedRole).toBool());
+
+    QTRY_VERIFY(created->isFinished() && updated->isFinished());
+    QVERIFY(!created->isError());
+    QVERIFY(!updated->isError());
+    QTRY_VERIFY(model.data(model.index(0), Enginio::SyncedRole).toBool());
+    const QJsonArray objects = _backend.objects(QStringLiteral("objects.todos"));
+    QCOMPARE(model.rowCount(), objects.count());
+    for (int row = 0; row < objects.count(); ++row)
+        QCOMPARE(model.data(model.index(row), Enginio::IdRole).toString(), objects[row].toObject()["id"].toString());
+}
+
+void tst_EnginioModelSync::queryChanges()
+{
+    for (int i = 0; i < 3; ++i)
+        _backend.insertObject(QStringLiteral("objects.todos"), QJsonObject());
+    for (int i = 0; i < 2; ++i)
+        _backend.insertObject(QStringLiteral("objects.notes"), QJsonObject());
+    const QJsonObject todos = QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object();
+    const QJsonObject notes = QJsonDocument::fromJson("{\"objectType\": \"objects.notes\"}").object();
+
+    _backend.setLatency(100);
+    EnginioModel model;
+    model.setClient(&_client);
+    QSignalSpy finished(&_client, SIGNAL(finished(EnginioReply*)));
+    model.setQuery(todos);
+    model.setQuery(notes);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QTest::qWait(200);
+    // The superseded query was aborted, its reply never finished.
+    QCOMPARE(finished.count(), 1);
+
+    model.setQueryDebounceInterval(50);
+    QCOMPARE(model.queryDebounceInterval(), 50);
+    const int requests = _backend.requestCount();
+    for (int i = 0; i < 5; ++i) {
+        model.setQuery(notes);
+        model.setQuery(todos);
+    }
+    QTRY_COMPARE(model.rowCount(), 3);
+    QCOMPARE(_backend.requestCount(), requests + 1);
+}
+
+void tst_EnginioModelSync::sortOrder()
+{
+    QStringList ids;
+    for (int i = 1; i <= 4; ++i) {
+        QJsonObject todo;
+        todo["priority"] = i * 10;
+        ids.append(_backend.insertObject(QStringLiteral("objects.todos"), todo)["id"].toString());
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.todos\", \"sort\": [{\"sortBy\": \"priority\"}]}").object());
+    QTRY_COMPARE(model.rowCount(), 4);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy movedSpy(&model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+
+    // Created objects are inserted where the query would return them
+    QJsonObject created;
+    created["objectType"] = QStringLiteral("objects.todos");
+    created["priority"] = 25;
+    const EnginioReply *reply = _client.create(created);
+    QTRY_COMPARE(insertedSpy.count(), 1);
+    QVERIFY(reply->isFinished());
+    QCOMPARE(insertedSpy[0][1].toInt(), 2);
+
+    // Objects without the sort key come last
+    created.remove("priority");
+    _client.create(created);
+    QTRY_COMPARE(insertedSpy.count(), 2);
+    QCOMPARE(insertedSpy[1][1].toInt(), 5);
+
+    // An update of the sort key moves the row
+    QJsonObject changed;
+    changed["objectType"] = QStringLiteral("objects.todos");
+    changed["id"] = ids[0];
+    changed["priority"] = 35;
+    _client.update(changed);
+    QTRY_COMPARE(movedSpy.count(), 1);
+    QCOMPARE(movedSpy[0][1].toInt(), 0);
+    QCOMPARE(movedSpy[0][4].toInt(), 4);
+
+    QList<int> priorities;
+    for (int row = 0; row < model.rowCount(); ++row)
+        priorities.append(model.data(model.index(row), Enginio::JsonObjectRole).toJsonValue().toObject()["priority"].toInt(-1));
+    QCOMPARE(priorities, QList<int>() << 20 << 25 << 30 << 35 << 40 << -1);
+    QCOMPARE(model.data(model.index(3), Enginio::IdRole).toString(), ids[0]);
+}
+
+void tst_EnginioModelSync::queryMatcher_data()
+{
+    QTest::addColumn<QByteArray>("filter");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("matching");
+
+    // The objects the backend returns for the filter, out of the objects
+    // "a" to "e" with the priorities 1 to 5, see below.
+    QTest::newRow("empty") << QByteArray("{}") << true << QString("abcde");
+    QTest::newRow("equal") << QByteArray("{\"priority\": 2}") << true << QString("b");
+    QTest::newRow("$eq") << QByteArray("{\"priority\": {\"$eq\": 2}}") << true << QString("b");
+    QTest::newRow("$ne") << QByteArray("{\"priority\": {\"$ne\": 2}}") << true << QString("acde");
+    QTest::newRow("range") << QByteArray("{\"priority\": {\"$gt\": 1, \"$lte\": 3}}") << true << QString("bc");
+    QTest::newRow("$in") << QByteArray("{\"title\": {\"$in\": [\"a\", \"d\", \"x\"]}}") << true << QString("ad");
+    QTest::newRow("$nin") << QByteArray("{\"title\": {\"$nin\": [\"a\", \"d\"]}}") << true << QString("bce");
+    QTest::newRow("$exists") << QByteArray("{\"done\": {\"$exists\": true}}") << true << QString("bd");
+    QTest::newRow("$regex") << QByteArray("{\"title\": {\"$regex\": \"^[A-C]$\", \"$options\": \"i\"}}") << true << QString("abc");
+    QTest::newRow("nested path") << QByteArray("{\"creator.id\": \"odd\"}") << true << QString("ace");
+    QTest::newRow("time literal") << QByteArray("{\"createdAt\": {\"$gte\": {\"$type\": \"time\", \"$value\": \"2015-01-04\"}}}") << true << QString("de");
+    QTest::newRow("$or") << QByteArray("{\"$or\": [{\"priority\": 1}, {\"done\": true}]}") << true << QString("ad");
+    QTest::newRow("$and") << QByteArray("{\"$and\": [{\"priority\": {\"$gt\": 1}}, {\"creator.id\": \"odd\"}]}") << true << QString("ce");
+    QTest::newRow("type mismatch") << QByteArray("{\"priority\": {\"$gt\": \"1\"}}") << true << QString();
+    QTest::newRow("array contains") << QByteArray("{\"tags\": \"x\"}") << true << QString("ae");
+    QTest::newRow("array equal") << QByteArray("{\"tags\": [\"y\"]}") << true << QString("b");
+    QTest::newRow("array $ne") << QByteArray("{\"tags\": {\"$ne\": \"x\"}}") << true << QString("bcd");
+    QTest::newRow("array $in") << QByteArray("{\"tags\": {\"$in\": [\"y\", \"z\"]}}") << true << QString("ab");
+    QTest::newRow("array $nin") << QByteArray("{\"tags\": {\"$nin\": [\"x\"]}}") << true << QString("bcd");
+    QTest::newRow("array range") << QByteArray("{\"tags\": {\"$gte\": \"y\"}}") << true << QString("ab");
+    QTest::newRow("null") << QByteArray("{\"file\": null}") << true << QString("acde");
+    QTest::newRow("null $in") << QByteArray("{\"file\": {\"$in\": [null]}}") << true << QString("acde");
+    QTest::newRow("null $ne") << QByteArray("{\"file\": {\"$ne\": null}}") << true << QString("b");
+    // Not followed by the client, the object is kept
+    QTest::newRow("path into array") << QByteArray("{\"comments.author\": \"bob\"}") << true << QString("c");
+    QTest::newRow("unknown operator") << QByteArray("{\"title\": {\"$near\": [0, 0]}}") << false << QString("abcde");
+}
+
+void tst_EnginioModelSync::queryMatcher()
+{
+    QFETCH(QByteArray, filter);
+    QFETCH(bool, valid);
+    QFETCH(QString, matching);
+
+    const QJsonObject filterObject = QJsonDocument::fromJson(filter).object();
+    const EnginioQueryMatcher matcher = EnginioQueryMatcher::compile(filterObject);
+    QCOMPARE(matcher.isValid(), valid);
+
+    const char *tags[] = { "[\"x\", \"y\"]", "[\"y\"]", "[]", 0, "[\"x\"]" };
+    for (int i = 0; i < 5; ++i) {
+        QJsonObject object;
+        object["title"] = QString(QChar('a' + i));
+        if (tags[i])
+            object["tags"] = QJsonDocument::fromJson(tags[i]).array();
+        if (i == 0)
+            object["file"] = QJsonValue();
+        else if (i == 1)
+            object["file"] = QStringLiteral("f.png");
+        if (i == 2)
+            object["comments"] = QJsonDocument::fromJson("[{\"author\": \"bob\"}]").array();
+        object["priority"] = i + 1;
+        object["createdAt"] = QString::fromLatin1("2015-01-0%1").arg(i + 1);
+        if (i % 2)
+            object["done"] = i == 3;
+        QJsonObject creator;
+        creator["id"] = QString::fromLatin1(i % 2 ? "even" : "odd");
+        object["creator"] = creator;
+        QCOMPARE(matcher.matches(object), matching.contains(QChar('a' + i)));
+    }
+}
+
+void tst_EnginioModelSync::queryFilter()
+{
+    QStringList ids;
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject todo;
+        todo["completed"] = false;
+        ids.append(_backend.insertObject(QStringLiteral("objects.todos"), todo)["id"].toString());
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.todos\", \"query\": {\"completed\": false}}").object());
+    QTRY_COMPARE(model.rowCount(), 3);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // Objects the query would not return are not added
+    QJsonObject completed;
+    completed["objectType"] = QStringLiteral("objects.todos");
+    completed["completed"] = true;
+    const EnginioReply *ignored = _client.create(completed);
+    QJsonObject pending = completed;
+    pending["completed"] = false;
+    const EnginioReply *created = _client.create(pending);
+    QTRY_VERIFY(ignored->isFinished() && created->isFinished());
+    QTRY_COMPARE(insertedSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.data(model.index(3), Enginio::IdRole).toString(), created->data()["id"].toString());
+
+    // Rows which do not match anymore are removed
+    QJsonObject changed = completed;
+    changed["id"] = ids[1];
+    _client.update(changed);
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy[0][1].toInt(), 1);
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(insertedSpy.count(), 1);
+
+    // and come back when they match again
+    changed["completed"] = false;
+    _client.update(changed);
+    QTRY_COMPARE(insertedSpy.count(), 2);
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.data(model.index(3), Enginio::IdRole).toString(), ids[1]);
+
+    // Objects which were never in the model are added once they match
+    QJsonObject matching = pending;
+    matching["id"] = ignored->data()["id"].toString();
+    _client.update(matching);
+    QTRY_COMPARE(insertedSpy.count(), 3);
+    QCOMPARE(model.rowCount(), 5);
+    QCOMPARE(model.data(model.index(4), Enginio::IdRole).toString(), matching["id"].toString());
+    QCOMPARE(removedSpy.count(), 1);
+
+    // An update which does not make an unknown object match is ignored
+    QJsonObject completedLater = completed;
+    completedLater["title"] = QStringLiteral("still completed");
+    const EnginioReply *other = _client.create(completed);
+    QTRY_VERIFY(other->isFinished());
+    completedLater["id"] = other->data()["id"].toString();
+    const EnginioReply *stillCompleted = _client.update(completedLater);
+    QTRY_VERIFY(stillCompleted->isFinished());
+    changed["title"] = QStringLiteral("last");
+    _client.update(changed);
+    QTRY_COMPARE(model.data(model.index(3), Enginio::JsonObjectRole).toJsonValue().toObject()["title"].toString(), QStringLiteral("last"));
+    QCOMPARE(model.rowCount(), 5);
+    QCOMPARE(insertedSpy.count(), 3);
+}
+
+void tst_EnginioModelSync::cellCache()
+{
+    QStringList ids;
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::fromLatin1("todo %1").arg(i);
+        ids.append(_backend.insertObject(QStringLiteral("objects.todos"), todo)["id"].toString());
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object());
+    QTRY_COMPARE(model.rowCount(), 3);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+    const int titleRole = model.roleNames().key("title");
+    QCOMPARE(model.data(model.index(1), titleRole).toString(), QStringLiteral("todo 1"));
+    const QJsonValue object = model.data(model.index(1), Enginio::JsonObjectRole).toJsonValue();
+    QCOMPARE(model.data(model.index(1), Enginio::JsonObjectRole).toJsonValue(), object);
+
+    // Cached cells are dropped when the row changes
+    QJsonObject changed;
+    changed["objectType"] = QStringLiteral("objects.todos");
+    changed["id"] = ids[1];
+    changed["title"] = QStringLiteral("changed");
+    _client.update(changed);
+    QTRY_COMPARE(model.data(model.index(1), titleRole).toString(), QStringLiteral("changed"));
+    QVERIFY(model.data(model.index(1), Enginio::JsonObjectRole).toJsonValue() != object);
+
+    // or when the rows move
+    QJsonObject removed;
+    removed["objectType"] = QStringLiteral("objects.todos");
+    removed["id"] = ids[0];
+    _client.remove(removed);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QCOMPARE(model.data(model.index(0), titleRole).toString(), QStringLiteral("changed"));
+    QCOMPARE(model.data(model.index(1), titleRole).toString(), QStringLiteral("todo 2"));
+}
+
+void tst_EnginioModelSync::roleIndex()
+{
+    QStringList ids;
+    for (int i = 0; i < 6; ++i) {
+        QJsonObject product;
+        product["sku"] = QString::fromLatin1("sku-%1").arg(i % 3);
+        ids.append(_backend.insertObject(QStringLiteral("objects.products"), product)["id"].toString());
+    }
+
+    EnginioModel model;
+    model.setClient(&_client);
+    model.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.products\"}").object());
+    QTRY_COMPARE(model.rowCount(), 6);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+    const int skuRole = model.roleNames().key("sku");
+
+    // Without an index the rows are scanned
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-1")), QList<int>() << 1 << 4);
+    model.createRoleIndex(skuRole);
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-1")), QList<int>() << 1 << 4);
+    QCOMPARE(model.indexOf(skuRole, QStringLiteral("sku-2")), 2);
+    QCOMPARE(model.indexOf(skuRole, QStringLiteral("sku-9")), -1);
+    QCOMPARE(model.indexOf(skuRole, 1), -1);
+
+    // The index follows changes of other clients
+    QJsonObject product;
+    product["objectType"] = QStringLiteral("objects.products");
+    product["sku"] = QStringLiteral("sku-9");
+    _client.create(product);
+    QTRY_COMPARE(model.rowCount(), 7);
+    QCOMPARE(model.indexOf(skuRole, QStringLiteral("sku-9")), 6);
+
+    QJsonObject changed;
+    changed["objectType"] = QStringLiteral("objects.products");
+    changed["id"] = ids[1];
+    changed["sku"] = QStringLiteral("sku-2");
+    _client.update(changed);
+    QTRY_COMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-2")), QList<int>() << 1 << 2 << 5);
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-1")), QList<int>() << 4);
+
+    QJsonObject removed;
+    removed["objectType"] = QStringLiteral("objects.products");
+    removed["id"] = ids[0];
+    _client.remove(removed);
+    QTRY_COMPARE(model.rowCount(), 6);
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-2")), QList<int>() << 0 << 1 << 4);
+    QCOMPARE(model.indexOf(skuRole, QStringLiteral("sku-0")), 2);
+    QCOMPARE(model.indexOf(skuRole, QStringLiteral("sku-9")), 5);
+
+    // Appended rows are found before the backend created them, with or
+    // without an index
+    EnginioModel scanned;
+    scanned.setClient(&_client);
+    scanned.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.products\", \"limit\": 100}").object());
+    QTRY_COMPARE(scanned.rowCount(), 6);
+    const int scannedSkuRole = scanned.roleNames().key("sku");
+    _backend.setLatency(200);
+    QJsonObject appended;
+    appended["sku"] = QStringLiteral("sku-0");
+    const EnginioReply *created = scanned.append(appended);
+    const EnginioReply *indexed = model.append(appended);
+    QCOMPARE(scanned.rowCount(), 7);
+    QCOMPARE(model.rowCount(), 7);
+    QCOMPARE(scanned.rowsMatching(scannedSkuRole, QStringLiteral("sku-0")), QList<int>() << 2 << 6);
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-0")), QList<int>() << 2 << 6);
+    scanned.createRoleIndex(scannedSkuRole);
+    QCOMPARE(scanned.rowsMatching(scannedSkuRole, QStringLiteral("sku-0")), QList<int>() << 2 << 6);
+
+    // and keep their row once it was, each model also gets the object of the other
+    QTRY_VERIFY(created->isFinished() && indexed->isFinished());
+    QVERIFY(!created->isError());
+    QVERIFY(!indexed->isError());
+    QTRY_COMPARE(scanned.rowCount(), 8);
+    QTRY_COMPARE(model.rowCount(), 8);
+    QCOMPARE(scanned.rowsMatching(scannedSkuRole, QStringLiteral("sku-0")), QList<int>() << 2 << 6 << 7);
+    QCOMPARE(model.rowsMatching(skuRole, QStringLiteral("sku-0")), QList<int>() << 2 << 6 << 7);
+    QCOMPARE(model.data(model.index(6), Enginio::IdRole).toString(), indexed->data()["id"].toString());
+}
+
+static QVariantList aggregateRow(const EnginioAggregateModel &model, int row)
+{
+    const QModelIndex index = model.index(row);
+    return QVariantList() << model.data(index, EnginioAggregateModel::GroupRole).toJsonValue().toString()
+                          << model.data(index, EnginioAggregateModel::CountRole)
+                          << model.data(index, EnginioAggregateModel::SumRole)
+                          << model.data(index, EnginioAggregateModel::MinimumRole)
+                          << model.data(index, EnginioAggregateModel::MaximumRole);
+}
+
+void tst_EnginioModelSync::aggregateModel()
+{
+    QStringList ids;
+    const int totals[] = { 10, 20, 30, 40 };
+    for (int i = 0; i < 4; ++i) {
+        QJsonObject order;
+        order["customer"] = QString::fromLatin1(i % 2 ? "bob" : "alice");
+        order["total"] = totals[i];
+        ids.append(_backend.insertObject(QStringLiteral("objects.orders"), order)["id"].toString());
+    }
+
+    EnginioModel orders;
+    EnginioAggregateModel aggregate;
+    aggregate.setGroupRole(QStringLiteral("customer"));
+    aggregate.setValueRole(QStringLiteral("total"));
+    aggregate.setSourceModel(&orders);
+    QCOMPARE(aggregate.rowCount(), 0);
+
+    orders.setClient(&_client);
+    orders.setQuery(QJsonDocument::fromJson("{\"objectType\": \"objects.orders\"}").object());
+    QTRY_COMPARE(aggregate.rowCount(), 2);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+    QCOMPARE(aggregateRow(aggregate, 0), QVariantList() << "alice" << 2 << 40.0 << 10.0 << 30.0);
+    QCOMPARE(aggregateRow(aggregate, 1), QVariantList() << "bob" << 2 << 60.0 << 20.0 << 40.0);
+
+    QSignalSpy resetSpy(&aggregate, SIGNAL(modelReset()));
+    QSignalSpy changedSpy(&aggregate, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // A new group
+    QJsonObject order;
+    order["objectType"] = QStringLiteral("objects.orders");
+    order["customer"] = QStringLiteral("carol");
+    order["total"] = 5;
+    _client.create(order);
+    QTRY_COMPARE(aggregate.rowCount(), 3);
+    QCOMPARE(aggregateRow(aggregate, 2), QVariantList() << "carol" << 1 << 5.0 << 5.0 << 5.0);
+
+    // An order moves to another customer, the total of another one changes
+    QJsonObject changed;
+    changed["objectType"] = QStringLiteral("objects.orders");
+    changed["id"] = ids[0];
+    changed["customer"] = QStringLiteral("bob");
+    _client.update(changed);
+    changed["id"] = ids[3];
+    changed["total"] = 15;
+    _client.update(changed);
+    QTRY_COMPARE(aggregateRow(aggregate, 1), QVariantList() << "bob" << 3 << 45.0 << 10.0 << 20.0);
+    QCOMPARE(aggregateRow(aggregate, 0), QVariantList() << "alice" << 1 << 30.0 << 30.0 << 30.0);
+
+    // An empty group is removed
+    QJsonObject removed;
+    removed["objectType"] = QStringLiteral("objects.orders");
+    removed["id"] = ids[2];
+    _client.remove(removed);
+    QTRY_COMPARE(aggregate.rowCount(), 2);
+    QCOMPARE(aggregateRow(aggregate, 0), QVariantList() << "bob" << 3 << 45.0 << 10.0 << 20.0);
+    QCOMPARE(aggregateRow(aggregate, 1), QVariantList() << "carol" << 1 << 5.0 << 5.0 << 5.0);
+
+    // Only the affected groups changed, nothing was recomputed
+    QCOMPARE(resetSpy.count(), 0);
+    QVERIFY(changedSpy.count() <= 4);
+}
+
+void tst_EnginioModelSync::sharedModels()
+{
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::fromLatin1("todo %1").arg(i);
+        _backend.insertObject(QStringLiteral("objects.todos"), todo);
+    }
+    const QJsonObject query = QJsonDocument::fromJson("{\"objectType\": \"objects.todos\"}").object();
+
+    EnginioModel *first = new EnginioModel;
+    first->setClient(&_client);
+    first->setQuery(query);
+    QTRY_COMPARE(first->rowCount(), 3);
+    QTRY_COMPARE(_backend.webSocketCount(), 1);
+
+    // A model with the same query shows the rows without querying again
+    const int requests = _backend.requestCount();
+    EnginioModel second;
+    second.setClient(&_client);
+    second.setQuery(query);
+    QCOMPARE(second.rowCount(), 3);
+    QCOMPARE(second.roleNames(), first->roleNames());
+    QCOMPARE(second.data(second.index(1), Enginio::IdRole), first->data(first->index(1), Enginio::IdRole));
+    QTest::qWait(100);
+    QCOMPARE(_backend.requestCount(), requests);
+
+    // Changes reach both models, whichever model or client makes them
+    QSignalSpy insertedSpy(&second, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removedSpy(&second, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QJsonObject todo;
+    todo["objectType"] = QStringLiteral("objects.todos");
+    todo["title"] = QStringLiteral("new");
+    _client.create(todo);
+    QTRY_COMPARE(second.rowCount(), 4);
+    QCOMPARE(first->rowCount(), 4);
+    QCOMPARE(insertedSpy.count(), 1);
+
+    const EnginioReply *removed = second.remove(0);
+    QTRY_VERIFY(removed->isFinished());
+    QVERIFY(!removed->isError());
+    QTRY_COMPARE(first->rowCount(), 3);
+    QCOMPARE(second.rowCount(), 3);
+    QCOMPARE(removedSpy.count(), 1);
+
+    // The rows are handed over when the first model is deleted, a change
+    // which did not finish yet is caught up with by a reload.
+    QSignalSpy resetSpy(&second, SIGNAL(modelReset()));
+    _backend.setLatency(300);
+    const int handover = _backend.requestCount();
+    second.setData(0, QStringLiteral("changed"), QStringLiteral("title"));
+    QTRY_COMPARE(_backend.requestCount(), handover + 1);
+    QVERIFY(!second.data(second.index(0), Enginio::SyncedRole).toBool());
+    delete first;
+    _backend.setLatency(0);
+    QCOMPARE(second.rowCount(), 3);
+    QTRY_VERIFY(second.data(second.index(0), Enginio::SyncedRole).toBool());
+    QTRY_COMPARE(_backend.requestCount(), handover + 2);
+    const int titleRole = second.roleNames().key("title");
+    QTRY_COMPARE(second.data(second.index(0), titleRole).toString(), QStringLiteral("changed"));
+    _client.create(todo);
+    QTRY_COMPARE(second.rowCount(), 4);
+    QCOMPARE(resetSpy.count(), 0);
+
+    // A row appended through a follower which the backend did not create
+    // yet stays when the owner is deleted and gets the id of the object.
+    _backend.insertObject(QStringLiteral("objects.notes"), QJsonObject());
+    const QJsonObject notes = QJsonDocument::fromJson("{\"objectType\": \"objects.notes\"}").object();
+    EnginioModel *owner = new EnginioModel;
+    owner->setClient(&_client);
+    owner->setQuery(notes);
+    QTRY_COMPARE(owner->rowCount(), 1);
+    EnginioModel follower;
+    follower.setClient(&_client);
+    follower.setQuery(notes);
+    QCOMPARE(follower.rowCount(), 1);
+
+    _backend.setLatency(300);
+    const int appending = _backend.requestCount();
+    QJsonObject note;
+    note["title"] = QStringLiteral("appended");
+    const EnginioReply *created = follower.append(note);
+    QTRY_COMPARE(_backend.requestCount(), appending + 1);
+    QCOMPARE(follower.rowCount(), 2);
+    delete owner;
+    _backend.setLatency(0);
+    QCOMPARE(follower.rowCount(), 2);
+    QVERIFY(!follower.data(follower.index(1), Enginio::SyncedRole).toBool());
+
+    QTRY_VERIFY(created->isFinished());
+    QVERIFY(!created->isError());
+    QTRY_VERIFY(follower.data(follower.index(1), Enginio::SyncedRole).toBool());
+    const QJsonArray objects = _backend.objects(QStringLiteral("objects.notes"));
+    QCOMPARE(objects.count(), 2);
+    QCOMPARE(follower.rowCount(), 2);
+    QCOMPARE(follower.data(follower.index(1), Enginio::IdRole).toString(), objects[1].toObject()["id"].toString());
+}
+
+QTEST_MAIN(tst_EnginioModelSync)
+#include "tst_enginiomodelsync.moc"
@@ -0,0 +1,12 @@
+QT       += testlib network enginio enginio-private
+QT       -= gui
+
+TARGET = tst_mockbackend
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+include(../common/mockbackend.pri)
+
+SOURCES += tst_mockbackend.cpp
@@ -0,0 +1,317 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qtemporaryfile.h>
+#include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtNetwork/qnetworkreply.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/enginiooauth2authentication.h>
+#include <Enginio/private/enginiobackendconnection_p.h>
+#include <Enginio/private/enginionotification_p.h>
+
+#include "mockbackend.h"
+
+struct NotificationCollector
+{
+    QList<EnginioNotification> *notifications;
+    void operator ()(const EnginioNotification &notification)
+    {
+        notifications->append(notification);
+    }
+};
+
+class tst_MockBackend: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockBackend _backend;
+    EnginioClient _client;
+
+private slots:
+    void initTestCase();
+    void init();
+    void crud();
+    void query();
+    void usergroupMembers();
+    void uploadAndDownload();
+    void authentication();
+    void notifications();
+    void latency();
+    void bandwidth();
+};
+
+void tst_MockBackend::initTestCase()
+{
+    QVERIFY(_backend.start());
+    _client.setBackendId(EnginioTests::MockBackend::backendId());
+    _client.setServiceUrl(_backend.serviceUrl());
+}
+
+void tst_MockBackend::init()
+{
+    _backend.clear();
+    _backend.setLatency(0);
+    _backend.setBandwidth(0);
+}
+
+void tst_MockBackend::crud()
+{
+    QJsonObject todo;
+    todo["objectType"] = QStringLiteral("objects.todos");
+    todo["title"] = QStringLiteral("Buy milk");
+    const EnginioReply *created = _client.create(todo);
+    QTRY_VERIFY(created->isFinished());
+    QVERIFY(!created->isError());
+    const QString id = created->data()["id"].toString();
+    QVERIFY(!id.isEmpty());
+    QCOMPARE(created->data()["title"].toString(), QStringLiteral("Buy milk"));
+    QCOMPARE(created->data()["createdAt"], created->data()["updatedAt"]);
+
+    QJsonObject change;
+    change["objectType"] = QStringLiteral("objects.todos");
+    change["id"] = id;
+    change["completed"] = true;
+    const EnginioReply *updated = _client.update(change);
+    QTRY_VERIFY(updated->isFinished());
+    QVERIFY(!updated->isError());
+    QCOMPARE(updated->data()["title"].toString(), QStringLiteral("Buy milk"));
+    QCOMPARE(updated->data()["completed"].toBool(), true);
+    QVERIFY(updated->data()["updatedAt"].toString() > created->data()["updatedAt"].toString());
+
+    const EnginioReply *removed = _client.remove(change);
+    QTRY_VERIFY(removed->isFinished());
+    QVERIFY(!removed->isError());
+    QVERIFY(_backend.objects(QStringLiteral("objects.todos")).isEmpty());
+
+    const EnginioReply *missing = _client.remove(change);
+    QTRY_VERIFY(missing->isFinished());
+    QVERIFY(missing->isError());
+    QCOMPARE(missing->backendStatus(), 404);
+}
+
+void tst_MockBackend::query()
+{
+    for (int i = 0; i < 10; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::fromLatin1("todo %1").arg(i);
+        todo["priority"] = i % 3;
+        _backend.insertObject(QStringLiteral("objects.todos"), todo);
+    }
+
+    QJsonObject query = QJsonDocument::fromJson(
+                "{\"objectType\": \"objects.todos\","
+                " \"query\": {\"priority\": {\"$gt\": 0}},"
+                " \"sort\": [{\"sortBy\": \"priority\", \"direction\": \"desc\"}, {\"sortBy\": \"title\", \"direction\": \"asc\"}],"
+                " \"limit\": 4, \"offset\": 1, \"count\": 1}").object();
+    const EnginioReply *reply = _client.query(query);
+    QTRY_VERIFY(reply->isFinished());
+    QVERIFY(!reply->isError());
+    const QJsonArray results = reply->data()["results"].toArray();
+    QCOMPARE(reply->data()["count"].toInt(), 6);
+    QCOMPARE(results.count(), 4);
+    // priority 2: todo 2, 5, 8; priority 1: todo 1, 4, 7
+    QCOMPARE(results[0].toObject()["title"].toString(), QStringLiteral("todo 5"));
+    QCOMPARE(results[2].toObject()["title"].toString(), QStringLiteral("todo 1"));
+    QCOMPARE(results[3].toObject()["title"].toString(), QStringLiteral("todo 4"));
+
+    QJsonObject search = QJsonDocument::fromJson(
+                "{\"objectTypes\": [\"objects.todos\"],"
+                " \"search\": {\"phrase\": \"*DO 7*\"}}").object();
+    const EnginioReply *found = _client.fullTextSearch(search);
+    QTRY_VERIFY(found->isFinished());
+    QVERIFY(!found->isError());
+    QCOMPARE(found->data()["results"].toArray().count(), 1);
+}
+
+void tst_MockBackend::usergroupMembers()
+{
+    const QString userId = _backend.insertObject(QStringLiteral("users"), QJsonObject())["id"].toString();
+    const QString groupId = _backend.insertObject(QStringLiteral("usergroups"), QJsonObject())["id"].toString();
+
+    QJsonObject member;
+    member["id"] = userId;
+    member["objectType"] = QStringLiteral("users");
+    QJsonObject request;
+    request["id"] = groupId;
+    request["member"] = member;
+    const EnginioReply *added = _client.create(request, Enginio::UsergroupMembersOperation);
+    QTRY_VERIFY(added->isFinished());
+    QVERIFY(!added->isError());
+
+    const EnginioReply *members = _client.query(request, Enginio::UsergroupMembersOperation);
+    QTRY_VERIFY(members->isFinished());
+    QVERIFY(!members->isError());
+    QCOMPARE(members->data()["results"].toArray().count(), 1);
+    QCOMPARE(members->data()["results"].toArray()[0].toObject()["id"].toString(), userId);
+}
+
+void tst_MockBackend::uploadAndDownload()
+{
+    QJsonObject object;
+    object["objectType"] = QStringLiteral("objects.images");
+    const QString objectId = _backend.insertObject(QStringLiteral("objects.images"), object)["id"].toString();
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const QByteArray content = QByteArray("not really a png").repeated(100);
+    file.write(content);
+    file.close();
+
+    QJsonObject target;
+    target["id"] = objectId;
+    target["objectType"] = QStringLiteral("objects.images");
+    target["propertyName"] = QStringLiteral("attachment");
+    QJsonObject fileObject;
+    fileObject["fileName"] = QStringLiteral("image.png");
+    QJsonObject upload;
+    upload["targetFileProperty"] = target;
+    upload["file"] = fileObject;
+    const EnginioReply *uploaded = _client.uploadFile(upload, QUrl::fromLocalFile(file.fileName()));
+    QTRY_VERIFY(uploaded->isFinished());
+    QVERIFY(!uploaded->isError());
+    const QString fileId = uploaded->data()["id"].toString();
+    QCOMPARE(uploaded->data()["fileSize"].toInt(), content.size());
+
+    QJsonObject query = QJsonDocument::fromJson(
+                "{\"objectType\": \"objects.images\", \"include\": {\"attachment\": {}}}").object();
+    const EnginioReply *included = _client.query(query);
+    QTRY_VERIFY(included->isFinished());
+    const QJsonObject attachment = included->data()["results"].toArray()[0].toObject()["attachment"].toObject();
+    QCOMPARE(attachment["id"].toString(), fileId);
+    QCOMPARE(attachment["fileName"].toString(), QStringLiteral("image.png"));
+
+    QJsonObject download;
+    download["id"] = fileId;
+    const EnginioReply *url = _client.downloadUrl(download);
+    QTRY_VERIFY(url->isFinished());
+    QVERIFY(!url->isError());
+
+    QNetworkAccessManager manager;
+    QNetworkReply *reply = manager.get(QNetworkRequest(QUrl(url->data()["expiringUrl"].toString())));
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->readAll(), content);
+    delete reply;
+}
+
+void tst_MockBackend::authentication()
+{
+    _backend.insertUser(QStringLiteral("logintest"), QStringLiteral("secret"));
+
+    EnginioClient client;
+    client.setBackendId(EnginioTests::MockBackend::backendId());
+    client.setServiceUrl(_backend.serviceUrl());
+    EnginioOAuth2Authentication identity;
+    identity.setUser(QStringLiteral("logintest"));
+    identity.setPassword(QStringLiteral("wrong"));
+    client.setIdentity(&identity);
+    QTRY_COMPARE(client.authenticationState(), Enginio::AuthenticationFailure);
+
+    identity.setPassword(QStringLiteral("secret"));
+    QTRY_COMPARE(client.authenticationState(), Enginio::Authenticated);
+}
+
+void tst_MockBackend::notifications()
+{
+    EnginioBackendConnection connection;
+    QList<EnginioNotification> received;
+    NotificationCollector collector = { &received };
+    QObject::connect(&connection, &EnginioBackendConnection::notificationReceived, collector);
+
+    QJsonObject filter = QJsonDocument::fromJson("{\"data\": {\"objectType\": \"objects.todos\"}}").object();
+    connection.connectToBackend(&_client, filter);
+    QTRY_VERIFY(connection.isConnected());
+    QCOMPARE(_backend.webSocketCount(), 1);
+
+    QJsonObject other;
+    other["objectType"] = QStringLiteral("objects.other");
+    const EnginioReply *ignored = _client.create(other);
+    QTRY_VERIFY(ignored->isFinished());
+    QVERIFY(!ignored->isError());
+
+    QJsonObject todo;
+    todo["objectType"] = QStringLiteral("objects.todos");
+    const EnginioReply *created = _client.create(todo);
+    QTRY_VERIFY(created->isFinished());
+    QVERIFY(!created->isError());
+
+    QTRY_COMPARE(received.count(), 1);
+    QCOMPARE(received[0].event(), EnginioNotification::CreateEvent);
+    QCOMPARE(received[0].objectId(), created->data()["id"].toString());
+    QCOMPARE(received[0].requestId(), created->requestId());
+}
+
+void tst_MockBackend::latency()
+{
+    _backend.setLatency(200);
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    QElapsedTimer timer;
+    timer.start();
+    const EnginioReply *reply = _client.query(query);
+    QTRY_VERIFY(reply->isFinished());
+    QVERIFY(!reply->isError());
+    QVERIFY(timer.elapsed() >= 200);
+}
+
+void tst_MockBackend::bandwidth()
+{
+    QJsonObject todo;
+    todo["title"] = QString(1000, QLatin1Char('x'));
+    for (int i = 0; i < 50; ++i)
+        _backend.insertObject(QStringLiteral("objects.todos"), todo);
+
+    // About 50kB in total at 100kB/s
+    _backend.setBandwidth(100 * 1024);
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    QElapsedTimer timer;
+    timer.start();
+    const EnginioReply *reply = _client.query(query);
+    QTRY_VERIFY(reply->isFinished());
+    QVERIFY(!reply->isError());
+    QCOMPARE(reply->data()["results"].toArray().count(), 50);
+    QVERIFY(timer.elapsed() >= 400);
+}
+
+QTEST_MAIN(tst_MockBackend)
+#include "tst_mockbackend.moc"
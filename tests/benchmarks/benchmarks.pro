@@ -0,0 +1,13 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    clientrequests \
+    modelthroughput \
+    notificationcompression \
+    notificationdecoding \
+    objectproperties \
+    startup
+
+qtHaveModule(qml) {
+    SUBDIRS += qmljsonconversion
+}
@@ -0,0 +1,340 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qtemporaryfile.h>
+#include <QtCore/qtimer.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/private/enginioclient_p.h>
+#include <Enginio/private/enginioreply_p.h>
+
+#include "benchmarkresults.h"
+#include "mockbackend.h"
+
+using EnginioTests::BenchmarkResults;
+
+// Requests issued at once, the way a model or a sync loop would do it.
+static const int RequestsPerBatch = 100;
+static const int UploadSize = 8 * 1024 * 1024;
+
+class tst_bench_ClientRequests: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockBackend _backend;
+    EnginioClient _client;
+    QEventLoop _loop;
+    QTimer _timeout;
+    QList<EnginioReply*> _replies;
+    int _expected;
+    int _errors;
+
+public:
+    enum Operation {
+        Create,
+        Update,
+        Remove,
+        Query
+    };
+
+    void replyFinished(EnginioReply *reply);
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void cleanupTestCase();
+    void issue_data();
+    void issue();
+    void decode_data();
+    void decode();
+    void upload_data();
+    void upload();
+
+private:
+    bool waitForReplies(int count);
+    void clearReplies();
+};
+
+Q_DECLARE_METATYPE(tst_bench_ClientRequests::Operation)
+
+struct FinishedFunctor
+{
+    tst_bench_ClientRequests *_test;
+    void operator ()(EnginioReply *reply)
+    {
+        _test->replyFinished(reply);
+    }
+};
+
+static QJsonObject todo(int i)
+{
+    QJsonObject object;
+    object[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+    object[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(i);
+    object[QStringLiteral("completed")] = bool(i % 2);
+    object[QStringLiteral("priority")] = i % 5;
+    return object;
+}
+
+void tst_bench_ClientRequests::replyFinished(EnginioReply *reply)
+{
+    _replies.append(reply);
+    _errors += reply->isError();
+    if (_replies.count() >= _expected)
+        _loop.quit();
+}
+
+bool tst_bench_ClientRequests::waitForReplies(int count)
+{
+    _expected = count;
+    if (_replies.count() < count) {
+        _timeout.start();
+        _loop.exec();
+        _timeout.stop();
+    }
+    return _replies.count() >= count;
+}
+
+void tst_bench_ClientRequests::clearReplies()
+{
+    qDeleteAll(_replies);
+    _replies.clear();
+    _errors = 0;
+}
+
+void tst_bench_ClientRequests::initTestCase()
+{
+    QVERIFY(_backend.start());
+    _client.setBackendId(EnginioTests::MockBackend::backendId());
+    _client.setServiceUrl(_backend.serviceUrl());
+    FinishedFunctor finished = { this };
+    QObject::connect(&_client, &EnginioClient::finished, finished);
+
+    _timeout.setSingleShot(true);
+    _timeout.setInterval(30000);
+    QObject::connect(&_timeout, &QTimer::timeout, &_loop, &QEventLoop::quit);
+    _expected = 0;
+    _errors = 0;
+}
+
+void tst_bench_ClientRequests::init()
+{
+    _backend.clear();
+    clearReplies();
+}
+
+void tst_bench_ClientRequests::cleanup()
+{
+    clearReplies();
+}
+
+void tst_bench_ClientRequests::cleanupTestCase()
+{
+    QVERIFY(BenchmarkResults::write());
+}
+
+void tst_bench_ClientRequests::issue_data()
+{
+    QTest::addColumn<Operation>("operation");
+    QTest::newRow("create") << Create;
+    QTest::newRow("update") << Update;
+    QTest::newRow("remove") << Remove;
+    QTest::newRow("query") << Query;
+}
+
+void tst_bench_ClientRequests::issue()
+{
+    // The backend answers in the same thread, the figures include
+    // its share, but not the network latency of a real deployment.
+    QFETCH(Operation, operation);
+
+    for (int i = 0; i < RequestsPerBatch; ++i)
+        _backend.insertObject(QStringLiteral("objects.todos"), todo(i));
+    QJsonObject query;
+    query[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+
+    qint64 nsecs = 0;
+    int requests = 0;
+    QBENCHMARK {
+        // Every batch removes or updates objects of its own.
+        QList<QString> ids;
+        if (operation == Update || operation == Remove) {
+            for (int i = 0; i < RequestsPerBatch; ++i)
+                ids.append(_backend.insertObject(QStringLiteral("objects.todos"), todo(i))[QStringLiteral("id")].toString());
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < RequestsPerBatch; ++i) {
+            switch (operation) {
+            case Create:
+                _client.create(todo(i));
+                break;
+            case Update: {
+                QJsonObject change;
+                change[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+                change[QStringLiteral("id")] = ids[i];
+                change[QStringLiteral("completed")] = true;
+                _client.update(change);
+                break;
+            }
+            case Remove: {
+                QJsonObject object;
+                object[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+                object[QStringLiteral("id")] = ids[i];
+                _client.remove(object);
+                break;
+            }
+            case Query:
+                _client.query(query);
+                break;
+            }
+        }
+        QVERIFY(waitForReplies(RequestsPerBatch));
+        nsecs += timer.nsecsElapsed();
+        requests += RequestsPerBatch;
+        QCOMPARE(_errors, 0);
+        clearReplies();
+    }
+
+    BenchmarkResults::record(QStringLiteral("rate"), requests * 1e9 / nsecs, QStringLiteral("requests/s"));
+}
+
+void tst_bench_ClientRequests::decode_data()
+{
+    QTest::addColumn<int>("objects");
+    QTest::newRow("1 object") << 1;
+    QTest::newRow("10 objects") << 10;
+    QTest::newRow("100 objects") << 100;
+    QTest::newRow("1000 objects") << 1000;
+    QTest::newRow("10000 objects") << 10000;
+}
+
+void tst_bench_ClientRequests::decode()
+{
+    QFETCH(int, objects);
+
+    for (int i = 0; i < objects; ++i)
+        _backend.insertObject(QStringLiteral("objects.todos"), todo(i));
+    QJsonObject query;
+    query[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+    query[QStringLiteral("limit")] = objects;
+    _client.query(query);
+    QVERIFY(waitForReplies(1));
+    QCOMPARE(_errors, 0);
+
+    // Only the parsing done by EnginioReply::data(), the payload was
+    // already read from the network reply.
+    EnginioReplyStatePrivate *reply = EnginioReplyStatePrivate::get(_replies.first());
+    const qint64 bytes = reply->pData().size();
+    QCOMPARE(reply->data()[QStringLiteral("results")].toArray().count(), objects);
+
+    qint64 nsecs = 0;
+    int iterations = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        reply->_jsonDataParsed = false;
+        const QJsonObject data = reply->data();
+        Q_UNUSED(data);
+        nsecs += timer.nsecsElapsed();
+        ++iterations;
+    }
+
+    BenchmarkResults::record(QStringLiteral("payload"), bytes, QStringLiteral("bytes"));
+    BenchmarkResults::record(QStringLiteral("throughput"), bytes * iterations * 1e9 / nsecs / (1024 * 1024), QStringLiteral("MB/s"));
+}
+
+void tst_bench_ClientRequests::upload_data()
+{
+    QTest::addColumn<int>("chunkSize");
+    QTest::newRow("64 KB chunks") << 64 * 1024;
+    QTest::newRow("512 KB chunks") << 512 * 1024;
+    QTest::newRow("2 MB chunks") << 2 * 1024 * 1024;
+}
+
+void tst_bench_ClientRequests::upload()
+{
+    QFETCH(int, chunkSize);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const QByteArray block = QByteArray("0123456789abcdef").repeated(4096);
+    while (file.size() < UploadSize)
+        file.write(block);
+    file.close();
+
+    QJsonObject object;
+    object[QStringLiteral("objectType")] = QStringLiteral("objects.images");
+    QJsonObject target;
+    target[QStringLiteral("id")] = _backend.insertObject(QStringLiteral("objects.images"), object)[QStringLiteral("id")];
+    target[QStringLiteral("objectType")] = QStringLiteral("objects.images");
+    target[QStringLiteral("propertyName")] = QStringLiteral("attachment");
+    QJsonObject fileObject;
+    fileObject[QStringLiteral("fileName")] = QStringLiteral("image.png");
+    QJsonObject upload;
+    upload[QStringLiteral("targetFileProperty")] = target;
+    upload[QStringLiteral("file")] = fileObject;
+
+    EnginioClientConnectionPrivate *clientPrivate = EnginioClientConnectionPrivate::get(&_client);
+    const qint64 defaultChunkSize = clientPrivate->_uploadChunkSize;
+    clientPrivate->_uploadChunkSize = chunkSize;
+
+    qint64 nsecs = 0;
+    qint64 bytes = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        _client.uploadFile(upload, QUrl::fromLocalFile(file.fileName()));
+        QVERIFY(waitForReplies(1));
+        nsecs += timer.nsecsElapsed();
+        bytes += UploadSize;
+        QCOMPARE(_errors, 0);
+        clearReplies();
+    }
+    clientPrivate->_uploadChunkSize = defaultChunkSize;
+
+    BenchmarkResults::record(QStringLiteral("throughput"), bytes * 1e9 / nsecs / (1024 * 1024), QStringLiteral("MB/s"));
+}
+
+QTEST_MAIN(tst_bench_ClientRequests)
+#include "tst_bench_clientrequests.moc"
@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "benchmarkresults.h"
+
+#include <QtTest/qtestcase.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+
+namespace EnginioTests {
+
+Q_GLOBAL_STATIC(QJsonArray, recordedResults)
+
+void BenchmarkResults::record(const QString &metric, double value, const QString &unit)
+{
+    QJsonObject result;
+    result[QStringLiteral("function")] = QString::fromLatin1(QTest::currentTestFunction());
+    result[QStringLiteral("tag")] = QString::fromLatin1(QTest::currentDataTag());
+    result[QStringLiteral("metric")] = metric;
+    result[QStringLiteral("value")] = value;
+    result[QStringLiteral("unit")] = unit;
+    recordedResults()->append(result);
+
+    qDebug("%s: %.2f %s", qPrintable(metric), value, qPrintable(unit));
+}
+
+bool BenchmarkResults::write()
+{
+    const QByteArray directory = qgetenv("ENGINIO_BENCHMARK_RESULTS");
+    if (directory.isEmpty())
+        return true;
+
+    const QString name = QCoreApplication::applicationName();
+    QJsonObject document;
+    document[QStringLiteral("benchmark")] = name;
+    document[QStringLiteral("qtVersion")] = QString::fromLatin1(qVersion());
+    document[QStringLiteral("timestamp")] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    document[QStringLiteral("results")] = *recordedResults();
+
+    QFile file(QDir(QString::fromLocal8Bit(directory)).filePath(name + QStringLiteral(".json")));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "BenchmarkResults::write(): can not open" << file.fileName() << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(document).toJson());
+    return true;
+}
+
+}
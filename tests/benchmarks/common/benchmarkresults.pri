@@ -0,0 +1,3 @@
+INCLUDEPATH += $$PWD
+SOURCES += $$PWD/benchmarkresults.cpp
+HEADERS += $$PWD/benchmarkresults.h
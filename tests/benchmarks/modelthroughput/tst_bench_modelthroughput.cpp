@@ -0,0 +1,511 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/private/qobject_p.h>
+
+#include <Enginio/enginioaggregatemodel.h>
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginiomodel.h>
+#include <Enginio/enginiopreparedquery.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/private/enginiobasemodel_p.h>
+#include <Enginio/private/enginionotification_p.h>
+#include <Enginio/private/enginiostring_p.h>
+
+#include "benchmarkresults.h"
+#include "mockbackend.h"
+
+using EnginioTests::BenchmarkResults;
+
+static const int NotificationsPerBatch = 1000;
+static const int RemovalsPerBatch = 100;
+static const int PageSize = 100;
+// Rows of a reloaded result which differ from the rows in the model,
+// e.g. after a login made a few more objects visible.
+static const int ReloadChanges = 5;
+// Rows of a list view on screen and the number of layouts they go through,
+// e.g. while the list is flicked back and forth.
+static const int VisibleRows = 20;
+static const int LayoutPasses = 50;
+static const int LookupsPerBatch = 100;
+
+class tst_bench_ModelThroughput: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockBackend _backend;
+    EnginioClient _client;
+
+public:
+    enum Event {
+        Create,
+        Update,
+        Delete
+    };
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void fullQueryReset_data();
+    void fullQueryReset();
+    void fetchMore_data();
+    void fetchMore();
+    void notifications_data();
+    void notifications();
+    void rowRemoval_data();
+    void rowRemoval();
+    void reload_data();
+    void reload();
+    void delegateReads();
+    void lookup_data();
+    void lookup();
+    void aggregateUpdates_data();
+    void aggregateUpdates();
+};
+
+Q_DECLARE_METATYPE(tst_bench_ModelThroughput::Event)
+
+static QJsonObject todo(int i, const QString &updatedAt = QStringLiteral("2015-09-03T10:32:13.458Z"))
+{
+    QJsonObject object;
+    object[QStringLiteral("id")] = QString::fromLatin1("5406e6c1e5bde5%1").arg(i, 10, 10, QLatin1Char('0'));
+    object[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+    object[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(i);
+    object[QStringLiteral("completed")] = bool(i % 2);
+    object[QStringLiteral("priority")] = i % 5;
+    object[QStringLiteral("createdAt")] = QStringLiteral("2015-09-03T10:31:13.458Z");
+    object[QStringLiteral("updatedAt")] = updatedAt;
+    return object;
+}
+
+static QJsonArray todos(int count)
+{
+    QJsonArray array;
+    for (int i = 0; i < count; ++i)
+        array.append(todo(i));
+    return array;
+}
+
+// Counts the rows for which a view creates delegates, all rows on a reset.
+struct DelegateCounter
+{
+    EnginioModel *model;
+    qint64 *created;
+    void operator ()(const QModelIndex &, int first, int last)
+    {
+        *created += last - first + 1;
+    }
+    void operator ()()
+    {
+        *created += model->rowCount();
+    }
+};
+
+static EnginioBaseModelPrivate *modelPrivate(EnginioModel *model)
+{
+    return static_cast<EnginioBaseModelPrivate*>(QObjectPrivate::get(model));
+}
+
+void tst_bench_ModelThroughput::initTestCase()
+{
+    QVERIFY(_backend.start());
+    _client.setBackendId(EnginioTests::MockBackend::backendId());
+    _client.setServiceUrl(_backend.serviceUrl());
+}
+
+void tst_bench_ModelThroughput::cleanupTestCase()
+{
+    QVERIFY(BenchmarkResults::write());
+}
+
+void tst_bench_ModelThroughput::fullQueryReset_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("100 rows") << 100;
+    QTest::newRow("1000 rows") << 1000;
+    QTest::newRow("10000 rows") << 10000;
+}
+
+void tst_bench_ModelThroughput::fullQueryReset()
+{
+    QFETCH(int, rows);
+    const QJsonArray data = todos(rows);
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+
+    qint64 nsecs = 0;
+    int resets = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        d->fullQueryReset(data);
+        nsecs += timer.nsecsElapsed();
+        ++resets;
+    }
+    QCOMPARE(model.rowCount(), rows);
+
+    BenchmarkResults::record(QStringLiteral("rate"), qint64(rows) * resets * 1e9 / nsecs, QStringLiteral("rows/s"));
+}
+
+void tst_bench_ModelThroughput::fetchMore_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("1000 rows") << 1000;
+    QTest::newRow("5000 rows") << 5000;
+}
+
+void tst_bench_ModelThroughput::fetchMore()
+{
+    // Paging is not enabled in the models yet, so EnginioModel::canFetchMore()
+    // is always false. This issues the requests fetchMore() would send, page
+    // by page, and hands the replies to the model the same way.
+    QFETCH(int, rows);
+    _backend.clear();
+    for (int i = 0; i < rows; ++i) {
+        QJsonObject object = todo(i);
+        object.remove(QStringLiteral("id"));
+        _backend.insertObject(QStringLiteral("objects.todos"), object);
+    }
+
+    QJsonObject query;
+    query[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+    const EnginioPreparedQuery prepared = _client.prepareQuery(query);
+
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+
+    qint64 nsecs = 0;
+    qint64 fetched = 0;
+    QBENCHMARK {
+        d->fullQueryReset(QJsonArray());
+        QElapsedTimer timer;
+        timer.start();
+        for (int offset = 0; offset < rows; offset += PageSize) {
+            EnginioReply *reply = _client.query(prepared, offset, PageSize);
+            QSignalSpy spy(reply, SIGNAL(finished(EnginioReply*)));
+            QVERIFY(spy.wait());
+            QVERIFY(!reply->isError());
+            QJsonObject page;
+            page[EnginioString::offset] = offset;
+            page[EnginioString::limit] = PageSize;
+            d->finishedIncrementalUpdateRequest(reply, page);
+            delete reply;
+        }
+        nsecs += timer.nsecsElapsed();
+        fetched += rows;
+        QCOMPARE(model.rowCount(), rows);
+    }
+
+    BenchmarkResults::record(QStringLiteral("rate"), fetched * 1e9 / nsecs, QStringLiteral("rows/s"));
+}
+
+void tst_bench_ModelThroughput::notifications_data()
+{
+    QTest::addColumn<Event>("event");
+    QTest::newRow("create") << Create;
+    QTest::newRow("update") << Update;
+    QTest::newRow("delete") << Delete;
+}
+
+void tst_bench_ModelThroughput::notifications()
+{
+    QFETCH(Event, event);
+
+    // The model starts with the objects which are updated or deleted,
+    // created objects are new to it.
+    const int firstCreated = NotificationsPerBatch;
+    const QJsonArray data = todos(NotificationsPerBatch);
+    QList<EnginioNotification> messages;
+    for (int i = 0; i < NotificationsPerBatch; ++i) {
+        QJsonObject message;
+        QJsonObject origin;
+        origin[QStringLiteral("apiRequestId")] = QString::fromLatin1("%1").arg(i * 2654435761u, 32, 16, QLatin1Char('0'));
+        message[QStringLiteral("messageType")] = QStringLiteral("data");
+        message[QStringLiteral("origin")] = origin;
+        switch (event) {
+        case Create:
+            message[QStringLiteral("event")] = QStringLiteral("create");
+            message[QStringLiteral("data")] = todo(firstCreated + i);
+            break;
+        case Update:
+            message[QStringLiteral("event")] = QStringLiteral("update");
+            message[QStringLiteral("data")] = todo(i, QStringLiteral("2015-09-03T10:33:13.458Z"));
+            break;
+        case Delete:
+            message[QStringLiteral("event")] = QStringLiteral("delete");
+            message[QStringLiteral("data")] = todo(i);
+            break;
+        }
+        messages.append(EnginioNotification::fromJson(QJsonDocument(message).toJson(QJsonDocument::Compact)));
+    }
+
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+
+    qint64 nsecs = 0;
+    qint64 applied = 0;
+    QBENCHMARK {
+        d->fullQueryReset(data);
+        QElapsedTimer timer;
+        timer.start();
+        foreach (const EnginioNotification &notification, messages)
+            d->receivedNotification(notification);
+        nsecs += timer.nsecsElapsed();
+        applied += messages.count();
+    }
+    QCOMPARE(model.rowCount(), event == Create ? 2 * NotificationsPerBatch : event == Update ? NotificationsPerBatch : 0);
+
+    BenchmarkResults::record(QStringLiteral("rate"), applied * 1e9 / nsecs, QStringLiteral("notifications/s"));
+}
+
+void tst_bench_ModelThroughput::rowRemoval_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("1000 rows") << 1000;
+    QTest::newRow("10000 rows") << 10000;
+    QTest::newRow("50000 rows") << 50000;
+}
+
+void tst_bench_ModelThroughput::rowRemoval()
+{
+    // AttachedDataContainer renumbers the rows after every removal, so the
+    // cost of removing a single row grows with the size of the model.
+    QFETCH(int, rows);
+    const QJsonArray data = todos(rows);
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+
+    qint64 nsecs = 0;
+    qint64 removed = 0;
+    QBENCHMARK {
+        d->fullQueryReset(data);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < RemovalsPerBatch; ++i)
+            d->receivedRemoveNotification(QJsonObject(), 0);
+        nsecs += timer.nsecsElapsed();
+        removed += RemovalsPerBatch;
+    }
+    QCOMPARE(model.rowCount(), rows - RemovalsPerBatch);
+
+    BenchmarkResults::record(QStringLiteral("removal"), nsecs / 1000.0 / removed, QStringLiteral("us/row"));
+}
+
+void tst_bench_ModelThroughput::reload_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("diff");
+    QTest::newRow("1000 rows, reset") << 1000 << false;
+    QTest::newRow("1000 rows, diff") << 1000 << true;
+    QTest::newRow("10000 rows, reset") << 10000 << false;
+    QTest::newRow("10000 rows, diff") << 10000 << true;
+    QTest::newRow("50000 rows, reset") << 50000 << false;
+    QTest::newRow("50000 rows, diff") << 50000 << true;
+}
+
+void tst_bench_ModelThroughput::reload()
+{
+    // The result of a query executed again, e.g. after a login: a few rows
+    // are gone, a few are new, moved or changed.
+    QFETCH(int, rows);
+    QFETCH(bool, diff);
+    const QJsonArray data = todos(rows);
+    QJsonArray reloaded = data;
+    for (int i = 0; i < ReloadChanges; ++i) {
+        const int step = rows / ReloadChanges;
+        reloaded.removeAt(i * step + 1);
+        reloaded.insert(i * step + 2, todo(rows + i));
+        const QJsonValue moved = reloaded.at(i * step + 3);
+        reloaded.removeAt(i * step + 3);
+        reloaded.insert(i * step + step / 2, moved);
+        reloaded[i * step + 4] = todo(i * step + 4, QStringLiteral("2015-09-03T10:33:13.458Z"));
+    }
+
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+    qint64 created = 0;
+    DelegateCounter counter = { &model, &created };
+    QObject::connect(&model, &EnginioModel::rowsInserted, counter);
+    QObject::connect(&model, &EnginioModel::modelReset, counter);
+
+    qint64 nsecs = 0;
+    int reloads = 0;
+    qint64 recreated = 0;
+    QBENCHMARK {
+        d->fullQueryReset(data);
+        created = 0;
+        QElapsedTimer timer;
+        timer.start();
+        if (diff) {
+            d->updateFromQueryResult(reloaded);
+            QTRY_VERIFY(!d->isDiffPending());
+        } else {
+            d->fullQueryReset(reloaded);
+        }
+        nsecs += timer.nsecsElapsed();
+        recreated += created;
+        ++reloads;
+    }
+    QCOMPARE(model.rowCount(), reloaded.count());
+    for (int row = 0; row < reloaded.count(); row += rows / 100)
+        QCOMPARE(model.data(model.index(row), Enginio::JsonObjectRole).toJsonValue(), reloaded.at(row));
+
+    BenchmarkResults::record(QStringLiteral("reload"), nsecs / 1e6 / reloads, QStringLiteral("ms"));
+    BenchmarkResults::record(QStringLiteral("delegates"), double(recreated) / reloads, QStringLiteral("rows"));
+}
+
+void tst_bench_ModelThroughput::delegateReads()
+{
+    // Every delegate reads its roles again when it is laid out.
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+    d->fullQueryReset(todos(1000));
+    const QHash<int, QByteArray> roleNames = model.roleNames();
+    QVector<int> roles;
+    roles << roleNames.key("title") << roleNames.key("completed") << roleNames.key("priority") << Enginio::JsonObjectRole;
+
+    qint64 nsecs = 0;
+    qint64 reads = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        for (int pass = 0; pass < LayoutPasses; ++pass) {
+            for (int row = 0; row < VisibleRows; ++row) {
+                const QModelIndex index = model.index(row);
+                foreach (int role, roles)
+                    reads += model.data(index, role).isValid();
+            }
+        }
+        nsecs += timer.nsecsElapsed();
+    }
+    QVERIFY(reads);
+
+    BenchmarkResults::record(QStringLiteral("rate"), reads * 1e9 / nsecs, QStringLiteral("reads/s"));
+}
+
+void tst_bench_ModelThroughput::lookup_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("index");
+    QTest::newRow("1000 rows, scan") << 1000 << false;
+    QTest::newRow("1000 rows, index") << 1000 << true;
+    QTest::newRow("10000 rows, scan") << 10000 << false;
+    QTest::newRow("10000 rows, index") << 10000 << true;
+}
+
+void tst_bench_ModelThroughput::lookup()
+{
+    // Finding the row of an object by a property other than its id,
+    // e.g. to select it in a view.
+    QFETCH(int, rows);
+    QFETCH(bool, index);
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+    d->fullQueryReset(todos(rows));
+    const int titleRole = model.roleNames().key("title");
+    if (index)
+        model.createRoleIndex(titleRole);
+
+    QStringList titles;
+    for (int i = 0; i < LookupsPerBatch; ++i)
+        titles.append(QString::fromLatin1("Buy milk (%1)").arg((i * 7919) % rows));
+
+    qint64 nsecs = 0;
+    qint64 found = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        foreach (const QString &title, titles)
+            found += model.indexOf(titleRole, title) >= 0;
+        nsecs += timer.nsecsElapsed();
+    }
+    QCOMPARE(found % LookupsPerBatch, 0);
+    QCOMPARE(model.indexOf(titleRole, titles.last()), (LookupsPerBatch - 1) * 7919 % rows);
+
+    BenchmarkResults::record(QStringLiteral("lookup"), nsecs / 1000.0 / found, QStringLiteral("us"));
+}
+
+void tst_bench_ModelThroughput::aggregateUpdates_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("1000 rows") << 1000;
+    QTest::newRow("10000 rows") << 10000;
+    QTest::newRow("50000 rows") << 50000;
+}
+
+void tst_bench_ModelThroughput::aggregateUpdates()
+{
+    // Update notifications for a model with per-group totals on top, the
+    // cost of an update should not depend on the number of rows.
+    QFETCH(int, rows);
+    EnginioModel model;
+    EnginioBaseModelPrivate *d = modelPrivate(&model);
+    EnginioAggregateModel aggregate;
+    aggregate.setGroupRole(QStringLiteral("completed"));
+    aggregate.setValueRole(QStringLiteral("priority"));
+    aggregate.setSourceModel(&model);
+
+    QList<QJsonObject> updates;
+    for (int i = 0; i < NotificationsPerBatch; ++i) {
+        QJsonObject object = todo(i * (rows / NotificationsPerBatch), QStringLiteral("2015-09-03T10:33:13.458Z"));
+        object[QStringLiteral("priority")] = 10 + i % 7;
+        updates.append(object);
+    }
+
+    qint64 nsecs = 0;
+    qint64 applied = 0;
+    QBENCHMARK {
+        d->fullQueryReset(todos(rows));
+        QElapsedTimer timer;
+        timer.start();
+        foreach (const QJsonObject &object, updates)
+            d->receivedUpdateNotification(object);
+        nsecs += timer.nsecsElapsed();
+        applied += updates.count();
+    }
+    QCOMPARE(aggregate.rowCount(), 2);
+    QCOMPARE(aggregate.data(aggregate.index(0), EnginioAggregateModel::CountRole).toInt()
+             + aggregate.data(aggregate.index(1), EnginioAggregateModel::CountRole).toInt(), rows);
+
+    BenchmarkResults::record(QStringLiteral("rate"), applied * 1e9 / nsecs, QStringLiteral("notifications/s"));
+}
+
+QTEST_MAIN(tst_bench_ModelThroughput)
+#include "tst_bench_modelthroughput.moc"
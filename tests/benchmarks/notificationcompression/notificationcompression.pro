@@ -0,0 +1,21 @@
+QT       += testlib network enginio enginio-private
+QT       -= gui
+
+TARGET = tst_bench_notificationcompression
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+# The stand-in server compresses the messages itself.
+contains(QT_CONFIG, system-zlib) {
+    if(unix|mingw): LIBS += -lz
+    else: LIBS += zdll.lib
+} else {
+    git_build: \
+        INCLUDEPATH += $$[QT_INSTALL_HEADERS/get]/QtZlib
+    else: \
+        INCLUDEPATH += $$[QT_INSTALL_HEADERS/src]/QtZlib
+}
+
+SOURCES += tst_bench_notificationcompression.cpp
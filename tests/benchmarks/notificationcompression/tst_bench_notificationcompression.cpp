@@ -0,0 +1,246 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/QtEndian>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <Enginio/private/enginiobackendconnection_p.h>
+
+#include <zlib.h>
+
+static const int MessagesPerBatch = 1000;
+
+class tst_bench_NotificationCompression: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void receive_data();
+    void receive();
+};
+
+/*
+    Minimal WebSocket endpoint which answers the opening handshake and then
+    sends a prepared batch of update notifications on request. With
+    compression enabled the batch is deflated once as one sliding window
+    context, so it can be replayed as long as the client keeps its context.
+*/
+class WebSocketStandIn: public QTcpServer
+{
+    Q_OBJECT
+
+    bool _compressionAllowed;
+    bool _compressionNegotiated;
+    QTcpSocket *_client;
+    QByteArray _request;
+    QByteArray _batch;
+    int _payloadSize;
+
+public:
+    WebSocketStandIn(bool compressionAllowed)
+        : _compressionAllowed(compressionAllowed)
+        , _compressionNegotiated(false)
+        , _client(0)
+        , _payloadSize(0)
+    {
+        connect(this, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+    }
+
+    bool isCompressionNegotiated() const { return _compressionNegotiated; }
+    int payloadSize() const { return _payloadSize; }
+    int wireSize() const { return _batch.size(); }
+
+    void sendBatch()
+    {
+        _client->write(_batch);
+    }
+
+private slots:
+    void onNewConnection()
+    {
+        _client = nextPendingConnection();
+        connect(_client, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    }
+
+    void onReadyRead()
+    {
+        _request.append(_client->readAll());
+        if (!_request.contains("\r\n\r\n"))
+            return;
+
+        QByteArray key;
+        foreach (const QByteArray &line, _request.split('\n')) {
+            if (line.toLower().startsWith("sec-websocket-key:"))
+                key = line.mid(line.indexOf(':') + 1).trimmed();
+        }
+        const QByteArray accept = QCryptographicHash::hash(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", QCryptographicHash::Sha1).toBase64();
+
+        _compressionNegotiated = _compressionAllowed && _request.contains("permessage-deflate");
+        prepareBatch();
+
+        QByteArray response("HTTP/1.1 101 Switching Protocols\r\n"
+                            "Upgrade: websocket\r\n"
+                            "Connection: Upgrade\r\n"
+                            "Sec-WebSocket-Accept: ");
+        response.append(accept);
+        response.append("\r\n");
+        if (_compressionNegotiated)
+            response.append("Sec-WebSocket-Extensions: permessage-deflate\r\n");
+        response.append("\r\n");
+        _client->write(response);
+        _request.clear();
+    }
+
+private:
+    static QByteArray notification(int index)
+    {
+        QJsonObject data;
+        data[QStringLiteral("id")] = QString::fromLatin1("5406e6c1e5bde5%1").arg(index, 10, 10, QLatin1Char('0'));
+        data[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+        data[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(index * 7);
+        data[QStringLiteral("completed")] = bool(index % 2);
+        data[QStringLiteral("createdAt")] = QStringLiteral("2015-09-03T10:31:13.458Z");
+        data[QStringLiteral("updatedAt")] = QString::fromLatin1("2015-09-03T10:%1:13.458Z").arg(index % 60, 2, 10, QLatin1Char('0'));
+        QJsonObject origin;
+        origin[QStringLiteral("apiRequestId")] = QString::fromLatin1("%1").arg(index * 2654435761u, 32, 16, QLatin1Char('0'));
+        QJsonObject message;
+        message[QStringLiteral("event")] = QStringLiteral("update");
+        message[QStringLiteral("data")] = data;
+        message[QStringLiteral("origin")] = origin;
+        return QJsonDocument(message).toJson(QJsonDocument::Compact);
+    }
+
+    static QByteArray frame(const QByteArray &payload, bool compressed)
+    {
+        QByteArray header;
+        header.append(char(0x80 | 0x01 | (compressed ? 0x40 : 0x00)));
+        if (payload.size() < 126) {
+            header.append(char(payload.size()));
+        } else if (payload.size() <= 0xFFFF) {
+            header.append(char(126));
+            header.append(char(payload.size() >> 8));
+            header.append(char(payload.size() & 0xFF));
+        } else {
+            header.append(char(127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+                header.append(char((quint64(payload.size()) >> shift) & 0xFF));
+        }
+        return header + payload;
+    }
+
+    void prepareBatch()
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (_compressionNegotiated)
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+        _batch.clear();
+        _payloadSize = 0;
+        for (int i = 0; i < MessagesPerBatch; ++i) {
+            QByteArray payload = notification(i);
+            _payloadSize += payload.size();
+            if (_compressionNegotiated) {
+                QByteArray compressed(deflateBound(&stream, payload.size()) + 16, Qt::Uninitialized);
+                stream.next_in = reinterpret_cast<Bytef *>(payload.data());
+                stream.avail_in = payload.size();
+                stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+                stream.avail_out = compressed.size();
+                deflate(&stream, Z_SYNC_FLUSH);
+                compressed.resize(compressed.size() - stream.avail_out);
+                Q_ASSERT(compressed.endsWith(QByteArray("\x00\x00\xff\xff", 4)));
+                compressed.chop(4);
+                payload = compressed;
+            }
+            _batch.append(frame(payload, _compressionNegotiated));
+        }
+
+        if (_compressionNegotiated)
+            deflateEnd(&stream);
+    }
+};
+
+struct MessageCounter
+{
+    int *received;
+
+    void operator ()(QJsonObject)
+    {
+        if (++*received == MessagesPerBatch)
+            QTestEventLoop::instance().exitLoop();
+    }
+};
+
+void tst_bench_NotificationCompression::receive_data()
+{
+    QTest::addColumn<bool>("compression");
+
+    QTest::newRow("uncompressed") << false;
+    QTest::newRow("permessage-deflate") << true;
+}
+
+void tst_bench_NotificationCompression::receive()
+{
+    QFETCH(bool, compression);
+
+    WebSocketStandIn server(compression);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    int received = 0;
+    EnginioBackendConnection connection;
+    connection.setCompressionEnabled(compression);
+    MessageCounter counter = { &received };
+    QObject::connect(&connection, &EnginioBackendConnection::dataReceived, counter);
+    connection.connectToSocketUrl(QUrl(QString::fromLatin1("ws://127.0.0.1:%1/stream").arg(server.serverPort())));
+    QTRY_VERIFY(connection.isConnected());
+    QCOMPARE(server.isCompressionNegotiated(), compression);
+
+    QBENCHMARK {
+        received = 0;
+        server.sendBatch();
+        QTestEventLoop::instance().enterLoop(30);
+        QVERIFY(!QTestEventLoop::instance().timeout());
+    }
+
+    qDebug("%d messages: %d bytes of JSON, %d bytes on the wire",
+           MessagesPerBatch, server.payloadSize(), server.wireSize());
+}
+
+QTEST_MAIN(tst_bench_NotificationCompression)
+#include "tst_bench_notificationcompression.moc"
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+
+#include <Enginio/private/enginionotification_p.h>
+#include <Enginio/private/enginioquerymatcher_p.h>
+
+static const int MessagesPerBatch = 1000;
+
+class tst_bench_NotificationDecoding: public QObject
+{
+    Q_OBJECT
+
+    QList<QByteArray> _messages;
+    EnginioQueryMatcher _matcher;
+
+public:
+    enum Decoder {
+        JsonDocument,
+        Scan,
+        ScanAndData,
+        ScanDataAndQuery
+    };
+
+private slots:
+    void initTestCase();
+    void decode_data();
+    void decode();
+};
+
+Q_DECLARE_METATYPE(tst_bench_NotificationDecoding::Decoder)
+
+void tst_bench_NotificationDecoding::initTestCase()
+{
+    for (int i = 0; i < MessagesPerBatch; ++i) {
+        QJsonObject data;
+        data[QStringLiteral("id")] = QString::fromLatin1("5406e6c1e5bde5%1").arg(i, 10, 10, QLatin1Char('0'));
+        data[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+        data[QStringLiteral("title")] = QString::fromLatin1("Buy \"milk\" (%1)").arg(i * 7);
+        data[QStringLiteral("completed")] = bool(i % 2);
+        data[QStringLiteral("createdAt")] = QStringLiteral("2015-09-03T10:31:13.458Z");
+        data[QStringLiteral("updatedAt")] = QStringLiteral("2015-09-03T10:32:13.458Z");
+        QJsonObject origin;
+        origin[QStringLiteral("apiRequestId")] = QString::fromLatin1("%1").arg(i * 2654435761u, 32, 16, QLatin1Char('0'));
+        QJsonObject message;
+        message[QStringLiteral("event")] = QStringLiteral("update");
+        message[QStringLiteral("data")] = data;
+        message[QStringLiteral("origin")] = origin;
+        _messages.append(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    }
+
+    // A model filter every message passes, so that all conditions are evaluated
+    _matcher = EnginioQueryMatcher::compile(QJsonDocument::fromJson(
+            "{\"completed\": {\"$in\": [true, false]},"
+            " \"title\": {\"$regex\": \"milk\", \"$options\": \"i\"},"
+            " \"$or\": [{\"updatedAt\": {\"$gt\": \"2015-01-01\"}}, {\"createdAt\": {\"$exists\": false}}]}").object());
+    QVERIFY(_matcher.isValid());
+}
+
+void tst_bench_NotificationDecoding::decode_data()
+{
+    QTest::addColumn<Decoder>("decoder");
+
+    // Routing a message needs its event, objectType and request id, echoes
+    // of own requests and messages without a subscriber stop there.
+    QTest::newRow("QJsonDocument") << JsonDocument;
+    QTest::newRow("scan") << Scan;
+    QTest::newRow("scan + data") << ScanAndData;
+    // What a model with a "query" filter does for creates and updates
+    QTest::newRow("scan + data + query") << ScanDataAndQuery;
+}
+
+static int decodeBatch(const QList<QByteArray> &messages, tst_bench_NotificationDecoding::Decoder decoder, const EnginioQueryMatcher &matcher)
+{
+    int routed = 0;
+    foreach (const QByteArray &message, messages) {
+        switch (decoder) {
+        case tst_bench_NotificationDecoding::JsonDocument: {
+            // What the connection and the model used to do for every frame.
+            QJsonObject object = QJsonDocument::fromJson(message).object();
+            object[QStringLiteral("messageType")] = QStringLiteral("data");
+            const QString requestId = object[QStringLiteral("origin")].toObject()[QStringLiteral("apiRequestId")].toString();
+            const QJsonObject data = object[QStringLiteral("data")].toObject();
+            const QString event = object[QStringLiteral("event")].toString();
+            routed += !requestId.isEmpty() && !event.isEmpty() && !data[QStringLiteral("objectType")].toString().isEmpty();
+            break;
+        }
+        case tst_bench_NotificationDecoding::Scan: {
+            const EnginioNotification notification = EnginioNotification::fromJson(message);
+            routed += !notification.requestId().isEmpty() && notification.event() != EnginioNotification::UnknownEvent && !notification.objectType().isEmpty();
+            break;
+        }
+        case tst_bench_NotificationDecoding::ScanAndData: {
+            const EnginioNotification notification = EnginioNotification::fromJson(message);
+            routed += !notification.requestId().isEmpty() && !notification.data().isEmpty();
+            break;
+        }
+        case tst_bench_NotificationDecoding::ScanDataAndQuery: {
+            const EnginioNotification notification = EnginioNotification::fromJson(message);
+            routed += !notification.requestId().isEmpty() && matcher.matches(notification.data());
+            break;
+        }
+        }
+    }
+    return routed;
+}
+
+void tst_bench_NotificationDecoding::decode()
+{
+    QFETCH(Decoder, decoder);
+
+    QCOMPARE(decodeBatch(_messages, decoder, _matcher), MessagesPerBatch);
+
+    QBENCHMARK {
+        decodeBatch(_messages, decoder, _matcher);
+    }
+
+    // Throughput of a single thread, for comparison with the incoming message rate.
+    QElapsedTimer timer;
+    timer.start();
+    int batches = 0;
+    do {
+        decodeBatch(_messages, decoder, _matcher);
+        ++batches;
+    } while (timer.elapsed() < 500);
+    qDebug("%.0f notifications/s", batches * MessagesPerBatch * 1000.0 / timer.elapsed());
+}
+
+QTEST_MAIN(tst_bench_NotificationDecoding)
+#include "tst_bench_notificationdecoding.moc"
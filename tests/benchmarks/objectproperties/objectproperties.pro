@@ -0,0 +1,10 @@
+QT       += testlib enginio enginio-private
+QT       -= gui
+
+TARGET = tst_bench_objectproperties
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += tst_bench_objectproperties.cpp
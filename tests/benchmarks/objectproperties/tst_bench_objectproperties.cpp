@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+
+#include <Enginio/private/enginioobjectproperties_p.h>
+#include <Enginio/private/enginiostring_p.h>
+
+static const int ObjectCount = 10000;
+
+class tst_bench_ObjectProperties: public QObject
+{
+    Q_OBJECT
+
+    QJsonArray _objects;
+
+public:
+    enum Lookup {
+        Subscript,
+        Accessor
+    };
+
+private slots:
+    void initTestCase();
+    void lookup_data();
+    void lookup();
+};
+
+Q_DECLARE_METATYPE(tst_bench_ObjectProperties::Lookup)
+
+void tst_bench_ObjectProperties::initTestCase()
+{
+    // Objects which were appended to the model but not synced yet,
+    // have no updatedAt.
+    for (int i = 0; i < ObjectCount; ++i) {
+        QJsonObject object;
+        object[QStringLiteral("id")] = QString::fromLatin1("5406e6c1e5bde5%1").arg(i, 10, 10, QLatin1Char('0'));
+        object[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+        object[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(i);
+        object[QStringLiteral("completed")] = bool(i % 2);
+        object[QStringLiteral("createdAt")] = QStringLiteral("2015-09-03T10:31:13.458Z");
+        if (i % 2)
+            object[QStringLiteral("updatedAt")] = QStringLiteral("2015-09-03T10:32:13.458Z");
+        _objects.append(object);
+    }
+}
+
+void tst_bench_ObjectProperties::lookup_data()
+{
+    QTest::addColumn<Lookup>("lookup");
+    QTest::addColumn<QString>("key");
+
+    QTest::newRow("id, operator[]") << Subscript << EnginioString::id;
+    QTest::newRow("id, accessor") << Accessor << EnginioString::id;
+    QTest::newRow("updatedAt, operator[]") << Subscript << EnginioString::updatedAt;
+    QTest::newRow("updatedAt, accessor") << Accessor << EnginioString::updatedAt;
+}
+
+void tst_bench_ObjectProperties::lookup()
+{
+    QFETCH(Lookup, lookup);
+    QFETCH(QString, key);
+
+    // The way the models used to read the properties of every row,
+    // against the const accessors.
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (int i = 0; i < ObjectCount; ++i) {
+            QString value;
+            if (lookup == Subscript) {
+                value = _objects[i].toObject()[key].toString();
+            } else if (key == EnginioString::id) {
+                value = EnginioObjectProperties::objectId(_objects.at(i).toObject());
+            } else {
+                value = EnginioObjectProperties::updatedAt(_objects.at(i).toObject());
+            }
+            found += !value.isEmpty();
+        }
+    }
+    QCOMPARE(found, key == EnginioString::id ? ObjectCount : ObjectCount / 2);
+}
+
+QTEST_MAIN(tst_bench_ObjectProperties)
+#include "tst_bench_objectproperties.moc"
@@ -0,0 +1,18 @@
+QT       += testlib qml enginio enginio-private
+QT       -= gui
+
+TARGET = tst_bench_qmljsonconversion
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+include(../common/benchmarkresults.pri)
+
+TEMPLATE = app
+
+# The converter is part of the QML plugin, which does not export it.
+ENGINIO_PLUGIN_DIR = $$PWD/../../../src/enginio_plugin
+INCLUDEPATH += $$ENGINIO_PLUGIN_DIR
+SOURCES += \
+    $$ENGINIO_PLUGIN_DIR/enginioqmljsonconverter.cpp \
+    tst_bench_qmljsonconversion.cpp
+HEADERS += $$ENGINIO_PLUGIN_DIR/enginioqmljsonconverter_p.h
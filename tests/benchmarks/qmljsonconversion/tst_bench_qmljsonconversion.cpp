@@ -0,0 +1,176 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtQml/qjsengine.h>
+#include <QtQml/qjsvalue.h>
+
+#include "benchmarkresults.h"
+#include "enginioqmljsonconverter_p.h"
+
+using EnginioTests::BenchmarkResults;
+
+static const int Rows = 10000;
+
+class tst_bench_QmlJsonConversion: public QObject
+{
+    Q_OBJECT
+
+    QJSEngine _engine;
+    QJSValue _stringify;
+    QJSValue _parse;
+    QByteArray _replyJson;
+
+public:
+    enum Method {
+        JsonText,
+        Native
+    };
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void replyToModel_data();
+    void replyToModel();
+    void modelToQml_data();
+    void modelToQml();
+};
+
+Q_DECLARE_METATYPE(tst_bench_QmlJsonConversion::Method)
+
+void tst_bench_QmlJsonConversion::initTestCase()
+{
+    _stringify = _engine.evaluate(QStringLiteral("JSON.stringify"));
+    _parse = _engine.evaluate(QStringLiteral("JSON.parse"));
+    QVERIFY(_stringify.isCallable());
+    QVERIFY(_parse.isCallable());
+
+    // A full query result of a model with 10k rows.
+    QJsonArray results;
+    for (int i = 0; i < Rows; ++i) {
+        QJsonObject object;
+        object[QStringLiteral("id")] = QString::fromLatin1("5406e6c1e5bde5%1").arg(i, 10, 10, QLatin1Char('0'));
+        object[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+        object[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(i);
+        object[QStringLiteral("completed")] = bool(i % 2);
+        object[QStringLiteral("priority")] = i % 5;
+        object[QStringLiteral("tags")] = QJsonArray() << QStringLiteral("home") << QStringLiteral("shopping");
+        object[QStringLiteral("createdAt")] = QStringLiteral("2015-09-03T10:31:13.458Z");
+        object[QStringLiteral("updatedAt")] = QStringLiteral("2015-09-03T10:32:13.458Z");
+        results.append(object);
+    }
+    QJsonObject reply;
+    reply[QStringLiteral("results")] = results;
+    _replyJson = QJsonDocument(reply).toJson(QJsonDocument::Compact);
+
+    // Both ways have to produce the same result.
+    const QJSValue data = _parse.call(QJSValueList() << QJSValue(QString::fromUtf8(_replyJson)));
+    QCOMPARE(EnginioQmlJsonConverter::toJsonObject(data), reply);
+    const QJSValue converted = EnginioQmlJsonConverter::toJSValue(&_engine, reply);
+    QCOMPARE(_stringify.call(QJSValueList() << converted).toString().toUtf8(), _replyJson);
+}
+
+void tst_bench_QmlJsonConversion::cleanupTestCase()
+{
+    QVERIFY(BenchmarkResults::write());
+}
+
+void tst_bench_QmlJsonConversion::replyToModel_data()
+{
+    QTest::addColumn<Method>("method");
+    QTest::newRow("JSON.stringify") << JsonText;
+    QTest::newRow("native") << Native;
+}
+
+void tst_bench_QmlJsonConversion::replyToModel()
+{
+    // EnginioQmlReply::data() is parsed by JSON.parse, the model then
+    // needs the result as QJsonObject.
+    QFETCH(Method, method);
+    const QJSValue data = _parse.call(QJSValueList() << QJSValue(QString::fromUtf8(_replyJson)));
+
+    QJsonObject object;
+    qint64 nsecs = 0;
+    int conversions = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        if (method == JsonText)
+            object = QJsonDocument::fromJson(_stringify.call(QJSValueList() << data).toString().toUtf8()).object();
+        else
+            object = EnginioQmlJsonConverter::toJsonObject(data);
+        nsecs += timer.nsecsElapsed();
+        ++conversions;
+    }
+    QCOMPARE(object[QStringLiteral("results")].toArray().count(), Rows);
+
+    BenchmarkResults::record(QStringLiteral("rate"), qint64(Rows) * conversions * 1e9 / nsecs, QStringLiteral("rows/s"));
+}
+
+void tst_bench_QmlJsonConversion::modelToQml_data()
+{
+    QTest::addColumn<Method>("method");
+    QTest::newRow("JSON.parse") << JsonText;
+    QTest::newRow("native") << Native;
+}
+
+void tst_bench_QmlJsonConversion::modelToQml()
+{
+    QFETCH(Method, method);
+    const QJsonObject reply = QJsonDocument::fromJson(_replyJson).object();
+
+    QJSValue value;
+    qint64 nsecs = 0;
+    int conversions = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        if (method == JsonText)
+            value = _parse.call(QJSValueList() << QJSValue(QString::fromUtf8(QJsonDocument(reply).toJson(QJsonDocument::Compact))));
+        else
+            value = EnginioQmlJsonConverter::toJSValue(&_engine, reply);
+        nsecs += timer.nsecsElapsed();
+        ++conversions;
+    }
+    QCOMPARE(value.property(QStringLiteral("results")).property(QStringLiteral("length")).toInt(), Rows);
+
+    BenchmarkResults::record(QStringLiteral("rate"), qint64(Rows) * conversions * 1e9 / nsecs, QStringLiteral("rows/s"));
+}
+
+QTEST_MAIN(tst_bench_QmlJsonConversion)
+#include "tst_bench_qmljsonconversion.moc"
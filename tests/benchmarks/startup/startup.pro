@@ -0,0 +1,13 @@
+QT       += testlib network enginio enginio-private core-private
+QT       -= gui
+
+TARGET = tst_bench_startup
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+include(../common/benchmarkresults.pri)
+include(../../auto/common/mockbackend.pri)
+
+TEMPLATE = app
+
+SOURCES += tst_bench_startup.cpp
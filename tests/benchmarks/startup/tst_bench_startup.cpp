@@ -0,0 +1,133 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qtimer.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/private/enginioclient_p.h>
+
+#include "benchmarkresults.h"
+#include "mockbackend.h"
+
+using EnginioTests::BenchmarkResults;
+
+// What a new connection costs before it can carry a request, roughly
+// a TCP and a full TLS handshake to a distant data center.
+static const int HandshakeLatency = 150;
+// The time an application spends loading its UI after creating the client.
+static const int StartupWork = 200;
+
+class tst_bench_Startup: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockBackend _backend;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void firstResult_data();
+    void firstResult();
+};
+
+void tst_bench_Startup::initTestCase()
+{
+    QVERIFY(_backend.start());
+    _backend.setHandshakeLatency(HandshakeLatency);
+    for (int i = 0; i < 20; ++i) {
+        QJsonObject object;
+        object[QStringLiteral("title")] = QString::fromLatin1("Buy milk (%1)").arg(i);
+        _backend.insertObject(QStringLiteral("objects.todos"), object);
+    }
+}
+
+void tst_bench_Startup::cleanupTestCase()
+{
+    QVERIFY(BenchmarkResults::write());
+}
+
+void tst_bench_Startup::firstResult_data()
+{
+    QTest::addColumn<int>("connections");
+    QTest::newRow("cold") << 0;
+    QTest::newRow("prewarmed") << int(EnginioClientConnectionPrivate::DefaultPrewarmedConnectionCount);
+}
+
+void tst_bench_Startup::firstResult()
+{
+    // No other client lives in this thread, every iteration starts with a
+    // new network access manager and without any open connection.
+    QFETCH(int, connections);
+
+    QJsonObject query;
+    query[QStringLiteral("objectType")] = QStringLiteral("objects.todos");
+
+    qint64 nsecs = 0;
+    int iterations = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        EnginioClient client;
+        EnginioClientConnectionPrivate::get(&client)->_prewarmedConnectionCount = connections;
+        client.setServiceUrl(_backend.serviceUrl());
+        client.setBackendId(EnginioTests::MockBackend::backendId());
+
+        QTest::qWait(StartupWork);
+
+        QEventLoop loop;
+        QTimer::singleShot(30000, &loop, SLOT(quit()));
+        EnginioReply *reply = client.query(query);
+        QObject::connect(reply, &EnginioReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        QVERIFY(reply->isFinished());
+        QVERIFY(!reply->isError());
+        QCOMPARE(reply->data()[QStringLiteral("results")].toArray().count(), 20);
+
+        nsecs += timer.nsecsElapsed();
+        ++iterations;
+    }
+
+    BenchmarkResults::record(QStringLiteral("firstResult"), nsecs / 1e6 / iterations, QStringLiteral("ms"));
+    BenchmarkResults::record(QStringLiteral("afterStartup"), nsecs / 1e6 / iterations - StartupWork, QStringLiteral("ms"));
+}
+
+QTEST_MAIN(tst_bench_Startup)
+#include "tst_bench_startup.moc"